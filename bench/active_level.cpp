@@ -0,0 +1,44 @@
+// MIT License
+//
+// Copyright (c) 2023 Salomon Lee
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+
+// Compiled once per LOGPP_ACTIVE_LEVEL by bench/CMakeLists.txt, with LOGPP_BENCH_STATEMENTS naming
+// the function of each copy.
+#include <util/logging/Log.hpp>
+
+/**
+ * A hot path as a release build sees it: mostly trace and debug statements around a little info.
+ */
+long LOGPP_BENCH_STATEMENTS(long i) {
+    LOG_TRACE << "enter " << i;
+    LOG_DEBUG << "request " << i << " state " << i % 7;
+    long v = i * 31 + 7;
+    LOG_TRACE << "hash " << v;
+    LOG_DEBUG << "lookup " << v % 1024 << " of " << 1024;
+    if (v % 1024 == 0) {
+        LOG_INFO << "bucket " << v << " rolled";
+    }
+    LOG_DEBUG << "cache " << (v & 1 ? "hit" : "miss") << " for " << i;
+    LOG_TRACE << "leave " << i << " with " << v;
+    return v;
+}
@@ -0,0 +1,82 @@
+// MIT License
+//
+// Copyright (c) 2023 Salomon Lee
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+#include "Bench.hpp"
+#include <util/fio/LogArchiver.hpp>
+#include <filesystem>
+
+/**
+ * Archiving throughput of a rolled segment per codec and level, in bytes of log text per second.
+ * Only codecs compiled into this build are registered.
+ */
+static const std::string SEGMENT = "./bench-out/compression/compress-source.log";
+static constexpr long SEGMENT_SIZE = 16 * 1024 * 1024;
+static long segmentBytes = 0;
+
+static void makeSegment(const benchmark::State &) {
+    std::filesystem::create_directories("./bench-out/compression");
+    useProperties("bench-compression", "level=verbose\npath=./bench-out/compression/\nfile=compress.log\nmaxsz=20MB\nroqty=1\n");
+    std::ofstream out(SEGMENT, std::ios::trunc);
+    long written = 0;
+    for (long i = 0; written < SEGMENT_SIZE; i++) {
+        std::string line = "INFO    | (thx-id: 140245) - 2024-03-10 06:13:20.123456 UTC (1710051200123456) - request=" +
+                           std::to_string(i) + " user=user" + std::to_string(i % 97) + " latency=" +
+                           std::to_string((i * 7919) % 100000) + "us ok=" + (i % 13 == 0 ? "0" : "1") + "\n";
+        out << line;
+        written += static_cast<long>(line.size());
+    }
+    segmentBytes = written;
+}
+
+static void removeSegments(const benchmark::State &) {
+    std::error_code ignored;
+    std::filesystem::remove_all("./bench-out/compression", ignored);
+}
+
+static void BM_Compression(benchmark::State &state) {
+    auto codec = static_cast<Codec>(state.range(0));
+    auto level = static_cast<int>(state.range(1));
+    LogArchiver *archiver = LogArchiver::instance();
+    long segment = 0;
+    for (auto _ : state) {
+        state.PauseTiming();
+        std::string file = "./bench-out/compression/compress-" + std::to_string(segment++) + ".log";
+        std::filesystem::copy_file(SEGMENT, file, std::filesystem::copy_options::overwrite_existing);
+        state.ResumeTiming();
+        archiver->submit(file, "./bench-out/compression/compress.log", 1, codec, level);
+        archiver->wait();
+    }
+    state.SetBytesProcessed(state.iterations() * segmentBytes);
+    state.SetLabel(LogArchiver::extensionOf(codec));
+}
+
+static void codecs(benchmark::internal::Benchmark *benchmark) {
+    for (Codec codec : {codec_gzip, codec_zstd, codec_lz4}) {
+        if (LogArchiver::available(codec) != codec)
+            continue;
+        for (int level : {1, -1, 9})
+            benchmark->Args({codec, level});
+    }
+}
+BENCHMARK(BM_Compression)->Apply(codecs)->Setup(makeSegment)->Teardown(removeSegments)->UseRealTime()
+        ->Unit(benchmark::kMillisecond);
@@ -0,0 +1,137 @@
+// MIT License
+//
+// Copyright (c) 2023 Salomon Lee
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+#include "Bench.hpp"
+#include <util/logging/BinaryLog.hpp>
+#include <util/logging/LogFormat.hpp>
+#include <util/LogUtil.hpp>
+
+/**
+ * All three APIs log the same statement, the binary one leaves the text to logpp-decode. The
+ * console goes to a discarding stream buffer and the files to /dev/null, so the numbers are
+ * dominated by record building and rendering.
+ */
+static NullBuffer nullBuffer;
+static std::streambuf *consoleBuffer = nullptr;
+
+static void toNullJson(const benchmark::State &) {
+    useProperties("bench-format", "level=verbose\npath=/dev/\nfile=null\njson.file=null\nmaxsz=1000000GB\n"
+                                  "roqty=2\nflush=bytes\nsinks=json\n");
+    consoleBuffer = std::cout.rdbuf(&nullBuffer);
+}
+
+static void toNullOutputs(const benchmark::State &) {
+    useProperties("bench-format", "level=verbose\npath=/dev/\nfile=null\nmaxsz=1000000GB\nroqty=2\n"
+                                  "flush=bytes\nbinary.file=null\n");
+    consoleBuffer = std::cout.rdbuf(&nullBuffer);
+}
+
+static void toNoSinks(const benchmark::State &) {
+    useProperties("bench-format", "level=verbose\nsinks=null\n");
+}
+
+static void restoreConsole(const benchmark::State &) {
+    std::cout.rdbuf(consoleBuffer);
+}
+
+static void BM_StreamInfo(benchmark::State &state) {
+    int request = 0;
+    double latency = 0.25;
+    std::string user = "alice";
+    for (auto _ : state) {
+        LOG_INFO << "request=" << ++request << " user=" << user << " latency=" << latency << " ok=" << true;
+    }
+}
+BENCHMARK(BM_StreamInfo)->Setup(toNullOutputs)->Teardown(restoreConsole);
+
+/**
+ * What the statement costs the calling thread with nothing to render to: the record with its
+ * location and message, from inside a member of a class template as in template-heavy code.
+ */
+template<class Key, class Value>
+struct Cache {
+    long lookups{0};
+
+    const Value *find(const Key &key) {
+        LOG_INFO << "lookup " << key << " #" << ++lookups;
+        return nullptr;
+    }
+};
+
+static void BM_CaptureInfo(benchmark::State &state) {
+    Cache<std::string, std::vector<long>> cache;
+    std::string key = "alice";
+    for (auto _ : state)
+        benchmark::DoNotOptimize(cache.find(key));
+}
+BENCHMARK(BM_CaptureInfo)->Setup(toNoSinks);
+
+static void BM_FormatInfo(benchmark::State &state) {
+    int request = 0;
+    double latency = 0.25;
+    std::string user = "alice";
+    for (auto _ : state) {
+        LOG_INFOF("request={} user={} latency={} ok={}", ++request, user, latency, true);
+    }
+}
+BENCHMARK(BM_FormatInfo)->Setup(toNullOutputs)->Teardown(restoreConsole);
+
+static void BM_BinaryInfo(benchmark::State &state) {
+    int request = 0;
+    double latency = 0.25;
+    std::string user = "alice";
+    for (auto _ : state) {
+        LOG_INFOB("request={} user={} latency={} ok={}", ++request, user, latency, true);
+    }
+}
+BENCHMARK(BM_BinaryInfo)->Setup(toNullOutputs)->Teardown(restoreConsole);
+
+/**
+ * The statement of BM_StreamInfo with its values as fields, rendered as JSON lines only.
+ */
+static void BM_KvJson(benchmark::State &state) {
+    int request = 0;
+    double latency = 0.25;
+    std::string user = "alice";
+    for (auto _ : state) {
+        LOG_INFO.kv("request", ++request).kv("user", user).kv("latency", latency).kv("ok", true) << "served";
+    }
+}
+BENCHMARK(BM_KvJson)->Setup(toNullJson)->Teardown(restoreConsole);
+
+/**
+ * Escaping a message of Arg bytes with one quote in every 64.
+ */
+static void BM_JsonEscape(benchmark::State &state) {
+    std::string text(state.range(0), 'm');
+    for (size_t i = 63; i < text.size(); i += 64)
+        text[i] = '"';
+    std::string out;
+    for (auto _ : state) {
+        out.clear();
+        LogUtil::appendJsonEscaped(out, text);
+        benchmark::DoNotOptimize(out.data());
+    }
+    state.SetBytesProcessed(static_cast<int64_t>(state.iterations()) * state.range(0));
+}
+BENCHMARK(BM_JsonEscape)->Arg(64)->Arg(1024)->Arg(16 * 1024);
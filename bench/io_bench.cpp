@@ -0,0 +1,69 @@
+// MIT License
+//
+// Copyright (c) 2023 Salomon Lee
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+#include "Bench.hpp"
+#include <util/fio/LogAppender.hpp>
+#include <filesystem>
+
+/**
+ * Raw appender throughput by write path, 64KB appends with flush=bytes, so every call hands one
+ * batch to write() or to the ring. Arg is the fsync cadence in ms, 0 for none. The file is
+ * truncated after every run.
+ */
+static const std::string ioFile = "./bench-out/bench-io.log";
+
+static void appendBatches(benchmark::State &state, bool uring) {
+    std::filesystem::create_directories("./bench-out");
+    LogAppender *appender = LogAppender::instance(ioFile);
+    appender->configure(1000000L * GB, 2, "./bench-out/", flush_bytes, 64 * KB, 1000, codec_none, -1);
+    appender->configureIo(uring, 8, 256 * KB, state.range(0));
+    if (uring && !UringWriter::available()) {
+        state.SkipWithError("io_uring not available");
+        return;
+    }
+    std::string line(127, '.');
+    line += '\n';
+    std::string batch;
+    while (batch.size() < 64 * KB)
+        batch += line;
+    for (auto _ : state)
+        appender->write(batch, log_info);
+    appender->flush();
+    // Back to the plain path, so the ring attaches at the truncated end on the next run.
+    appender->configureIo(false, 8, 256 * KB, 0);
+    auto bytes = static_cast<int64_t>(state.iterations()) * static_cast<int64_t>(batch.size());
+    state.SetBytesProcessed(bytes);
+    state.counters["GB_per_min"] = benchmark::Counter(static_cast<double>(bytes) * 60 / (GB), benchmark::Counter::kIsRate);
+    std::error_code ignored;
+    std::filesystem::resize_file(ioFile, 0, ignored);
+}
+
+static void BM_AppendWrite(benchmark::State &state) {
+    appendBatches(state, false);
+}
+BENCHMARK(BM_AppendWrite)->Arg(0)->Arg(10)->UseRealTime();
+
+static void BM_AppendUring(benchmark::State &state) {
+    appendBatches(state, true);
+}
+BENCHMARK(BM_AppendUring)->Arg(0)->Arg(10)->UseRealTime();
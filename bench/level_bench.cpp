@@ -0,0 +1,138 @@
+// MIT License
+//
+// Copyright (c) 2023 Salomon Lee
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+#include "Bench.hpp"
+#include <util/logging/Log.hpp>
+#include <util/logging/LogLimit.hpp>
+#include <util/logging/Logger.hpp>
+
+static void silenceDebug(const benchmark::State &) {
+    useProperties("bench-level", "level=error\npath=./\nfile=bench-level.log\nmaxsz=20MB\nroqty=2\n");
+}
+
+static void silenceDebugOutsideNet(const benchmark::State &) {
+    useProperties("bench-level", "level=error\npath=./\nfile=bench-level.log\nmaxsz=20MB\nroqty=2\nlevel.net=debug\n");
+}
+
+/**
+ * level=verbose enables every statement that was compiled in, level=error none of the bench's.
+ */
+static void enableAllFor(const benchmark::State &state) {
+    if (state.range(0) == 0)
+        silenceDebug(state);
+    else
+        useProperties("bench-level", "level=verbose\nsinks=null\n");
+}
+
+// bench/active_level.cpp built with LOGPP_ACTIVE_LEVEL trace and info.
+long statementsAtTrace(long i);
+long statementsAtInfo(long i);
+
+static long expensive(long v) {
+    benchmark::DoNotOptimize(v);
+    return v * 31 + 7;
+}
+
+static void BM_NoLogStatement(benchmark::State &state) {
+    long i = 0;
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(++i);
+    }
+}
+BENCHMARK(BM_NoLogStatement);
+
+static void BM_DisabledDebug(benchmark::State &state) {
+    long i = 0;
+    for (auto _ : state) {
+        LOG_DEBUG << "value: " << expensive(++i);
+        benchmark::DoNotOptimize(i);
+    }
+}
+BENCHMARK(BM_DisabledDebug)->Setup(silenceDebug);
+
+static void BM_DisabledDebugThreaded(benchmark::State &state) {
+    long i = 0;
+    for (auto _ : state) {
+        LOG_DEBUG << "value: " << expensive(++i);
+        benchmark::DoNotOptimize(i);
+    }
+}
+BENCHMARK(BM_DisabledDebugThreaded)->Setup(silenceDebug)->ThreadRange(1, 64)->UseRealTime();
+
+/**
+ * Debug is enabled for another module, so the statement resolves its file through the per-thread cache.
+ */
+static void BM_DisabledDebugModules(benchmark::State &state) {
+    long i = 0;
+    for (auto _ : state) {
+        LOG_DEBUG << "value: " << expensive(++i);
+        benchmark::DoNotOptimize(i);
+    }
+}
+BENCHMARK(BM_DisabledDebugModules)->Setup(silenceDebugOutsideNet)->ThreadRange(1, 8)->UseRealTime();
+
+static void BM_DisabledLoggerDebug(benchmark::State &state) {
+    static Logger *pool = Logger::get("db.pool");
+    long i = 0;
+    for (auto _ : state) {
+        LOGGER_DEBUG(pool) << "value: " << expensive(++i);
+        benchmark::DoNotOptimize(i);
+    }
+}
+BENCHMARK(BM_DisabledLoggerDebug)->Setup(silenceDebugOutsideNet)->ThreadRange(1, 8)->UseRealTime();
+
+static void BM_SuppressedEveryN(benchmark::State &state) {
+    long i = 0;
+    for (auto _ : state) {
+        LOG_EVERY_N(log_error, 1L << 40) << "value: " << expensive(++i);
+        benchmark::DoNotOptimize(i);
+    }
+}
+BENCHMARK(BM_SuppressedEveryN)->Setup(silenceDebug)->ThreadRange(1, 8)->UseRealTime();
+
+static void BM_SuppressedRate(benchmark::State &state) {
+    long i = 0;
+    for (auto _ : state) {
+        LOG_RATE(log_error, 1) << "value: " << expensive(++i);
+        benchmark::DoNotOptimize(i);
+    }
+}
+BENCHMARK(BM_SuppressedRate)->Setup(silenceDebug)->ThreadRange(1, 8)->UseRealTime();
+
+/**
+ * The same hot path with trace and debug compiled in and compiled out, for /0 disabled and /1
+ * enabled at runtime. cmake --build . --target bench_size compares the two objects.
+ */
+static void BM_ActiveLevelTrace(benchmark::State &state) {
+    long i = 0;
+    for (auto _ : state)
+        benchmark::DoNotOptimize(statementsAtTrace(++i));
+}
+BENCHMARK(BM_ActiveLevelTrace)->Setup(enableAllFor)->Arg(0)->Arg(1);
+
+static void BM_ActiveLevelInfo(benchmark::State &state) {
+    long i = 0;
+    for (auto _ : state)
+        benchmark::DoNotOptimize(statementsAtInfo(++i));
+}
+BENCHMARK(BM_ActiveLevelInfo)->Setup(enableAllFor)->Arg(0)->Arg(1);
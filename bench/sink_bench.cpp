@@ -0,0 +1,186 @@
+// MIT License
+//
+// Copyright (c) 2023 Salomon Lee
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+#include "Bench.hpp"
+#include <util/logging/LogFormat.hpp>
+#include <util/fio/LogArchiver.hpp>
+#include <util/logging/SinkRegistry.hpp>
+#include <filesystem>
+
+/**
+ * Cost of an enabled statement by destination, with per call latency percentiles. Files go to
+ * ./bench-out and are truncated after every run; the appenders keep them open for the process.
+ */
+static NullBuffer nullBuffer;
+static std::filebuf devNull;
+static std::streambuf *consoleBuffer = nullptr;
+
+static void toNull(const benchmark::State &) {
+    useProperties("bench-sink", "level=verbose\nsinks=null\n");
+    consoleBuffer = std::cout.rdbuf(&nullBuffer);
+}
+
+static void toFile(const benchmark::State &) {
+    std::filesystem::create_directories("./bench-out");
+    useProperties("bench-sink", "level=verbose\npath=./bench-out/\nfile=bench-file.log\nmaxsz=1000000GB\nroqty=2\n"
+                                "flush=bytes\n");
+    consoleBuffer = std::cout.rdbuf(&nullBuffer);
+}
+
+static void toBufferedFile(const benchmark::State &) {
+    std::filesystem::create_directories("./bench-out");
+    useProperties("bench-sink", "level=verbose\npath=./bench-out/\nfile=bench-file.log\nmaxsz=1000000GB\nroqty=2\n"
+                                "flush=bytes\nbuffered=true\n");
+    consoleBuffer = std::cout.rdbuf(&nullBuffer);
+}
+
+static void toDedupFile(const benchmark::State &) {
+    std::filesystem::create_directories("./bench-out");
+    useProperties("bench-sink", "level=verbose\npath=./bench-out/\nfile=bench-file.log\nmaxsz=1000000GB\nroqty=2\n"
+                                "flush=bytes\nsinks=file\ndedup=true\n");
+    consoleBuffer = std::cout.rdbuf(&nullBuffer);
+}
+
+static void toMappedFile(const benchmark::State &) {
+    std::filesystem::create_directories("./bench-out");
+    useProperties("bench-sink", "level=verbose\npath=./bench-out/\nfile=bench-mapped.log\nmaxsz=64MB\nroqty=2\n"
+                                "compression=none\nmmap=true\n");
+    consoleBuffer = std::cout.rdbuf(&nullBuffer);
+}
+
+static void toConsole(const benchmark::State &) {
+    useProperties("bench-sink", "level=verbose\npath=/dev/\nfile=null\nmaxsz=1000000GB\nroqty=2\nflush=bytes\n");
+    // A real stream buffer over a file descriptor, so the console path pays for its write calls.
+    if (!devNull.is_open())
+        devNull.open("/dev/null", std::ios::out);
+    consoleBuffer = std::cout.rdbuf(&devNull);
+}
+
+static void toConsoleAndFile(const benchmark::State &state) {
+    std::filesystem::create_directories("./bench-out");
+    // Arg 1: the console only takes warnings, so info statements skip the colored rendering.
+    useProperties("bench-sink", std::string("level=verbose\npath=./bench-out/\nfile=bench-file.log\nmaxsz=1000000GB\n"
+                                            "roqty=2\nflush=bytes\nsinks=console,file\n") +
+                                (state.range(0) == 1 ? "sink.console.level=warning\n" : ""));
+    consoleBuffer = std::cout.rdbuf(&nullBuffer);
+}
+
+static void toRollingFile(const benchmark::State &) {
+    std::filesystem::create_directories("./bench-out");
+    useProperties("bench-sink", "level=verbose\npath=./bench-out/\nfile=bench-roll.log\nmaxsz=1MB\nroqty=2\n"
+                                "flush=bytes\ncompression=gzip\n");
+    consoleBuffer = std::cout.rdbuf(&nullBuffer);
+}
+
+static void restore(const benchmark::State &) {
+    std::cout.flush();
+    std::cout.rdbuf(consoleBuffer);
+    SinkRegistry::instance()->flush();
+    LogAppender::flushAll();
+    std::error_code ignored;
+    std::filesystem::resize_file("./bench-out/bench-file.log", 0, ignored);
+    std::filesystem::resize_file("./bench-out/bench-roll.log", 0, ignored);
+}
+
+static void logTimed(benchmark::State &state) {
+    LatencyHistogram latency;
+    int request = 0;
+    std::string user = "alice";
+    for (auto _ : state) {
+        BENCH_TIMED(latency, LOG_INFOF("request={} user={} latency={} ok={}", ++request, user, 0.25, true));
+    }
+    latency.report(state);
+}
+
+static void BM_EnabledNull(benchmark::State &state) {
+    logTimed(state);
+}
+BENCHMARK(BM_EnabledNull)->Setup(toNull)->Teardown(restore)->UseRealTime();
+
+static void BM_EnabledFile(benchmark::State &state) {
+    logTimed(state);
+}
+BENCHMARK(BM_EnabledFile)->Setup(toFile)->Teardown(restore)->UseRealTime();
+
+static void BM_EnabledConsole(benchmark::State &state) {
+    logTimed(state);
+}
+BENCHMARK(BM_EnabledConsole)->Setup(toConsole)->Teardown(restore)->UseRealTime();
+
+static void BM_EnabledNullThreaded(benchmark::State &state) {
+    logTimed(state);
+}
+BENCHMARK(BM_EnabledNullThreaded)->Setup(toNull)->Teardown(restore)->ThreadRange(1, 64)->UseRealTime();
+
+static void BM_EnabledFileThreaded(benchmark::State &state) {
+    logTimed(state);
+}
+BENCHMARK(BM_EnabledFileThreaded)->Setup(toFile)->Teardown(restore)->ThreadRange(1, 64)->UseRealTime();
+
+static void BM_BufferedFileThreaded(benchmark::State &state) {
+    logTimed(state);
+}
+BENCHMARK(BM_BufferedFileThreaded)->Setup(toBufferedFile)->Teardown(restore)->ThreadRange(1, 64)->UseRealTime();
+
+/**
+ * mmap=true rolls a 64MB segment now and then instead of truncating, roqty keeps the directory small.
+ */
+static void BM_MappedFileThreaded(benchmark::State &state) {
+    logTimed(state);
+}
+BENCHMARK(BM_MappedFileThreaded)->Setup(toMappedFile)->Teardown(restore)->ThreadRange(1, 64)->UseRealTime();
+
+static void BM_EnabledConsoleAndFile(benchmark::State &state) {
+    logTimed(state);
+}
+BENCHMARK(BM_EnabledConsoleAndFile)->Setup(toConsoleAndFile)->Teardown(restore)->Arg(0)->Arg(1)->UseRealTime();
+
+/**
+ * 1MB segments: about every 8000th statement crosses a rollover, which shows up in p999.
+ */
+static void BM_RolloverCrossing(benchmark::State &state) {
+    logTimed(state);
+    LogArchiver *archiver = LogArchiver::instance();
+    if (archiver != nullptr)
+        archiver->wait();
+}
+BENCHMARK(BM_RolloverCrossing)->Setup(toRollingFile)->Teardown(restore)->UseRealTime();
+
+/**
+ * The same error over and over, written in full and coalesced by dedup=true.
+ */
+static void logStorm(benchmark::State &state) {
+    for (auto _ : state) {
+        LOG_ERROR << "connection refused by upstream";
+    }
+}
+
+static void BM_StormFile(benchmark::State &state) {
+    logStorm(state);
+}
+BENCHMARK(BM_StormFile)->Setup(toFile)->Teardown(restore)->UseRealTime();
+
+static void BM_StormDedupFile(benchmark::State &state) {
+    logStorm(state);
+}
+BENCHMARK(BM_StormDedupFile)->Setup(toDedupFile)->Teardown(restore)->UseRealTime();
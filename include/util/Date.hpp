@@ -26,13 +26,38 @@
 
 #include <string>
 #include <map>
+#include <atomic>
+#include <ctime>
 
 class Date {
+private:
+    static std::atomic<bool> _coarse_clock;
+
 public:
+    /**
+     * Upper bound of the text written by format(), including the time zone abbreviation.
+     */
+    static constexpr size_t FORMAT_SIZE = 48;
+
     static std::string nowTime();
 
     static long timestamp();
 
+    /**
+     * Reads the clock once, CLOCK_REALTIME_COARSE when enabled and available, CLOCK_REALTIME otherwise.
+     */
+    static timespec now();
+
+    static long toMicros(const timespec &ts);
+
+    /**
+     * Writes ts as zero padded "YYYY-MM-DD HH:MM:SS.uuuuuu TZ " into out and returns the length.
+     * The date, time and zone part is formatted once per second and per thread, afterwards only
+     * the microsecond digits are patched in.
+     */
+    static size_t format(const timespec &ts, char *out);
+
+    static void useCoarseClock(bool coarse);
 };
 
 
@@ -25,6 +25,7 @@
 #define UTIL_UTIL_HPP
 
 #include <string>
+#include <string_view>
 #include <utility>
 #include <vector>
 #include <iostream>
@@ -78,6 +79,19 @@ public:
 
     static std::string getExtensionOfFile(const std::string& filename);
 
+    /**
+     * Appends text as the inside of a JSON string: quotes, backslashes and control characters escaped.
+     * Runs of plain text are skipped 16 bytes at a time with SSE2 where available.
+     */
+    static void appendJsonEscaped(std::string &out, std::string_view text);
+
+    /**
+     * Position of the first occurrence of needle in text from from on, std::string_view::npos if
+     * there is none; ignoreCase folds ASCII letters. Candidates are found 16 positions at a time by
+     * comparing the first and the last byte of needle with SSE2 where available.
+     */
+    static size_t findLiteral(std::string_view text, std::string_view needle, bool ignoreCase, size_t from = 0);
+
     static std::string getFileParentFolder(const std::string& filename);
 
     static std::string getFilename(const std::string& filename);
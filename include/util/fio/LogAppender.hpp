@@ -26,25 +26,58 @@
 
 
 #include <string>
-#include <fstream>
+#include <string_view>
 #include <thread>
 #include <logconfig.h>
 #include <mutex>
+#include <chrono>
+#include <atomic>
+#include <memory>
+#include <unordered_map>
+#include <sys/uio.h>
+#include <util/fio/Codec.hpp>
+#include <util/fio/Flush.hpp>
+#include <util/fio/UringWriter.hpp>
+#include <util/logging/Level.hpp>
 
+/**
+ * Long-lived appender, one per log file. The descriptor stays open for the life of the process and
+ * lines are collected in a user-space buffer that is written out according to the flush policy.
+ */
 class LogAppender {
 private:
+    static std::mutex _registry_mutex;
+    static std::unordered_map<std::string, std::unique_ptr<LogAppender>> _registry;
+
     std::string _filename;
-    std::ofstream _out_file_stream;
+    int _fd;
+    std::string _buffer;
+    long _written;
     long _file_size;
     int _rollover_limit;
     std::string _path;
-    std::mutex compression_mutex;
-    void moveLogFile();
+    Flush _flush;
+    long _flush_bytes;
+    std::chrono::milliseconds _flush_ms;
+    std::chrono::steady_clock::time_point _last_flush;
+    Codec _codec;
+    int _compression_level;
+    std::mutex _write_mutex;
+    std::atomic<unsigned long> _rollovers{0};
+    std::chrono::milliseconds _fsync_ms{0};
+    std::chrono::steady_clock::time_point _last_fsync;
+    std::unique_ptr<UringWriter> _uring;
+    bool _crash_flushed{false};
+
+    void open();
+
+    void rollover();
+
+    void flushBuffer();
+
+    void syncIfDue();
 
-#ifdef __linux__
-    void compressLog(const std::string& inFile);
-#endif
-    void removeOldCompressions();
+    void crashWriteRaw(std::string_view v);
 
 public:
 
@@ -52,8 +85,65 @@ public:
 
     virtual ~LogAppender();
 
+    /**
+     * Appender registered for filename, created on first request.
+     */
+    static LogAppender *instance(const std::string &filename);
+
+    static void flushAll();
+
+    void configure(long mFsz, int roLimit, const std::string &path, Flush flush, long flushBytes, long flushMs,
+                   Codec codec, int compressionLevel);
+
+    /**
+     * Selects the write path: io_uring with buffers fixed buffers of bufferSize bytes, or plain
+     * write()/writev() when uring is false or io_uring is not available. A positive fsyncMs
+     * issues an fdatasync at most that often on either path.
+     */
+    void configureIo(bool uring, int buffers, long bufferSize, long fsyncMs);
+
     void write(const std::string& v);
 
+    void write(std::string_view v, Level level);
+
+    void flush();
+
+    /**
+     * Writes count buffers of whole lines with as few writev() calls as possible, after anything
+     * still in the line buffer. Rollover is checked once per call, so a segment can exceed maxsz
+     * by one batch.
+     */
+    void writev(const iovec *iov, int count);
+
+    /**
+     * Number of rollovers so far, lets writers notice that they are at the start of a new file.
+     */
+    [[nodiscard]] unsigned long getRollovers() const;
+
+    /**
+     * Writes the buffer out if the flush policy is flush_ms and the interval has elapsed. Called by
+     * the async writer when idle, or by FlushTimer when async=false.
+     */
+    void flushIfDue();
+
+    /**
+     * For the crash handler, with async-signal-safe calls only: writes the line buffer of every
+     * appender out, without taking their locks.
+     */
+    static void crashFlushAll();
+
+    /**
+     * For the crash handler, when the process survives the signal: the next crash writes the line
+     * buffers out again.
+     */
+    static void crashResumeAll();
+
+    /**
+     * Appends v behind the line buffer and whatever the ring has in flight, with async-signal-safe
+     * calls only.
+     */
+    void crashWrite(std::string_view v);
+
     template<class T> LogAppender &operator<<(const T &v);
 };
 
@@ -0,0 +1,116 @@
+// MIT License
+//
+// Copyright (c) 2023 Salomon Lee
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+#ifndef UTIL_LOG_ARCHIVER_HPP
+#define UTIL_LOG_ARCHIVER_HPP
+
+#include <string>
+#include <deque>
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <util/fio/Codec.hpp>
+
+/**
+ * Background stage for rolled log segments. LogAppender renames the active file and hands the
+ * segment over; a small pool of workers compresses it and applies retention, so rollovers of
+ * several loggers in a burst are archived in parallel and off the logging threads.
+ */
+class LogArchiver {
+private:
+    struct Job {
+        std::string file;
+        std::string activeFile;
+        int rolloverLimit;
+        Codec codec;
+        int level;
+    };
+
+    static constexpr size_t BUFFER_SIZE = 256 * 1024;
+
+    static std::atomic<bool> _stopped;
+
+    std::deque<Job> _jobs;
+    std::mutex _mutex;
+    std::condition_variable _wake;
+    std::condition_variable _idle;
+    bool _running;
+    int _busy;
+    std::vector<std::thread> _workers;
+
+    explicit LogArchiver(int workers);
+
+    void run();
+
+    static bool compressGzip(const std::string &inFile, const std::string &outFile, int level);
+
+#ifdef LOGPP_HAVE_ZSTD
+    static bool compressZstd(const std::string &inFile, const std::string &outFile, int level);
+#endif
+
+#ifdef LOGPP_HAVE_LZ4
+    static bool compressLz4(const std::string &inFile, const std::string &outFile, int level);
+#endif
+
+    static std::string compressLog(const std::string &inFile, Codec codec, int level);
+
+    /**
+     * End of the rollover timestamp in a filename that starts with prefix, npos when the name has
+     * no digits right after prefix and so belongs to another file, such as app-server for app.
+     */
+    static size_t timestampEnd(const std::string &filename, const std::string &prefix);
+
+    static void removeOldCompressions(const std::string &activeFile, const std::string &extension, int rolloverLimit);
+
+public:
+    /**
+     * Archiver configured from the current LogProperties, nullptr once it has been shut down at exit.
+     */
+    static LogArchiver *instance();
+
+    virtual ~LogArchiver();
+
+    /**
+     * Codec actually used for codec in this build; zstd and lz4 fall back to gzip when the library
+     * was not found at configure time.
+     */
+    static Codec available(Codec codec);
+
+    static std::string extensionOf(Codec codec);
+
+    /**
+     * Rolled segments of activeFile, archived or still waiting for compression, oldest first.
+     */
+    static std::vector<std::string> segmentsOf(const std::string &activeFile);
+
+    void submit(const std::string &file, const std::string &activeFile, int rolloverLimit, Codec codec, int level);
+
+    /**
+     * Blocks until every submitted segment has been archived.
+     */
+    void wait();
+};
+
+#endif //UTIL_LOG_ARCHIVER_HPP
@@ -0,0 +1,119 @@
+// MIT License
+//
+// Copyright (c) 2023 Salomon Lee
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+#ifndef UTIL_MAPPED_LOG_HPP
+#define UTIL_MAPPED_LOG_HPP
+
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+#include <util/fio/Codec.hpp>
+
+/**
+ * Log file written through a shared mapping (mmap=true). Each segment is preallocated to maxsz with
+ * fallocate and mapped; writers reserve their range with a fetch-add on the segment offset and copy
+ * the line in, without a lock or a system call. The writer whose range crosses the end switches to
+ * the next segment, which is prepared ahead as <file>.next, and hands the full one to the archiver
+ * as usual. Segments are truncated to their used length when they are rolled or closed; a file
+ * left by a crash is trimmed of its zero tail when it is opened again.
+ */
+class MappedLog {
+private:
+    struct Segment {
+        int fd{-1};
+        char *base{nullptr};
+        size_t capacity{0};
+        std::atomic<size_t> reserved{0};
+        std::atomic<size_t> committed{0};
+        size_t synced{0};
+    };
+
+    static std::mutex _registry_mutex;
+    static std::unordered_map<std::string, std::unique_ptr<MappedLog>> _registry;
+
+    std::string _filename;
+    std::atomic<Segment *> _current{nullptr};
+    std::unique_ptr<Segment> _next;
+    // Rolled segments stay allocated, a writer may still be looking at their counters.
+    std::vector<std::unique_ptr<Segment>> _segments;
+    std::mutex _mutex;
+    size_t _capacity;
+    int _rollover_limit;
+    Codec _codec;
+    int _compression_level;
+    std::atomic<long> _msync_ms{0};
+    std::chrono::steady_clock::time_point _last_msync;
+    std::atomic<unsigned long> _rollovers{0};
+
+    static Segment *map(const std::string &file, size_t capacity, bool existing);
+
+    static void unmap(Segment *segment, size_t used);
+
+    size_t append(std::string_view v);
+
+    void rollover(Segment *full, size_t used);
+
+    void sync(Segment *segment);
+
+public:
+    MappedLog(std::string filename, long maxSize);
+
+    virtual ~MappedLog();
+
+    /**
+     * Mapped log registered for filename, created on first request with segments of maxSize.
+     */
+    static MappedLog *instance(const std::string &filename, long maxSize);
+
+    /**
+     * Size, retention and compression of the segments rolled from now on, and the interval of the
+     * msync calls (0 leaves write back to the kernel).
+     */
+    void configure(long maxSize, int roLimit, Codec codec, int compressionLevel, long msyncMs);
+
+    void write(std::string_view v);
+
+    /**
+     * write() for the crash handler: never waits for a rollover, v is dropped if it does not fit.
+     */
+    void crashWrite(std::string_view v);
+
+    /**
+     * msync of everything written so far.
+     */
+    void flush();
+
+    /**
+     * msync if the interval has elapsed.
+     */
+    void flushIfDue();
+
+    [[nodiscard]] unsigned long getRollovers() const;
+};
+
+#endif //UTIL_MAPPED_LOG_HPP
@@ -0,0 +1,83 @@
+// MIT License
+//
+// Copyright (c) 2023 Salomon Lee
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+#ifndef UTIL_PROPERTIES_WATCHER_HPP
+#define UTIL_PROPERTIES_WATCHER_HPP
+
+#include <atomic>
+#include <mutex>
+#include <string>
+#include <thread>
+
+/**
+ * Thread that reloads the property file through LogProperties::reload whenever it is rewritten in
+ * place or replaced by a rename, using inotify on its directory. Every reload publishes a complete
+ * new snapshot, so statements see either the old or the new configuration.
+ */
+class PropertiesWatcher {
+private:
+    static std::atomic<bool> _stopped;
+
+    std::mutex _mutex;
+    std::string _file;
+    std::string _name;
+    std::string _dir;
+    int _fd{-1};
+    int _wd{-1};
+    std::atomic<bool> _running{false};
+    std::atomic<unsigned long> _reloads{0};
+    std::thread _thread;
+
+    PropertiesWatcher() = default;
+
+    /**
+     * Points the inotify watch at the directory of file, called with _mutex held.
+     */
+    void addWatch(const std::string &file);
+
+    void run();
+
+public:
+    /**
+     * Watcher of the process, nullptr once it has been shut down at exit.
+     */
+    static PropertiesWatcher *instance();
+
+    virtual ~PropertiesWatcher();
+
+    /**
+     * Watches file from now on, an empty name stops the thread. The watch is in place when this
+     * returns, so a rewrite right after it is not missed. Safe to call from the reload the watcher
+     * itself triggered.
+     */
+    void watch(const std::string &file);
+
+    [[nodiscard]] std::string getFile();
+
+    /**
+     * Reloads done so far.
+     */
+    [[nodiscard]] unsigned long getReloads() const;
+};
+
+#endif //UTIL_PROPERTIES_WATCHER_HPP
@@ -0,0 +1,86 @@
+// MIT License
+//
+// Copyright (c) 2023 Salomon Lee
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+
+#ifndef UTIL_SEGMENT_READER_HPP
+#define UTIL_SEGMENT_READER_HPP
+
+#include <cstdio>
+#include <memory>
+#include <string>
+#include <zlib.h>
+#include <util/fio/Codec.hpp>
+
+/**
+ * Reads a log segment as the appender wrote it, decompressing archived segments while reading:
+ * plain and .gz through zlib, .zst and .lz4 when the library was built with them.
+ */
+class SegmentReader {
+private:
+    static constexpr size_t BUFFER_SIZE = 256 * 1024;
+
+    std::string _file;
+    Codec _codec;
+    gzFile _gz{nullptr};
+    FILE *_in{nullptr};
+    void *_context{nullptr};
+    std::unique_ptr<char[]> _input;
+    size_t _input_pos{0};
+    size_t _input_size{0};
+    bool _eof{false};
+    bool _error{false};
+
+    bool fill();
+
+    size_t readZstd(char *buffer, size_t size);
+
+    size_t readLz4(char *buffer, size_t size);
+
+public:
+    explicit SegmentReader(const std::string &file);
+
+    SegmentReader(const SegmentReader &) = delete;
+
+    SegmentReader &operator=(const SegmentReader &) = delete;
+
+    virtual ~SegmentReader();
+
+    /**
+     * Codec of file by its extension, codec_none for anything that is not an archive.
+     */
+    static Codec codecOf(const std::string &file);
+
+    [[nodiscard]] bool isOpen() const;
+
+    /**
+     * True once reading stopped on a damaged or truncated archive.
+     */
+    [[nodiscard]] bool hasError() const;
+
+    /**
+     * Fills buffer with up to size bytes of text, 0 at the end of the segment or on an error.
+     */
+    size_t read(char *buffer, size_t size);
+};
+
+#endif //UTIL_SEGMENT_READER_HPP
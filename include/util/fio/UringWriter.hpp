@@ -0,0 +1,106 @@
+// MIT License
+//
+// Copyright (c) 2023 Salomon Lee
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+#ifndef UTIL_URING_WRITER_HPP
+#define UTIL_URING_WRITER_HPP
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/**
+ * io_uring backend of LogAppender (io=uring). Appends are copied into registered fixed buffers and
+ * submitted as IORING_OP_WRITE_FIXED at explicit offsets of a registered descriptor, several per
+ * io_uring_enter(); the caller only waits when every buffer is in flight. An fdatasync is queued
+ * behind the writes every fsyncMs when that is positive. Built on the raw system calls, so only
+ * the kernel headers are needed; available() is false where the kernel or build lacks io_uring.
+ */
+class UringWriter {
+private:
+    struct Ring;
+
+    Ring *_ring;
+    int _fd;
+    long _offset;
+    size_t _buffer_size;
+    unsigned _buffer_count;
+    std::vector<char *> _buffers;
+    std::vector<size_t> _lengths;
+    std::vector<long> _offsets;
+    std::vector<unsigned> _free;
+    unsigned _in_flight;
+    std::chrono::milliseconds _fsync_ms;
+    std::chrono::steady_clock::time_point _last_fsync;
+    std::string _filename;
+
+    void submit(unsigned buffer);
+
+    void fsync();
+
+    /**
+     * Reaps completions, waiting for at least min of them.
+     */
+    void reap(unsigned min);
+
+    /**
+     * After a hard io_uring_enter error: finishes the buffers in flight with pwrite() and closes
+     * the ring, isReady() is false from then on.
+     */
+    void drop();
+
+public:
+    UringWriter(unsigned buffers, size_t bufferSize, long fsyncMs);
+
+    virtual ~UringWriter();
+
+    static bool available();
+
+    /**
+     * False if the ring could not be set up or has failed, the appender then keeps writing itself.
+     */
+    [[nodiscard]] bool isReady() const;
+
+    [[nodiscard]] bool isConfigured(int buffers, long bufferSize, long fsyncMs) const;
+
+    /**
+     * Waits for the writes to the current file and continues at the end of filename.
+     */
+    bool attach(const std::string &filename);
+
+    void write(const char *data, size_t size);
+
+    /**
+     * Blocks until everything written so far has completed.
+     */
+    void sync();
+
+    /**
+     * For the crash handler, with async-signal-safe calls only: writes the buffers still in
+     * flight again with pwrite(), then appends data behind them.
+     */
+    void crashWrite(const char *data, size_t size);
+};
+
+#endif //UTIL_URING_WRITER_HPP
@@ -0,0 +1,107 @@
+// MIT License
+//
+// Copyright (c) 2023 Salomon Lee
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+#ifndef UTIL_ASYNC_LOG_WRITER_HPP
+#define UTIL_ASYNC_LOG_WRITER_HPP
+
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <util/logging/LogRing.hpp>
+#include <util/logging/Overflow.hpp>
+#include <util/logging/SinkRegistry.hpp>
+
+/**
+ * Background writer behind async=true. Log statements push their rendered record into the ring and
+ * return; the writer thread drains the ring in batches to the registered sinks.
+ */
+class AsyncLogWriter {
+private:
+    static constexpr size_t BATCH_SIZE = 256;
+
+    static std::atomic<bool> _stopped;
+    static std::atomic<AsyncLogWriter *> _active;
+    static std::atomic<bool> _crashing;
+
+    LogRing _ring;
+    Overflow _overflow;
+    std::atomic<size_t> _consumed{0};
+    std::atomic<size_t> _dropped{0};
+    std::atomic<bool> _sleeping{false};
+    std::atomic<bool> _running{true};
+    std::mutex _mutex;
+    std::condition_variable _wake;
+    std::condition_variable _drained;
+    std::thread _thread;
+    SinkRegistry::Batch _batch;
+    std::atomic<int> _draining{0};
+
+    AsyncLogWriter(size_t capacity, Overflow overflow);
+
+    void run();
+
+    size_t drain();
+
+    size_t drainBatch();
+
+    void wake(bool force);
+
+public:
+    /**
+     * Writer configured from the current LogProperties, started on first use. Returns nullptr once
+     * the writer has been shut down during static destruction.
+     */
+    static AsyncLogWriter *instance();
+
+    virtual ~AsyncLogWriter();
+
+    void push(LogRecord &record);
+
+    /**
+     * Blocks until every record pushed before the call has been written out.
+     */
+    void flush();
+
+    [[nodiscard]] size_t getDropped() const;
+
+    /**
+     * For the crash handler: hands the batch being written to the sinks' crashWrite, then every
+     * record still queued to write, without locking or allocating.
+     */
+    static void crashDrain(void (*write)(const LogRecord &record));
+
+    /**
+     * For the crash handler, before anything is written out: keeps the writer thread from taking
+     * further records and waits a little for the batch it is writing to reach the sinks.
+     */
+    static void crashPark();
+
+    /**
+     * For the crash handler, when the handler it chained to returned and the process goes on:
+     * lets the writer thread take records again.
+     */
+    static void crashResume();
+};
+
+#endif //UTIL_ASYNC_LOG_WRITER_HPP
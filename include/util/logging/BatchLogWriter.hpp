@@ -0,0 +1,153 @@
+// MIT License
+//
+// Copyright (c) 2023 Salomon Lee
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+#ifndef UTIL_BATCH_LOG_WRITER_HPP
+#define UTIL_BATCH_LOG_WRITER_HPP
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+#include <util/fio/LogAppender.hpp>
+#include <util/logging/Level.hpp>
+
+/**
+ * Behind buffered=true. Every thread collects whole rendered lines in its own chunk per file; full
+ * chunks are pushed onto a lock-free stack and a single writer thread writes each file's chunks
+ * with one writev(). Written chunks go back on a free stack that threads take as a whole. Partial
+ * chunks are picked up every FLUSH_INTERVAL, error lines are written before the statement returns.
+ */
+class BatchLogWriter {
+private:
+    struct Chunk {
+        Chunk *next{nullptr};
+        unsigned long sequence{0};
+        LogAppender *appender{nullptr};
+        std::string data;
+    };
+
+    struct ThreadBuffer {
+        std::atomic_flag lock = ATOMIC_FLAG_INIT;
+        LogAppender *appender{nullptr};
+        Chunk *chunk{nullptr};
+        Chunk *spare{nullptr};
+
+        ~ThreadBuffer();
+    };
+
+    struct ThreadBuffers {
+        std::vector<std::shared_ptr<ThreadBuffer>> buffers;
+
+        ~ThreadBuffers();
+    };
+
+    static constexpr size_t CHUNK_SIZE = 64 * 1024;
+    static constexpr size_t CRASH_SLOTS = 256;
+    static constexpr std::chrono::milliseconds FLUSH_INTERVAL{100};
+
+    static std::atomic<bool> _stopped;
+    static std::atomic<BatchLogWriter *> _active;
+    static std::atomic<bool> _crashing;
+
+    std::atomic<Chunk *> _full{nullptr};
+    std::atomic<Chunk *> _free{nullptr};
+    std::atomic<unsigned long> _sequence{0};
+    std::mutex _buffers_mutex;
+    std::vector<std::shared_ptr<ThreadBuffer>> _buffers;
+    // The same buffers for the crash handler, which cannot lock _buffers_mutex. Threads beyond
+    // CRASH_SLOTS are left out of a crash, not out of flushes.
+    std::atomic<ThreadBuffer *> _crash_slots[CRASH_SLOTS]{};
+    std::mutex _drain_mutex;
+    std::vector<Chunk *> _batch;
+    std::vector<iovec> _iov;
+    std::atomic<int> _draining{0};
+    std::mutex _wake_mutex;
+    std::condition_variable _wake;
+    bool _running{true};
+    std::thread _thread;
+
+    BatchLogWriter();
+
+    ThreadBuffer *threadBuffer(LogAppender *appender);
+
+    static Chunk *take(ThreadBuffer &buffer);
+
+    static void push(std::atomic<Chunk *> &stack, Chunk *chunk);
+
+    void handOff(Chunk *chunk);
+
+    /**
+     * Empty chunk for appender, recycled from written ones when possible so the hot path does not
+     * fault in fresh pages.
+     */
+    Chunk *newChunk(ThreadBuffer &buffer);
+
+    /**
+     * Writes every handed off chunk, and with collect also the partial chunks of all threads.
+     */
+    void drain(bool collect);
+
+    void drainLocked(bool collect);
+
+    void run();
+
+public:
+    /**
+     * Writer used by the buffered file sinks, nullptr once it has been shut down at exit.
+     */
+    static BatchLogWriter *instance();
+
+    virtual ~BatchLogWriter();
+
+    void write(LogAppender *appender, std::string_view text, Level level);
+
+    /**
+     * Writes out everything buffered by any thread.
+     */
+    void flush();
+
+    /**
+     * For the crash handler: writes the handed off chunks, oldest first, and the partial chunk of
+     * every thread through LogAppender::crashWrite, without locking or allocating.
+     */
+    static void crashDrain();
+
+    /**
+     * For the crash handler, before anything is written out: keeps threads from taking further
+     * chunks and waits a little for the ones being written to reach the appenders.
+     */
+    static void crashPark();
+
+    /**
+     * For the crash handler, when the handler it chained to returned and the process goes on:
+     * lets threads write chunks again.
+     */
+    static void crashResume();
+};
+
+#endif //UTIL_BATCH_LOG_WRITER_HPP
@@ -0,0 +1,132 @@
+// MIT License
+//
+// Copyright (c) 2023 Salomon Lee
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+#ifndef UTIL_BINARY_LOG_HPP
+#define UTIL_BINARY_LOG_HPP
+
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <util/Date.hpp>
+#include <util/logging/BinaryLogWriter.hpp>
+#include <util/logging/LogFormat.hpp>
+
+/**
+ * Deferred formatting. A binary statement copies its site id, the clock reading, the thread id and
+ * the raw argument values into the calling thread's buffer; the text is only produced when
+ * logpp-decode (or BinaryLogReader) renders the segment. The format string is checked at compile
+ * time exactly like LOG_INFOF.
+ */
+class BinaryLog {
+private:
+    template<class T>
+    static size_t argSize(const T &v) {
+        using U = std::remove_cvref_t<T>;
+        if constexpr (std::is_same_v<U, bool> || std::is_same_v<U, char>)
+            return 2;
+        else if constexpr (std::is_arithmetic_v<U>)
+            return 9;
+        else
+            return 5 + std::string_view(v).size();
+    }
+
+    template<class T>
+    static char *put(char *p, T v) {
+        std::memcpy(p, &v, sizeof(T));
+        return p + sizeof(T);
+    }
+
+    template<class T>
+    static char *encode(char *p, const T &v) {
+        using U = std::remove_cvref_t<T>;
+        if constexpr (std::is_same_v<U, bool>) {
+            *p++ = binary_bool;
+            *p++ = v ? 1 : 0;
+        } else if constexpr (std::is_same_v<U, char>) {
+            *p++ = binary_char;
+            *p++ = v;
+        } else if constexpr (std::is_floating_point_v<U>) {
+            *p++ = binary_double;
+            p = put<double>(p, static_cast<double>(v));
+        } else if constexpr (std::is_integral_v<U> && std::is_signed_v<U>) {
+            *p++ = binary_int;
+            p = put<int64_t>(p, static_cast<int64_t>(v));
+        } else if constexpr (std::is_integral_v<U>) {
+            *p++ = binary_uint;
+            p = put<uint64_t>(p, static_cast<uint64_t>(v));
+        } else {
+            std::string_view text(v);
+            *p++ = binary_string;
+            p = put<uint32_t>(p, static_cast<uint32_t>(text.size()));
+            std::memcpy(p, text.data(), text.size());
+            p += text.size();
+        }
+        return p;
+    }
+
+public:
+    static uint32_t site(const char *file, const char *function, int line, Level level, const char *format) {
+        BinaryLogWriter *writer = BinaryLogWriter::instance();
+        return writer != nullptr ? writer->registerSite(file, function, line, level, format) : 0;
+    }
+
+    template<class... Args>
+    static void write(uint32_t site, Level level, FormatString<std::type_identity_t<Args>...>, const Args &... args) {
+        static_assert((isFormattable<Args>() && ...), "LOG_*B argument has no {} formatting");
+        BinaryLogWriter *writer = BinaryLogWriter::instance();
+        if (writer == nullptr)
+            return;
+        std::string_view tid = Log::threadId();
+        size_t payload = (size_t{0} + ... + argSize(args));
+        size_t size = BinaryLogWriter::RECORD_HEADER_SIZE + tid.size() + payload;
+        timespec now = Date::now();
+
+        char *p = writer->begin(size);
+        *p++ = binary_record;
+        p = put<uint32_t>(p, site);
+        p = put<int64_t>(p, static_cast<int64_t>(now.tv_sec));
+        p = put<int32_t>(p, static_cast<int32_t>(now.tv_nsec));
+        *p++ = static_cast<char>(tid.size());
+        std::memcpy(p, tid.data(), tid.size());
+        p += tid.size();
+        p = put<uint32_t>(p, static_cast<uint32_t>(payload));
+        ((p = encode(p, args)), ...);
+        writer->commit(size, level);
+    }
+};
+
+#define LOG_AT_B(func, l, fmt, ...) \
+    if constexpr (!Log::isActive(l)) {} \
+    else if (static const uint32_t _logpp_site = BinaryLog::site(__FILE__, func, __LINE__, l, fmt); !Log::isEnabled(l, __FILE__)) {} \
+    else BinaryLog::write(_logpp_site, l, fmt __VA_OPT__(,) __VA_ARGS__)
+
+#define LOG_INFOB(fmt, ...)  LOG_AT_B(__PRETTY_FUNCTION__, log_info, fmt __VA_OPT__(,) __VA_ARGS__)
+#define LOG_WARNB(fmt, ...)  LOG_AT_B(__PRETTY_FUNCTION__, log_warning, fmt __VA_OPT__(,) __VA_ARGS__)
+#define LOG_TRACEB(fmt, ...) LOG_AT_B(__PRETTY_FUNCTION__, log_trace, fmt __VA_OPT__(,) __VA_ARGS__)
+#define LOG_ERRORB(fmt, ...) LOG_AT_B(__PRETTY_FUNCTION__, log_error, fmt __VA_OPT__(,) __VA_ARGS__)
+#define LOG_DEBUGB(fmt, ...) LOG_AT_B(__PRETTY_FUNCTION__, log_debug, fmt __VA_OPT__(,) __VA_ARGS__)
+#define LOGB(fmt, ...)       LOG_AT_B(__FUNCTION__, log_verbose, fmt __VA_OPT__(,) __VA_ARGS__)
+
+#endif //UTIL_BINARY_LOG_HPP
@@ -0,0 +1,83 @@
+// MIT License
+//
+// Copyright (c) 2023 Salomon Lee
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+#ifndef UTIL_BINARY_LOG_READER_HPP
+#define UTIL_BINARY_LOG_READER_HPP
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <util/logging/BinaryLogWriter.hpp>
+#include <util/logging/LogRecord.hpp>
+
+struct gzFile_s;
+
+/**
+ * Decodes a binary log file, plain or gzip archived, back into the text lines the file appender
+ * would have written for the same statements.
+ */
+class BinaryLogReader {
+private:
+    struct Site {
+        Level level{log_verbose};
+        int line{0};
+        std::string file;
+        std::string function;
+        std::string format;
+    };
+
+    gzFile_s *_file;
+    std::vector<Site> _sites;
+    std::string _payload;
+    LogRecord _record;
+    long _records{0};
+    bool _corrupt{false};
+
+    bool read(void *data, size_t size);
+
+    bool readText(std::string &text);
+
+    bool readSite();
+
+    bool readRecord(std::string &line);
+
+    void format(const Site &site);
+
+public:
+    explicit BinaryLogReader(const std::string &file);
+
+    virtual ~BinaryLogReader();
+
+    bool isOpen() const;
+
+    /**
+     * Renders the next record into line, returns false at the end of the file or on a damaged frame.
+     */
+    bool next(std::string &line);
+
+    long getRecords() const;
+
+    bool isCorrupt() const;
+};
+
+#endif //UTIL_BINARY_LOG_READER_HPP
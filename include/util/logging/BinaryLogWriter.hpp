@@ -0,0 +1,156 @@
+// MIT License
+//
+// Copyright (c) 2023 Salomon Lee
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+#ifndef UTIL_BINARY_LOG_WRITER_HPP
+#define UTIL_BINARY_LOG_WRITER_HPP
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include <util/logging/Level.hpp>
+
+/**
+ * Frame types of a binary log segment. Every segment starts with binary_segment followed by the
+ * sites known so far; records refer to their site by id. Values are stored in native byte order.
+ */
+enum BinaryFrame : uint8_t {
+    binary_segment = 0,
+    binary_site = 1,
+    binary_record = 2
+};
+
+enum BinaryArg : uint8_t {
+    binary_int = 'i',
+    binary_uint = 'u',
+    binary_double = 'd',
+    binary_bool = 'b',
+    binary_char = 'c',
+    binary_string = 's'
+};
+
+/**
+ * Static description of a binary log statement, registered once per call site.
+ */
+struct BinarySite {
+    uint32_t id;
+    Level level;
+    const char *file;
+    const char *function;
+    int line;
+    const char *format;
+};
+
+/**
+ * Collects binary records from per-thread buffers and writes them to the binary log file. Producers
+ * only take their own, uncontended buffer lock; a background thread gathers the buffers every
+ * FLUSH_INTERVAL or as soon as one fills up.
+ */
+class BinaryLogWriter {
+private:
+    struct ThreadBuffer {
+        std::atomic_flag lock = ATOMIC_FLAG_INIT;
+        std::unique_ptr<char[]> data;
+        size_t size{0};
+        size_t capacity{0};
+
+        ThreadBuffer();
+
+        ~ThreadBuffer();
+    };
+
+    static constexpr char SEGMENT_MAGIC[8] = {binary_segment, 'L', 'O', 'G', 'P', 'P', 'B', '1'};
+    static constexpr size_t CHUNK_SIZE = 64 * 1024;
+    static constexpr size_t MAX_THREAD_BUFFER = 4 * CHUNK_SIZE;
+    static constexpr std::chrono::milliseconds FLUSH_INTERVAL{100};
+
+    static std::atomic<bool> _stopped;
+    static std::atomic<BinaryLogWriter *> _active;
+
+    std::mutex _sites_mutex;
+    std::deque<BinarySite> _sites;
+    // Site frames of every site so far, encoded at registration.
+    std::string _encoded_sites;
+    std::mutex _buffers_mutex;
+    std::vector<ThreadBuffer *> _buffers;
+    std::string _orphans;
+    std::mutex _write_mutex;
+    std::string _out;
+    size_t _sites_written{0};  // bytes of _encoded_sites in the current segment
+    unsigned long _segment{~0ul};
+    std::mutex _wake_mutex;
+    std::condition_variable _wake;
+    bool _running{true};
+    std::thread _thread;
+
+    BinaryLogWriter();
+
+    static ThreadBuffer *threadBuffer();
+
+    void run();
+
+    void collect(std::string &out);
+
+    static void encodeSite(const BinarySite &site, std::string &out);
+
+public:
+    static constexpr size_t RECORD_HEADER_SIZE = 1 + 4 + 8 + 4 + 1 + 4;
+
+    /**
+     * Writer used by the binary log macros, nullptr once it has been shut down at exit.
+     */
+    static BinaryLogWriter *instance();
+
+    virtual ~BinaryLogWriter();
+
+    uint32_t registerSite(const char *file, const char *function, int line, Level level, const char *format);
+
+    /**
+     * Locks the calling thread's buffer and returns size writable bytes in it. Must be followed by
+     * commit().
+     */
+    char *begin(size_t size);
+
+    void commit(size_t size, Level level);
+
+    /**
+     * Writes every buffered record out to the binary log file.
+     */
+    void flush();
+
+    /**
+     * For the crash handler: appends the records buffered by every thread to the binary log file
+     * behind the sites registered since the last flush, through LogAppender::crashWrite,
+     * without locking or allocating.
+     */
+    static void crashDrain();
+
+    static std::string_view segmentMagic();
+};
+
+#endif //UTIL_BINARY_LOG_WRITER_HPP
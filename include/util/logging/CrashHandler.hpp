@@ -0,0 +1,74 @@
+// MIT License
+//
+// Copyright (c) 2023 Salomon Lee
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+#ifndef UTIL_CRASH_HANDLER_HPP
+#define UTIL_CRASH_HANDLER_HPP
+
+#include <atomic>
+#include <csignal>
+#include <string_view>
+#include <util/logging/LogRecord.hpp>
+
+/**
+ * Opt-in handler for SIGSEGV, SIGABRT, SIGBUS and SIGFPE (crash.handler=true). On a fatal signal it
+ * writes out whatever the appenders, the buffered and async writers and the binary log still hold,
+ * appends a final ERROR record naming the signal, with the stack when crash.backtrace=true, and
+ * passes the signal on to the handler that was installed before, re-raising it under the default
+ * action when there was none. If that handler returns, logging goes on and the next signal is
+ * handled again; lines the handler wrote out of the buffers may then be written twice. Only
+ * async-signal-safe calls are made on the way, except for the symbol lookup of the backtrace.
+ */
+class CrashHandler {
+private:
+    static std::atomic<bool> _installed;
+    static std::atomic<bool> _backtrace;
+    static std::atomic<bool> _handling;
+
+    static void handle(int signal, siginfo_t *info, void *context);
+
+    static void writeRecord(const LogRecord &record);
+
+    static void writeRecord(Level level, const timespec &time, std::string_view thread, const LogSite *site,
+                            std::string_view message, const LogFieldBuffer *fields);
+
+public:
+    /**
+     * Installs the handler once, later calls only change whether the stack is written.
+     */
+    static void install(bool backtrace);
+
+    /**
+     * Puts back the handlers that were there before install().
+     */
+    static void uninstall();
+
+    [[nodiscard]] static bool isInstalled();
+
+    /**
+     * Writes out everything buffered for the outputs, what the handler does before its own
+     * record. Async-signal-safe.
+     */
+    static void drain();
+};
+
+#endif //UTIL_CRASH_HANDLER_HPP
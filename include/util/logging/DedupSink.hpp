@@ -0,0 +1,86 @@
+// MIT License
+//
+// Copyright (c) 2023 Salomon Lee
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+#ifndef UTIL_DEDUP_SINK_HPP
+#define UTIL_DEDUP_SINK_HPP
+
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <util/logging/Sink.hpp>
+
+/**
+ * Stage in front of another sink that coalesces runs of identical records. A record repeats the
+ * previous one of its thread when level, message (with its call site prefix in DEBUG builds) and
+ * fields hash the same; repeats are counted instead of rendered, and a "last message repeated N
+ * times" line goes out when the run ends or has lasted the timeout. A run that stops is counted by
+ * flushIfDue, from the async writer or FlushTimer.
+ */
+class DedupSink : public Sink {
+private:
+    struct Run {
+        size_t hash{};
+        Level level{log_verbose};
+        timespec first{};
+        timespec last{};
+        char thread[32]{};
+        size_t thread_length{};
+        unsigned long repeats{};
+    };
+
+    std::shared_ptr<Sink> _inner;
+    long _timeout_ms;
+    std::mutex _mutex;
+    std::unordered_map<size_t, Run> _runs;
+    timespec _last_sweep{};
+
+    static size_t hashOf(const LogRecord &record);
+
+    static long millisBetween(const timespec &from, const timespec &to);
+
+    void render(const LogRecord &record, std::string &out);
+
+    void appendRepeated(Run &run, std::string &out);
+
+    void sweep(const timespec &now, std::string &out);
+
+public:
+    DedupSink(std::shared_ptr<Sink> inner, long timeoutMs);
+
+    const std::shared_ptr<Sink> &getInner() const;
+
+    void format(const LogRecord &record, std::string &out) override;
+
+    void write(std::string_view text, Level level) override;
+
+    /**
+     * Writes the repeat count of every open run, then flushes the inner sink.
+     */
+    void flush() override;
+
+    void flushIfDue() override;
+
+    void crashWrite(std::string_view text) override;
+};
+
+#endif //UTIL_DEDUP_SINK_HPP
@@ -0,0 +1,52 @@
+// MIT License
+//
+// Copyright (c) 2023 Salomon Lee
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+#ifndef UTIL_FILE_SINK_HPP
+#define UTIL_FILE_SINK_HPP
+
+#include <util/fio/LogAppender.hpp>
+#include <util/logging/Sink.hpp>
+
+/**
+ * Lines in the format of the given SinkFormat (plain text or JSON) appended to a LogAppender, which
+ * owns buffering, flushing and rollover.
+ */
+class FileSink : public Sink {
+private:
+    LogAppender *_appender;
+
+public:
+    FileSink(std::string name, SinkFormat format, LogAppender *appender, Level minLevel = log_verbose);
+
+    LogAppender *getAppender() const;
+
+    void write(std::string_view text, Level level) override;
+
+    void flush() override;
+
+    void flushIfDue() override;
+
+    void crashWrite(std::string_view text) override;
+};
+
+#endif //UTIL_FILE_SINK_HPP
@@ -0,0 +1,79 @@
+// MIT License
+//
+// Copyright (c) 2023 Salomon Lee
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+#ifndef UTIL_FLUSH_TIMER_HPP
+#define UTIL_FLUSH_TIMER_HPP
+
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+class LogProperties;
+
+/**
+ * Thread behind the time based policies when async=false, where no writer thread comes back to
+ * the sinks while the process is quiet: a flush=ms buffer is written out within flush.ms of its
+ * line even if no other line follows, and a dedup run gets its repeat count within
+ * dedup.timeout.ms of the last repeat. In either mode it writes the rate limit summaries that come
+ * due after the limited statements stopped, and the last ones at exit. Only started once a policy
+ * needs it.
+ */
+class FlushTimer {
+private:
+    static std::atomic<bool> _stopped;
+    static std::atomic<FlushTimer *> _active;
+
+    std::mutex _mutex;
+    std::condition_variable _wake;
+    long _interval_ms{0};
+    bool _running{false};
+    std::thread _thread;
+
+    FlushTimer() = default;
+
+    void run();
+
+    static void tick();
+
+public:
+    /**
+     * Timer of the process, nullptr once it has been shut down at exit.
+     */
+    static FlushTimer *instance();
+
+    virtual ~FlushTimer();
+
+    /**
+     * Starts, retimes or stops the timer for the policies of properties, called when a snapshot is
+     * published.
+     */
+    static void reschedule(const LogProperties *properties);
+
+    /**
+     * Ticks every intervalMs from now on, 0 stops the thread.
+     */
+    void schedule(long intervalMs);
+};
+
+#endif //UTIL_FLUSH_TIMER_HPP
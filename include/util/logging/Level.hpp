@@ -35,4 +35,26 @@ enum Level {
     log_stealth
 };
 
+/**
+ * Order of the levels for thresholds: trace < debug < info, verbose < warning < error, with silent
+ * and stealth above everything.
+ */
+constexpr int severityOf(Level level) {
+    switch (level) {
+        case log_trace:
+            return 0;
+        case log_debug:
+            return 1;
+        case log_info:
+        case log_verbose:
+            return 2;
+        case log_warning:
+            return 3;
+        case log_error:
+            return 4;
+        default:
+            return 5;
+    }
+}
+
 #endif //UTIL_LEVEL_HPP
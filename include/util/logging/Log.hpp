@@ -24,52 +24,224 @@
 #ifndef UTIL_LOG_HPP
 #define UTIL_LOG_HPP
 
+#include <atomic>
 #include <sstream>
+#include <string>
+#include <string_view>
+#include <type_traits>
 #include <util/Date.hpp>
 #include <util/logging/Level.hpp>
+#include <util/logging/LogFields.hpp>
+#include <util/logging/LogRecord.hpp>
 #include <util/properties/LogProperties.hpp>
 #include <logconfig.h>
 
 class Log {
 private:
-    std::stringstream _stream;
-    Level _log_level;
-    LogProperties *_log_properties;
-    std::string _log_line;
-    bool _is_level_debug{};
-    bool _is_level_trace{};
-    bool _is_level_error{};
-    bool _is_level_info{};
-    bool _is_level_warning{};
-    bool _is_Level_stealth{};
-    bool _is_level_silent{};
-
-    static std::string toString(Level l, bool isStdOut);
-
-    void defineLogLevels(Level level);
+    LogRecord _record;
+
+    static std::string_view toString(Level l, bool isStdOut);
+
+    static std::atomic<bool> _basename;
+    static std::atomic<bool> _short_function;
+
+    static void appendHead(const LogRecord &record, bool isStdOut, std::string &out);
+
+    /**
+     * Empty per-thread stream for types only operator<< of std::ostream knows, with the flags,
+     * fill, width and state a manipulator of the previous value may have left reset.
+     */
+    static std::ostringstream &stream();
 
 public:
-    Log(const std::string &fileName, const std::string &funcName, const long& line, Level l);
+    explicit Log(const LogSite *site, Level l, const Logger *logger = nullptr);
 
     virtual ~Log();
 
+    /**
+     * Prefix of the calling thread in the thx-id field: its kernel id as top and perf show it,
+     * followed by ":name" once setThreadName gave it one. Formatted once per thread.
+     */
+    static std::string_view threadId();
+
+    /**
+     * Names the calling thread in its log lines and, cut to the 15 characters the kernel keeps,
+     * in top, ps and perf. The prefix is cut to fit LogRecord::thread, and ')' and line breaks in
+     * it become '_' so that the line still parses.
+     */
+    static void setThreadName(std::string_view name);
+
+    /**
+     * Whether statements of level l are compiled in at all, see LOGPP_ACTIVE_LEVEL in logconfig.h.
+     */
+    static constexpr bool isActive(Level l) {
+        return severityOf(l) >= LOGPP_ACTIVE_LEVEL;
+    }
+
+    static bool isEnabled(Level l) {
+        return LogProperties::enabledLevels() & (1u << l);
+    }
+
+    /**
+     * Level check of a statement in file, which only looks past the one load of isEnabled(l) when
+     * some module has a level of its own (LogLevels).
+     */
+    static bool isEnabled(Level l, const char *file) {
+        unsigned levels = LogProperties::enabledLevels();
+        return (levels & (1u << l)) && (!(levels & LogLevels::OVERRIDDEN) || LogLevels::isEnabled(l, file));
+    }
+
+    /**
+     * Appends the ANSI colored console line of record to out.
+     */
+    static void renderConsole(const LogRecord &record, std::string &out);
+
+    /**
+     * Appends the plain file line of record, with its epoch microseconds, to out.
+     */
+    static void renderFile(const LogRecord &record, std::string &out);
+
+    /**
+     * Appends record as one JSON object line: time, epoch_us, level, thread, the logger name for
+     * named loggers, file, function and line of the site and message.
+     */
+    static void renderJson(const LogRecord &record, std::string &out);
+
+    /**
+     * Appends "[file - function](line: N): " for the site of record, nothing for records without
+     * one or when the build has no LOGPP_SOURCE_LOCATION.
+     */
+    static void appendLocation(const LogRecord &record, std::string &out);
+
+    /**
+     * File and function of the site as appendLocation and the JSON members print them, shortened
+     * when location.file=basename or location.function=short.
+     */
+    static std::string_view fileOf(const LogSite &site);
+
+    static std::string_view functionOf(const LogSite &site);
+
+    /**
+     * Set from location.file and location.function when the properties are published.
+     */
+    static void useLocation(bool basename, bool shortFunction);
+
+    /**
+     * Appends the fields of record as " key=value" pairs, strings quoted and escaped when they
+     * contain blanks, quotes, '=' or control characters.
+     */
+    static void appendFields(const LogRecord &record, std::string &out);
+
+    /**
+     * Appends the fields of record as JSON members, each preceded by a comma.
+     */
+    static void appendJsonFields(const LogRecord &record, std::string &out);
+
+    /**
+     * Upper case level name without padding or colors, "LOG" for log_verbose.
+     */
+    static std::string_view nameOf(Level l);
+
+    /**
+     * Reads level and epoch microseconds back from a line of renderFile or renderJson. False for
+     * anything else, such as the continuation lines of a multi-line message.
+     */
+    static bool parseHead(std::string_view line, Level &level, long &micros);
+
+    /**
+     * Message buffer of the record, for writers such as LogFormat that append to it directly.
+     */
+    LogBuffer &buffer() {
+        return _record.message;
+    }
+
+    /**
+     * Adds a typed field, written after the message as key=value in text lines and as a member of
+     * its own in JSON lines: LOG_INFO.kv("user_id", id).kv("latency_us", t) << "served".
+     */
+    template<class T>
+    Log &kv(std::string_view key, const T &value) {
+        LogFieldBuffer &fields = _record.fields;
+        if constexpr (std::is_same_v<T, bool>) {
+            LogFields::addBool(fields, key, value);
+        } else if constexpr (std::is_same_v<T, char>) {
+            LogFields::addString(fields, key, std::string_view(&value, 1));
+        } else if constexpr (std::is_integral_v<T> && std::is_signed_v<T>) {
+            LogFields::addInt(fields, key, value);
+        } else if constexpr (std::is_integral_v<T>) {
+            LogFields::addUint(fields, key, value);
+        } else if constexpr (std::is_floating_point_v<T>) {
+            LogFields::addDouble(fields, key, value);
+        } else if constexpr (std::is_same_v<T, const char *> || std::is_same_v<T, char *>) {
+            LogFields::addString(fields, key, value != nullptr ? std::string_view(value) : std::string_view("(null)"));
+        } else if constexpr (std::is_convertible_v<const T &, std::string_view>) {
+            LogFields::addString(fields, key, std::string_view(value));
+        } else {
+            std::ostringstream &ss = stream();
+            ss << value;
+            LogFields::addString(fields, key, ss.str());
+        }
+        return *this;
+    }
+
+    Log &operator<<(std::string_view v) {
+        _record.message.append(v);
+        return *this;
+    }
+
+    Log &operator<<(const std::string &v) {
+        _record.message.append(v);
+        return *this;
+    }
+
+    Log &operator<<(const char *v) {
+        _record.message.append(v != nullptr ? std::string_view(v) : std::string_view("(null)"));
+        return *this;
+    }
+
+    Log &operator<<(char v) {
+        _record.message.append(v);
+        return *this;
+    }
+
     template<class T>
     Log &operator<<(const T &v) {
-        std::stringstream ss;
-        ss << v;
-        _stream << ss.str();
-        _log_line += ss.str();
+        if constexpr (std::is_same_v<T, bool>) {
+            _record.message.append(v ? '1' : '0');
+        } else if constexpr (std::is_same_v<T, signed char> || std::is_same_v<T, unsigned char>) {
+            _record.message.append(static_cast<char>(v));
+        } else if constexpr (std::is_arithmetic_v<T>) {
+            _record.message.appendNumber(v);
+        } else if constexpr (std::is_convertible_v<const T &, std::string_view>) {
+            _record.message.append(std::string_view(v));
+        } else {
+            std::ostringstream &ss = stream();
+            ss << v;
+            _record.message.append(ss.str());
+        }
         return *this;
     }
 };
 
 
-#define LOG_INFO  Log(__FILE__, __PRETTY_FUNCTION__, __LINE__, log_info)
-#define LOG_WARN  Log(__FILE__, __PRETTY_FUNCTION__, __LINE__, log_warning)
-#define LOG_TRACE Log(__FILE__, __PRETTY_FUNCTION__, __LINE__, log_trace)
-#define LOG_ERROR Log(__FILE__, __PRETTY_FUNCTION__, __LINE__, log_error)
-#define LOG_DEBUG Log(__FILE__, __PRETTY_FUNCTION__, __LINE__, log_debug)
-#define LOG Log(__FILE__, __FUNCTION__, __LINE__, log_verbose)
+/**
+ * The level check happens before the Log temporary exists, so a disabled statement neither builds
+ * the prefix nor evaluates the streamed operands. Below LOGPP_ACTIVE_LEVEL the statement is a
+ * discarded branch of the if constexpr and no code is generated for it. The macro ends in an open
+ * else, so an unbraced if (x) LOG_INFO << ...; else ... binds that else to the macro: brace the
+ * statement (GCC warns with -Wdangling-else).
+ */
+#define LOG_AT(func, l) \
+    if constexpr (!Log::isActive(l)) {} \
+    else if (static constexpr LogSite _logpp_site{__FILE__, func, __LINE__}; !Log::isEnabled(l, __FILE__)) {} \
+    else Log(&_logpp_site, l)
+
+#define LOG_INFO  LOG_AT(__PRETTY_FUNCTION__, log_info)
+#define LOG_WARN  LOG_AT(__PRETTY_FUNCTION__, log_warning)
+#define LOG_TRACE LOG_AT(__PRETTY_FUNCTION__, log_trace)
+#define LOG_ERROR LOG_AT(__PRETTY_FUNCTION__, log_error)
+#define LOG_DEBUG LOG_AT(__PRETTY_FUNCTION__, log_debug)
+#define LOG LOG_AT(__FUNCTION__, log_verbose)
 
 #define NOW_TS Date::nowTime()
 
@@ -0,0 +1,155 @@
+// MIT License
+//
+// Copyright (c) 2023 Salomon Lee
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+#ifndef UTIL_LOG_BUFFER_HPP
+#define UTIL_LOG_BUFFER_HPP
+
+#include <charconv>
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <type_traits>
+
+/**
+ * Message text of one record. Up to INLINE_SIZE bytes live inside the object, longer messages move
+ * to the heap. Numbers are written with std::to_chars, so streaming operands allocates nothing for
+ * ordinary sized messages.
+ */
+template<size_t InlineSize>
+class BasicLogBuffer {
+public:
+    static constexpr size_t INLINE_SIZE = InlineSize;
+
+private:
+    char *_data;
+    size_t _size;
+    size_t _capacity;
+    char _inline[INLINE_SIZE];
+
+    void grow(size_t required);
+
+    char *reserve(size_t n) {
+        if (_size + n > _capacity)
+            grow(_size + n);
+        return _data + _size;
+    }
+
+public:
+    BasicLogBuffer() : _data(_inline), _size(0), _capacity(INLINE_SIZE) {}
+
+    BasicLogBuffer(const BasicLogBuffer &other);
+
+    BasicLogBuffer(BasicLogBuffer &&other) noexcept;
+
+    BasicLogBuffer &operator=(const BasicLogBuffer &other);
+
+    BasicLogBuffer &operator=(BasicLogBuffer &&other) noexcept;
+
+    ~BasicLogBuffer();
+
+    void append(const char *data, size_t n) {
+        std::memcpy(reserve(n), data, n);
+        _size += n;
+    }
+
+    void append(std::string_view v) {
+        append(v.data(), v.size());
+    }
+
+    void append(char c) {
+        *reserve(1) = c;
+        _size++;
+    }
+
+    template<class T>
+    std::enable_if_t<std::is_integral_v<T>> appendNumber(T v) {
+        char *first = reserve(24);
+        _size = std::to_chars(first, first + 24, v).ptr - _data;
+    }
+
+    /**
+     * Same text as std::ostream with its default precision of 6 significant digits.
+     */
+    template<class T>
+    std::enable_if_t<std::is_floating_point_v<T>> appendNumber(T v) {
+        char *first = reserve(32);
+        _size = std::to_chars(first, first + 32, v, std::chars_format::general, 6).ptr - _data;
+    }
+
+    template<class T>
+    std::enable_if_t<std::is_integral_v<T>> appendNumber(T v, int base) {
+        char *first = reserve(72);
+        _size = std::to_chars(first, first + 72, v, base).ptr - _data;
+    }
+
+    template<class T>
+    std::enable_if_t<std::is_floating_point_v<T>> appendNumber(T v, std::chars_format format, int precision) {
+        // Fixed notation of a large value can be long, the slow path sizes it exactly.
+        char *first = reserve(64);
+        auto result = std::to_chars(first, first + 64, v, format, precision);
+        if (result.ec == std::errc::value_too_large) {
+            first = reserve(400 + precision);
+            result = std::to_chars(first, first + 400 + precision, v, format, precision);
+        }
+        _size = result.ptr - _data;
+    }
+
+    void toUpper(size_t from) {
+        for (size_t i = from; i < _size; i++)
+            if (_data[i] >= 'a' && _data[i] <= 'z')
+                _data[i] = static_cast<char>(_data[i] - 'a' + 'A');
+    }
+
+    void clear() {
+        _size = 0;
+    }
+
+    [[nodiscard]] const char *data() const {
+        return _data;
+    }
+
+    [[nodiscard]] size_t size() const {
+        return _size;
+    }
+
+    [[nodiscard]] bool empty() const {
+        return _size == 0;
+    }
+
+    [[nodiscard]] std::string_view view() const {
+        return {_data, _size};
+    }
+};
+
+// Defined in LogBuffer.cpp for these sizes only.
+extern template class BasicLogBuffer<384>;
+extern template class BasicLogBuffer<128>;
+
+using LogBuffer = BasicLogBuffer<384>;
+
+/**
+ * Key-value fields of a record (LogFields.hpp), most statements carry only a few.
+ */
+using LogFieldBuffer = BasicLogBuffer<128>;
+
+#endif //UTIL_LOG_BUFFER_HPP
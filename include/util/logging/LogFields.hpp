@@ -0,0 +1,147 @@
+// MIT License
+//
+// Copyright (c) 2023 Salomon Lee
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+#ifndef UTIL_LOG_FIELDS_HPP
+#define UTIL_LOG_FIELDS_HPP
+
+#include <cstdint>
+#include <cstring>
+#include <string_view>
+#include <util/logging/LogBuffer.hpp>
+
+enum FieldType : uint8_t {
+    field_int = 'i',
+    field_uint = 'u',
+    field_double = 'd',
+    field_bool = 'b',
+    field_string = 's'
+};
+
+/**
+ * One decoded key-value field; the value member matching type is set, text points into the buffer.
+ */
+struct LogField {
+    std::string_view key;
+    FieldType type{field_string};
+    int64_t i{0};
+    uint64_t u{0};
+    double d{0};
+    bool b{false};
+    std::string_view text;
+};
+
+/**
+ * Typed key-value fields of a record, kept apart from the message so every sink can lay them out
+ * its own way. Each field is encoded as its type, the key length (keys are cut at 255 bytes), the
+ * key, then 8 bytes of value in native byte order or a 4 byte length and the text.
+ */
+class LogFields {
+private:
+    static void putKey(LogFieldBuffer &out, FieldType type, std::string_view key) {
+        size_t length = key.size() < 255 ? key.size() : 255;
+        out.append(static_cast<char>(type));
+        out.append(static_cast<char>(length));
+        out.append(key.data(), length);
+    }
+
+    template<class T>
+    static void putValue(LogFieldBuffer &out, T value) {
+        out.append(reinterpret_cast<const char *>(&value), sizeof(T));
+    }
+
+    template<class T>
+    static T getValue(const char *p) {
+        T value;
+        std::memcpy(&value, p, sizeof(T));
+        return value;
+    }
+
+public:
+    static void addInt(LogFieldBuffer &out, std::string_view key, int64_t value) {
+        putKey(out, field_int, key);
+        putValue(out, value);
+    }
+
+    static void addUint(LogFieldBuffer &out, std::string_view key, uint64_t value) {
+        putKey(out, field_uint, key);
+        putValue(out, value);
+    }
+
+    static void addDouble(LogFieldBuffer &out, std::string_view key, double value) {
+        putKey(out, field_double, key);
+        putValue(out, value);
+    }
+
+    static void addBool(LogFieldBuffer &out, std::string_view key, bool value) {
+        putKey(out, field_bool, key);
+        out.append(value ? '\1' : '\0');
+    }
+
+    static void addString(LogFieldBuffer &out, std::string_view key, std::string_view value) {
+        putKey(out, field_string, key);
+        putValue(out, static_cast<uint32_t>(value.size()));
+        out.append(value);
+    }
+
+    /**
+     * Calls visit with every field in the order they were added. Allocation free.
+     */
+    template<class Visit>
+    static void forEach(const LogFieldBuffer &fields, Visit visit) {
+        const char *p = fields.data();
+        const char *end = p + fields.size();
+        while (p + 2 <= end) {
+            LogField field;
+            field.type = static_cast<FieldType>(p[0]);
+            auto length = static_cast<unsigned char>(p[1]);
+            field.key = std::string_view(p + 2, length);
+            p += 2 + length;
+            switch (field.type) {
+                case field_int:
+                    field.i = getValue<int64_t>(p);
+                    p += 8;
+                    break;
+                case field_uint:
+                    field.u = getValue<uint64_t>(p);
+                    p += 8;
+                    break;
+                case field_double:
+                    field.d = getValue<double>(p);
+                    p += 8;
+                    break;
+                case field_bool:
+                    field.b = *p++ != 0;
+                    break;
+                default: {
+                    auto size = getValue<uint32_t>(p);
+                    field.text = std::string_view(p + 4, size);
+                    p += 4 + size;
+                    break;
+                }
+            }
+            visit(field);
+        }
+    }
+};
+
+#endif //UTIL_LOG_FIELDS_HPP
@@ -0,0 +1,223 @@
+// MIT License
+//
+// Copyright (c) 2023 Salomon Lee
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+#ifndef UTIL_LOG_FORMAT_HPP
+#define UTIL_LOG_FORMAT_HPP
+
+#include <cstddef>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+#include <util/logging/Log.hpp>
+
+#if !defined(__cpp_consteval)
+#error "util/logging/LogFormat.hpp needs a C++20 compiler with consteval support"
+#endif
+
+/**
+ * Parsed replacement field of a format string: the literal text in front of it and its spec.
+ * Supported specs are {} for any formattable type, {:x} / {:X} for integers and {:.Nf} / {:.Ne}
+ * for floating point values. {{ and }} stand for literal braces.
+ */
+struct FormatField {
+    size_t begin{};
+    size_t end{};
+    bool escaped{};
+    char kind{};
+    int precision{-1};
+};
+
+/**
+ * Format errors are reported by calling one of these from a consteval context, which makes the
+ * call a compile error naming the problem.
+ */
+struct FormatError {
+    static void moreArgumentsThanPlaceholders() {}
+    static void morePlaceholdersThanArguments() {}
+    static void unmatchedBrace() {}
+    static void unsupportedSpec() {}
+    static void hexSpecNeedsIntegerArgument() {}
+    static void precisionSpecNeedsFloatingPointArgument() {}
+};
+
+template<class T>
+constexpr bool isFormattable() {
+    using U = std::remove_cv_t<std::remove_reference_t<T>>;
+    return std::is_arithmetic_v<U> || std::is_convertible_v<const U &, std::string_view> ||
+           std::is_same_v<U, std::string>;
+}
+
+template<class... Args>
+class FormatString {
+private:
+    static constexpr bool INTEGRAL[sizeof...(Args) + 1] = {(std::is_integral_v<std::remove_cvref_t<Args>> &&
+                                                           !std::is_same_v<std::remove_cvref_t<Args>, bool> &&
+                                                           !std::is_same_v<std::remove_cvref_t<Args>, char>)..., false};
+    static constexpr bool FLOATING[sizeof...(Args) + 1] = {std::is_floating_point_v<std::remove_cvref_t<Args>>..., false};
+
+    consteval size_t parseSpec(size_t pos, size_t field) {
+        FormatField &f = _fields[field];
+        if (_str[pos] == '}')
+            return pos + 1;
+        if (_str[pos] != ':')
+            FormatError::unsupportedSpec();
+        pos++;
+        if (_str[pos] == 'x' || _str[pos] == 'X') {
+            if (!INTEGRAL[field])
+                FormatError::hexSpecNeedsIntegerArgument();
+            f.kind = _str[pos++];
+        } else if (_str[pos] == '.') {
+            pos++;
+            int precision = 0;
+            bool digits = false;
+            while (pos < _str.size() && _str[pos] >= '0' && _str[pos] <= '9') {
+                precision = precision * 10 + (_str[pos++] - '0');
+                digits = true;
+            }
+            if (!digits || pos >= _str.size() || (_str[pos] != 'f' && _str[pos] != 'e'))
+                FormatError::unsupportedSpec();
+            if (!FLOATING[field])
+                FormatError::precisionSpecNeedsFloatingPointArgument();
+            f.kind = _str[pos++];
+            f.precision = precision;
+        } else {
+            FormatError::unsupportedSpec();
+        }
+        if (pos >= _str.size() || _str[pos] != '}')
+            FormatError::unsupportedSpec();
+        return pos + 1;
+    }
+
+public:
+    std::string_view _str;
+    FormatField _fields[sizeof...(Args) + 1]{};
+
+    template<size_t N>
+    consteval FormatString(const char (&s)[N]) : _str(s, N - 1) {
+        size_t field = 0;
+        size_t begin = 0;
+        bool escaped = false;
+        size_t pos = 0;
+        while (pos < _str.size()) {
+            char c = _str[pos];
+            if (c == '{' && pos + 1 < _str.size() && _str[pos + 1] == '{') {
+                escaped = true;
+                pos += 2;
+            } else if (c == '}' && pos + 1 < _str.size() && _str[pos + 1] == '}') {
+                escaped = true;
+                pos += 2;
+            } else if (c == '}') {
+                FormatError::unmatchedBrace();
+            } else if (c == '{') {
+                if (pos + 1 >= _str.size())
+                    FormatError::unmatchedBrace();
+                if (field == sizeof...(Args))
+                    FormatError::morePlaceholdersThanArguments();
+                _fields[field].begin = begin;
+                _fields[field].end = pos;
+                _fields[field].escaped = escaped;
+                pos = parseSpec(pos + 1, field);
+                field++;
+                begin = pos;
+                escaped = false;
+            } else {
+                pos++;
+            }
+        }
+        if (field != sizeof...(Args))
+            FormatError::moreArgumentsThanPlaceholders();
+        _fields[field].begin = begin;
+        _fields[field].end = _str.size();
+        _fields[field].escaped = escaped;
+    }
+};
+
+/**
+ * Writes {}-style formatted messages into a Log record. The format string is parsed and checked
+ * against the argument types at compile time; at run time only the literal pieces and the
+ * arguments are appended.
+ */
+class LogFormat {
+private:
+    static void appendLiteral(LogBuffer &buffer, std::string_view str, const FormatField &field) {
+        if (!field.escaped) {
+            buffer.append(str.data() + field.begin, field.end - field.begin);
+            return;
+        }
+        for (size_t i = field.begin; i < field.end; i++) {
+            buffer.append(str[i]);
+            if ((str[i] == '{' || str[i] == '}') && i + 1 < field.end && str[i + 1] == str[i])
+                i++;
+        }
+    }
+
+    template<class T>
+    static void appendArgument(Log &log, const FormatField &field, const T &v) {
+        using U = std::remove_cvref_t<T>;
+        if constexpr (std::is_integral_v<U> && !std::is_same_v<U, bool> && !std::is_same_v<U, char>) {
+            if (field.kind == 'x' || field.kind == 'X') {
+                LogBuffer &buffer = log.buffer();
+                size_t start = buffer.size();
+                buffer.appendNumber(v, 16);
+                if (field.kind == 'X')
+                    buffer.toUpper(start);
+                return;
+            }
+        } else if constexpr (std::is_floating_point_v<U>) {
+            if (field.kind == 'f' || field.kind == 'e') {
+                log.buffer().appendNumber(v, field.kind == 'f' ? std::chars_format::fixed : std::chars_format::scientific,
+                                          field.precision);
+                return;
+            }
+        }
+        log << v;
+    }
+
+    template<class... Args, size_t... I>
+    static void write(Log &log, const FormatString<Args...> &fmt, std::index_sequence<I...>, const Args &... args) {
+        ((appendLiteral(log.buffer(), fmt._str, fmt._fields[I]), appendArgument(log, fmt._fields[I], args)), ...);
+        appendLiteral(log.buffer(), fmt._str, fmt._fields[sizeof...(Args)]);
+    }
+
+public:
+    template<class... Args>
+    static void write(Log &&log, FormatString<std::type_identity_t<Args>...> fmt, const Args &... args) {
+        static_assert((isFormattable<Args>() && ...), "LOG_*F argument has no {} formatting, use the << stream API");
+        write(log, fmt, std::index_sequence_for<Args...>{}, args...);
+    }
+};
+
+#define LOG_AT_F(func, l, fmt, ...) \
+    if constexpr (!Log::isActive(l)) {} \
+    else if (static constexpr LogSite _logpp_site{__FILE__, func, __LINE__}; !Log::isEnabled(l, __FILE__)) {} \
+    else LogFormat::write(Log(&_logpp_site, l), fmt __VA_OPT__(,) __VA_ARGS__)
+
+#define LOG_INFOF(fmt, ...)  LOG_AT_F(__PRETTY_FUNCTION__, log_info, fmt __VA_OPT__(,) __VA_ARGS__)
+#define LOG_WARNF(fmt, ...)  LOG_AT_F(__PRETTY_FUNCTION__, log_warning, fmt __VA_OPT__(,) __VA_ARGS__)
+#define LOG_TRACEF(fmt, ...) LOG_AT_F(__PRETTY_FUNCTION__, log_trace, fmt __VA_OPT__(,) __VA_ARGS__)
+#define LOG_ERRORF(fmt, ...) LOG_AT_F(__PRETTY_FUNCTION__, log_error, fmt __VA_OPT__(,) __VA_ARGS__)
+#define LOG_DEBUGF(fmt, ...) LOG_AT_F(__PRETTY_FUNCTION__, log_debug, fmt __VA_OPT__(,) __VA_ARGS__)
+#define LOGF(fmt, ...)       LOG_AT_F(__FUNCTION__, log_verbose, fmt __VA_OPT__(,) __VA_ARGS__)
+
+#endif //UTIL_LOG_FORMAT_HPP
@@ -0,0 +1,111 @@
+// MIT License
+//
+// Copyright (c) 2023 Salomon Lee
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+#ifndef UTIL_LOG_LEVELS_HPP
+#define UTIL_LOG_LEVELS_HPP
+
+#include <atomic>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <util/logging/Level.hpp>
+
+/**
+ * Levels in effect: the global level and the module overrides from level.<module> entries or
+ * Logger::setLevel. The named loggers take their level from the same entries. A module is a
+ * directory or a source file name without extension, with dots for nested directories
+ * (level.net.http); the longest module found in the path of a call site wins. Below the source
+ * root (source.root) the whole path relative to it is searched; other paths are only matched
+ * against the file name and the directories right above it, so the directories of a checkout or
+ * build tree do not pass for modules.
+ *
+ * The tables are immutable and swapped like the LogProperties snapshots. The LOG_* macros load
+ * the union of every enabled level, and only when overrides exist and the level is in that union
+ * resolve the site's file, once per thread, file and table.
+ */
+class LogLevels {
+public:
+    /**
+     * Bit of enabled() that says some module has a level of its own.
+     */
+    static constexpr unsigned OVERRIDDEN = 1u << 31;
+
+private:
+    struct Table {
+        Level level;
+        std::map<std::string, Level> modules;
+        std::string root;
+        std::vector<std::pair<std::vector<std::string>, unsigned>> paths;
+        unsigned mask;
+
+        Table(Level level, std::map<std::string, Level> modules, std::string root);
+
+        [[nodiscard]] unsigned resolve(const char *file) const;
+    };
+
+    static std::atomic<const Table *> _table;
+    static std::atomic<unsigned> _enabled;
+    static std::mutex _mutex;
+    static std::vector<std::unique_ptr<const Table>> _retired;
+
+    static void publish(Table *table);
+
+public:
+    /**
+     * Level bits let through by level: all but silent and stealth for log_verbose, otherwise the
+     * level itself and log_verbose.
+     */
+    static unsigned maskOf(Level level);
+
+    static unsigned enabled() {
+        return _enabled.load(std::memory_order_relaxed);
+    }
+
+    /**
+     * Resolution of a call site when enabled() has OVERRIDDEN set.
+     */
+    static bool isEnabled(Level l, const char *file);
+
+    /**
+     * Replaces every level and the source root, called when a LogProperties snapshot is published.
+     */
+    static void configure(Level level, const std::map<std::string, Level> &modules, const std::string &root);
+
+    static void setLevel(Level level);
+
+    static void setLevel(const std::string &module, Level level);
+
+    static void clearLevel(const std::string &module);
+
+    static Level getLevel();
+
+    /**
+     * Level of module, or of the longest module above it, or the global level.
+     */
+    static Level getLevel(const std::string &module);
+};
+
+#endif //UTIL_LOG_LEVELS_HPP
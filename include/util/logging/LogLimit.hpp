@@ -0,0 +1,143 @@
+// MIT License
+//
+// Copyright (c) 2023 Salomon Lee
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+#ifndef UTIL_LOG_LIMIT_HPP
+#define UTIL_LOG_LIMIT_HPP
+
+#include <atomic>
+#include <cstdint>
+#include <util/logging/Level.hpp>
+#include <util/logging/Log.hpp>
+
+/**
+ * State of one rate limited statement, a function local static of the LOG_EVERY_N, LOG_FIRST_N,
+ * LOG_RATE and LOG_SAMPLED macros. Deciding whether a statement goes out takes a relaxed atomic
+ * (one CAS for LOG_RATE) and no lock. Suppressed statements are counted per site and reported as
+ * one summary line per site every limit.report.ms, by the next suppression or by FlushTimer when
+ * the statements have stopped, and on SinkRegistry::flush and exit.
+ */
+class LogLimit {
+private:
+    static std::atomic<LogLimit *> _sites;
+    static std::atomic<long> _next_report;
+
+    LogSite _site;
+    Level _level;
+    LogLimit *_next{nullptr};
+    std::atomic<uint64_t> _count{0};
+    std::atomic<int64_t> _tat{0};
+    std::atomic<uint64_t> _suppressed{0};
+
+    void suppress();
+
+    static int64_t monotonicNs(bool coarse);
+
+    static uint64_t random();
+
+public:
+    LogLimit(const LogSite &site, Level level);
+
+    LogLimit(const LogLimit &) = delete;
+
+    LogLimit &operator=(const LogLimit &) = delete;
+
+    /**
+     * True for the first of every n statements.
+     */
+    bool everyN(uint64_t n) {
+        if (n <= 1 || _count.fetch_add(1, std::memory_order_relaxed) % n == 0)
+            return true;
+        suppress();
+        return false;
+    }
+
+    /**
+     * True for the first n statements only.
+     */
+    bool firstN(uint64_t n) {
+        if (_count.load(std::memory_order_relaxed) < n && _count.fetch_add(1, std::memory_order_relaxed) < n)
+            return true;
+        suppress();
+        return false;
+    }
+
+    /**
+     * Token bucket of perSecond tokens refilled continuously, holding at most one second's worth.
+     */
+    bool perSecond(double perSecond);
+
+    /**
+     * True with probability p.
+     */
+    bool sample(double p) {
+        if (static_cast<double>(random() >> 11) * 0x1.0p-53 < p)
+            return true;
+        suppress();
+        return false;
+    }
+
+    [[nodiscard]] const LogSite *getSite() const {
+        return &_site;
+    }
+
+    /**
+     * Statements suppressed at this site since the last summary.
+     */
+    [[nodiscard]] uint64_t getSuppressed() const {
+        return _suppressed.load(std::memory_order_relaxed);
+    }
+
+    /**
+     * Writes the summary line of every site with suppressed statements now, instead of waiting for
+     * the next limit.report.ms interval.
+     */
+    static void report();
+
+    /**
+     * report() if limit.report.ms has elapsed since the last summaries.
+     */
+    static void reportIfDue();
+
+    /**
+     * True once a statement has been suppressed, from then on summaries are due periodically.
+     */
+    static bool isReporting() {
+        return _next_report.load(std::memory_order_relaxed) != 0;
+    }
+};
+
+
+#define LOG_LIMITED(func, l, allow) \
+    if constexpr (!Log::isActive(l)) {} \
+    else if (static LogLimit _logpp_limit({__FILE__, func, __LINE__}, l); !Log::isEnabled(l, __FILE__) || !_logpp_limit.allow) {} \
+    else Log(_logpp_limit.getSite(), l)
+
+/**
+ * LOG_EVERY_N(log_warning, 1000) << "queue full"; logs the 1st, 1001st, 2001st... statement.
+ */
+#define LOG_EVERY_N(l, n)         LOG_LIMITED(__PRETTY_FUNCTION__, l, everyN(n))
+#define LOG_FIRST_N(l, n)         LOG_LIMITED(__PRETTY_FUNCTION__, l, firstN(n))
+#define LOG_RATE(l, n)            LOG_LIMITED(__PRETTY_FUNCTION__, l, perSecond(n))
+#define LOG_SAMPLED(l, p)         LOG_LIMITED(__PRETTY_FUNCTION__, l, sample(p))
+
+#endif //UTIL_LOG_LIMIT_HPP
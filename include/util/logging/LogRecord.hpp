@@ -0,0 +1,51 @@
+// MIT License
+//
+// Copyright (c) 2023 Salomon Lee
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+#ifndef UTIL_LOG_RECORD_HPP
+#define UTIL_LOG_RECORD_HPP
+
+#include <ctime>
+#include <util/logging/Level.hpp>
+#include <util/logging/LogBuffer.hpp>
+#include <util/logging/LogSite.hpp>
+
+class Logger;
+
+/**
+ * Everything a statement captured. The console and file lines are rendered from it by the writer,
+ * site is the static location of the statement, nullptr for lines the library writes itself, the
+ * message holds the streamed operands, fields the encoded key-value pairs of kv() (LogFields),
+ * logger the named Logger of the statement, nullptr for the LOG_* macros.
+ */
+struct LogRecord {
+    Level level{log_verbose};
+    const LogSite *site{nullptr};
+    timespec time{};
+    char thread[32]{};
+    size_t thread_length{};
+    LogBuffer message;
+    LogFieldBuffer fields;
+    const Logger *logger{nullptr};
+};
+
+#endif //UTIL_LOG_RECORD_HPP
@@ -0,0 +1,82 @@
+// MIT License
+//
+// Copyright (c) 2023 Salomon Lee
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+#ifndef UTIL_LOG_RING_HPP
+#define UTIL_LOG_RING_HPP
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <util/logging/LogRecord.hpp>
+
+/**
+ * Bounded lock-free queue of LogRecord slots (Vyukov's sequenced ring). Any number of threads may
+ * push; the async writer is the regular consumer, producers only pop to make room under
+ * drop-oldest. Slots are allocated once up front and records are moved in and out of them.
+ */
+class LogRing {
+private:
+    struct Cell {
+        std::atomic<size_t> sequence;
+        LogRecord record;
+    };
+
+    std::unique_ptr<Cell[]> _cells;
+    size_t _mask;
+    alignas(64) std::atomic<size_t> _enqueue_pos{0};
+    alignas(64) std::atomic<size_t> _dequeue_pos{0};
+
+public:
+    explicit LogRing(size_t capacity);
+
+    LogRing(const LogRing &) = delete;
+
+    LogRing &operator=(const LogRing &) = delete;
+
+    bool tryPush(LogRecord &record);
+
+    bool tryPop(LogRecord &record);
+
+    [[nodiscard]] size_t capacity() const;
+
+    [[nodiscard]] size_t enqueued() const;
+
+    [[nodiscard]] bool empty() const;
+
+    /**
+     * Calls visit on the records pushed and not yet popped, oldest first, leaving them in place.
+     * Lock and allocation free for the crash handler; a concurrent pop may tear a record.
+     */
+    template<class Visit>
+    void forEachPending(Visit visit) const {
+        size_t pos = _dequeue_pos.load(std::memory_order_acquire);
+        for (size_t n = 0; n <= _mask; n++, pos++) {
+            const Cell &cell = _cells[pos & _mask];
+            if (cell.sequence.load(std::memory_order_acquire) != pos + 1)
+                break;
+            visit(cell.record);
+        }
+    }
+};
+
+#endif //UTIL_LOG_RING_HPP
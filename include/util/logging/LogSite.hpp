@@ -0,0 +1,53 @@
+// MIT License
+//
+// Copyright (c) 2023 Salomon Lee
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+
+#ifndef UTIL_LOG_SITE_HPP
+#define UTIL_LOG_SITE_HPP
+
+#include <string_view>
+
+/**
+ * Where a statement is. The LOG_* macros keep one as a static constexpr per call site and records
+ * point at it, so a statement copies nothing of its location; sinks that print it render it from
+ * the pointer when they write the line.
+ */
+struct LogSite {
+    const char *file;
+    const char *function;
+    long line;
+
+    /**
+     * File name without its directories, "Log.cpp" for "/src/util/logging/Log.cpp".
+     */
+    static std::string_view basename(std::string_view file);
+
+    /**
+     * Qualified name of a __PRETTY_FUNCTION__ without its return type, parameters, qualifiers and
+     * GCC's [with T = ...] suffix, "Pool::get" for "virtual Connection* Pool::get(int) const".
+     * Names it cannot make sense of are returned whole.
+     */
+    static std::string_view shortFunction(std::string_view function);
+};
+
+#endif //UTIL_LOG_SITE_HPP
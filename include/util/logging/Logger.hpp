@@ -0,0 +1,126 @@
+// MIT License
+//
+// Copyright (c) 2023 Salomon Lee
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+#ifndef UTIL_LOGGER_HPP
+#define UTIL_LOGGER_HPP
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include <util/logging/Level.hpp>
+#include <util/logging/Log.hpp>
+
+/**
+ * Named logger of a subsystem, e.g. Logger::get("db.pool"). Its level comes from the nearest
+ * level.<name> entry up the dotted name (level.db.pool, level.db, then level) and its sinks from
+ * the nearest sinks.<name> entry (then sinks). Loggers live until the process exits, so call sites
+ * resolve them once and keep the pointer; the level check is one relaxed load on the logger.
+ *
+ * The static members change the levels at runtime, without restarting and without touching the
+ * property file. Changes stay in effect until the next LogProperties::reload, which sets every
+ * level from the file again. Levels given to a name apply to the logger of that name and to the
+ * source module of the same name ("net.http" for the files under net/http/).
+ */
+class Logger {
+private:
+    static std::mutex _mutex;
+    static std::vector<std::unique_ptr<Logger>> _loggers;
+    static std::unordered_map<std::string, Logger *> _by_name;
+
+    std::string _name;
+    size_t _id;
+    std::atomic<unsigned> _levels;
+
+    Logger(std::string name, size_t id);
+
+public:
+    /**
+     * Logger of name, created on the first request; the empty name is the root logger.
+     */
+    static Logger *get(const std::string &name);
+
+    /**
+     * Names of the loggers so far, indexed by id.
+     */
+    static std::vector<std::string> names();
+
+    /**
+     * Recomputes the level of every logger, called when LogLevels publishes new levels.
+     */
+    static void refreshLevels();
+
+    [[nodiscard]] const std::string &getName() const {
+        return _name;
+    }
+
+    [[nodiscard]] size_t getId() const {
+        return _id;
+    }
+
+    [[nodiscard]] bool isEnabled(Level l) const {
+        return _levels.load(std::memory_order_relaxed) & (1u << l);
+    }
+
+    static void setLevel(Level level);
+
+    /**
+     * Gives the logger or module name and the ones below it a level of their own, e.g. log_debug
+     * for "net" while the rest of the process stays at log_error.
+     */
+    static void setLevel(const std::string &name, Level level);
+
+    /**
+     * Puts name back under the level of the name above it or the global level.
+     */
+    static void clearLevel(const std::string &name);
+
+    static Level getLevel();
+
+    static Level getLevel(const std::string &name);
+
+    /**
+     * Names the calling thread in the thx-id field of its lines as "<tid>:<name>" and in the
+     * kernel, e.g. Logger::setThreadName("http-3") first thing in a worker.
+     */
+    static void setThreadName(const std::string &name);
+};
+
+
+/**
+ * LOGGER_INFO(pool) << "connections: " << n; with Logger *pool = Logger::get("db.pool").
+ */
+#define LOGGER_AT(logger, func, l) \
+    if constexpr (!Log::isActive(l)) {} \
+    else if (static constexpr LogSite _logpp_site{__FILE__, func, __LINE__}; !(logger)->isEnabled(l)) {} \
+    else Log(&_logpp_site, l, logger)
+
+#define LOGGER_INFO(logger)  LOGGER_AT(logger, __PRETTY_FUNCTION__, log_info)
+#define LOGGER_WARN(logger)  LOGGER_AT(logger, __PRETTY_FUNCTION__, log_warning)
+#define LOGGER_TRACE(logger) LOGGER_AT(logger, __PRETTY_FUNCTION__, log_trace)
+#define LOGGER_ERROR(logger) LOGGER_AT(logger, __PRETTY_FUNCTION__, log_error)
+#define LOGGER_DEBUG(logger) LOGGER_AT(logger, __PRETTY_FUNCTION__, log_debug)
+
+#endif //UTIL_LOGGER_HPP
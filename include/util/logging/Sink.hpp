@@ -0,0 +1,88 @@
+// MIT License
+//
+// Copyright (c) 2023 Salomon Lee
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+#ifndef UTIL_SINK_HPP
+#define UTIL_SINK_HPP
+
+#include <atomic>
+#include <string>
+#include <string_view>
+#include <util/logging/Level.hpp>
+#include <util/logging/LogRecord.hpp>
+#include <util/logging/SinkFormat.hpp>
+
+/**
+ * Destination of log records. Each sink has its own minimum level and asks the SinkRegistry for one
+ * of the shared renderings, or renders itself with format_custom.
+ */
+class Sink {
+private:
+    std::string _name;
+    SinkFormat _format;
+    std::atomic<Level> _min_level;
+
+public:
+    Sink(std::string name, SinkFormat format, Level minLevel = log_verbose);
+
+    virtual ~Sink() = default;
+
+    const std::string &getName() const;
+
+    SinkFormat getFormat() const;
+
+    Level getMinLevel() const;
+
+    /**
+     * Lowest level the sink writes: trace < debug < info, verbose (LOG) < warning < error.
+     * log_verbose accepts everything, log_silent and log_stealth nothing.
+     */
+    void setMinLevel(Level minLevel);
+
+    bool accepts(Level level) const;
+
+    static int severityOf(Level level);
+
+    /**
+     * Renders record for format_custom sinks.
+     */
+    virtual void format(const LogRecord &record, std::string &out);
+
+    /**
+     * Writes one or more rendered records; level is log_error when any of them is an error.
+     */
+    virtual void write(std::string_view text, Level level) = 0;
+
+    virtual void flush() {}
+
+    /**
+     * Called by the async writer while idle, for time based flush policies.
+     */
+    virtual void flushIfDue() {}
+
+    /**
+     * Writes already rendered text using async-signal-safe calls only, for the CrashHandler.
+     */
+    virtual void crashWrite(std::string_view) {}
+};
+
+#endif //UTIL_SINK_HPP
@@ -0,0 +1,141 @@
+// MIT License
+//
+// Copyright (c) 2023 Salomon Lee
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+#ifndef UTIL_SINK_REGISTRY_HPP
+#define UTIL_SINK_REGISTRY_HPP
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+#include <util/logging/Sink.hpp>
+
+class LogProperties;
+
+/**
+ * Set of sinks every record is fanned out to: the ones named by the sinks property of the current
+ * LogProperties followed by the ones added in code. The set is an immutable snapshot, replaced on
+ * add, remove and properties reload, so writers never take a lock to read it.
+ */
+class SinkRegistry {
+public:
+    /**
+     * routes holds the indexes into sinks of every named Logger by id, routes[0] those of the LOG_*
+     * macros and of the loggers without a sinks.<name> entry above them.
+     */
+    struct Snapshot {
+        const LogProperties *properties;
+        std::vector<std::shared_ptr<Sink>> sinks;
+        std::vector<std::vector<size_t>> routes;
+
+        [[nodiscard]] const std::vector<size_t> &routeOf(const LogRecord &record) const;
+    };
+
+    /**
+     * Renders records for the sinks of one snapshot, once per format, and hands each sink all of
+     * its text in a single write on commit().
+     */
+    class Batch {
+    private:
+        const Snapshot *_snapshot{nullptr};
+        std::vector<std::string> _pending;
+        std::vector<Level> _levels;
+        std::string _rendered[format_custom];
+
+        void reset(const Snapshot *snapshot);
+
+    public:
+        void add(const LogRecord &record);
+
+        void commit();
+
+        /**
+         * commit() for the crash handler, through Sink::crashWrite.
+         */
+        void crashCommit();
+    };
+
+private:
+    std::atomic<const Snapshot *> _current{nullptr};
+    std::mutex _mutex;
+    std::vector<std::shared_ptr<Sink>> _added;
+    std::vector<std::unique_ptr<const Snapshot>> _retired;
+
+    SinkRegistry() = default;
+
+    const Snapshot *rebuild(const LogProperties *properties);
+
+    /**
+     * Sink for a name of the sinks property. A dedup stage of previous is reused when previous was
+     * built from the same properties.
+     */
+    static std::shared_ptr<Sink> configured(const LogProperties *properties, const std::string &name,
+                                            const Snapshot *previous);
+
+    static void route(Snapshot *snapshot, const Snapshot *previous);
+
+public:
+    static SinkRegistry *instance();
+
+    /**
+     * Sinks for the current LogProperties.
+     */
+    const Snapshot *current();
+
+    /**
+     * Snapshot in use without checking for a reload, nullptr before the first record. Safe to call
+     * from a signal handler.
+     */
+    const Snapshot *published() const;
+
+    void add(const std::shared_ptr<Sink> &sink);
+
+    /**
+     * Rebuilds the snapshot for the loggers created since, called by Logger::get.
+     */
+    void reroute();
+
+    /**
+     * Removes every sink added in code under name, configured sinks go through the sinks property.
+     */
+    void remove(const std::string &name);
+
+    std::shared_ptr<Sink> find(const std::string &name);
+
+    /**
+     * Renders and writes a single record.
+     */
+    void write(const LogRecord &record);
+
+    /**
+     * Writes the pending rate limit summaries, then flushes every sink.
+     */
+    void flush();
+
+    void flushIfDue();
+
+    static void render(SinkFormat format, const LogRecord &record, std::string &out);
+};
+
+#endif //UTIL_SINK_REGISTRY_HPP
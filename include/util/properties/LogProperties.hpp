@@ -25,10 +25,19 @@
 #define UTIL_LOG_PROPERTIES_HPP
 
 #include <util/logging/Level.hpp>
+#include <util/logging/LogLevels.hpp>
+#include <util/logging/Overflow.hpp>
 
 #include <string>
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <map>
+#include <vector>
 #include <util/fio/LogAppender.hpp>
+#include <util/fio/MappedLog.hpp>
 #include <util/fio/PropertiesReader.hpp>
+#include <logconfig.h>
 
 class LogProperties {
 private:
@@ -37,14 +46,59 @@ private:
     std::string _log_file;
     std::string _max_sz;
     int _rollover_limit{};
-//    LogAppender *_log_appender;
+    bool _async{};
+    bool _buffered{};
+    long _async_capacity{8192};
+    Overflow _overflow{overflow_block};
+    Flush _flush{flush_line};
+    long _flush_bytes{64 * KB};
+    long _flush_ms{1000};
+    Codec _compression{codec_gzip};
+    int _compression_level{-1};
+    int _compression_workers{2};
+    bool _coarse_clock{};
+    bool _location_basename{};
+    bool _location_short_function{};
+    bool _io_uring{};
+    int _io_buffers{8};
+    long _io_buffer_size{256 * KB};
+    long _io_fsync_ms{0};
+    bool _mmap{};
+    long _msync_ms{0};
+    bool _crash_handler{};
+    bool _crash_backtrace{true};
+    long _limit_report_ms{10000};
+    bool _dedup{};
+    long _dedup_timeout_ms{5000};
+    std::string _binary_file;
+    std::string _json_file;
+    std::vector<std::string> _sinks{"console", "file"};
+    std::map<std::string, Level> _sink_levels;
+    std::map<std::string, Level> _module_levels;
+    std::string _source_root;
+    std::map<std::string, std::vector<std::string>> _logger_sinks;
+    std::string _property_file;
+    bool _watch{};
+    mutable std::atomic<LogAppender *> _log_appender{nullptr};
+    mutable std::atomic<LogAppender *> _binary_appender{nullptr};
+    mutable std::atomic<LogAppender *> _json_appender{nullptr};
+
+    static std::atomic<const LogProperties *> _instance;
+    static std::mutex _reload_mutex;
+    static std::vector<std::unique_ptr<const LogProperties>> _retired;
 
     Level toLogLevel(std::string level);
 
+    static const LogProperties *publish(const LogProperties *properties);
+
+    static long toBytes(const std::string &size, long fallback);
+
     void setProperties(const PropertiesReader& config);
 
     void setProperties();
 
+    LogAppender *appenderFor(const std::string &file, Flush flush, std::atomic<LogAppender *> &cache) const;
+
 //    void initLogAppender();
 
 public:
@@ -61,6 +115,11 @@ public:
 
     [[nodiscard]] Level getLogLevel() const;
 
+    /**
+     * Bit set of the levels that reach the outputs under the configured level, one bit per Level.
+     */
+    [[nodiscard]] unsigned getEnabledLevels() const;
+
     void setLogLevel(const std::string &logLevel);
 
     [[nodiscard]] const std::string &getLogPath() const;
@@ -79,9 +138,238 @@ public:
 
     void setRolloverLimit(const std::string &mRolloverFileQty);
 
-    long getMaxSzBytes();
+    [[nodiscard]] long getMaxSzBytes() const;
+
+    [[nodiscard]] bool isAsync() const;
+
+    void setAsync(const std::string &async);
+
+    /**
+     * File sinks collect lines per thread and hand them to a single writer (BatchLogWriter).
+     */
+    [[nodiscard]] bool isBuffered() const;
+
+    void setBuffered(const std::string &buffered);
+
+    [[nodiscard]] long getAsyncCapacity() const;
+
+    void setAsyncCapacity(const std::string &asyncCapacity);
+
+    [[nodiscard]] Overflow getOverflow() const;
+
+    void setOverflow(const std::string &overflow);
+
+    [[nodiscard]] Flush getFlush() const;
+
+    void setFlush(const std::string &flush);
+
+    [[nodiscard]] long getFlushBytes() const;
+
+    void setFlushBytes(const std::string &flushBytes);
+
+    [[nodiscard]] long getFlushMs() const;
+
+    void setFlushMs(const std::string &flushMs);
+
+    [[nodiscard]] Codec getCompression() const;
+
+    void setCompression(const std::string &compression);
+
+    [[nodiscard]] int getCompressionLevel() const;
+
+    void setCompressionLevel(const std::string &compressionLevel);
+
+    [[nodiscard]] int getCompressionWorkers() const;
+
+    void setCompressionWorkers(const std::string &compressionWorkers);
+
+    [[nodiscard]] bool isCoarseClock() const;
+
+    void setClock(const std::string &clock);
+
+    /**
+     * location.file=basename prints the file of a statement without its directories,
+     * location.file=full (the default) as the compiler gave it.
+     */
+    [[nodiscard]] bool isLocationBasename() const;
+
+    void setLocationFile(const std::string &locationFile);
+
+    /**
+     * location.function=short prints the qualified name of the function only (LogSite::shortFunction),
+     * location.function=full (the default) its whole signature.
+     */
+    [[nodiscard]] bool isLocationShortFunction() const;
+
+    void setLocationFunction(const std::string &locationFunction);
+
+    /**
+     * io=uring writes log files through io_uring (UringWriter) when the kernel supports it,
+     * io=write (the default) with write()/writev().
+     */
+    [[nodiscard]] bool isIoUring() const;
+
+    void setIo(const std::string &io);
+
+    [[nodiscard]] int getIoBuffers() const;
+
+    void setIoBuffers(const std::string &ioBuffers);
+
+    [[nodiscard]] long getIoBufferSize() const;
+
+    void setIoBufferSize(const std::string &ioBufferSize);
+
+    /**
+     * Minimum interval between fdatasync calls on the log files, 0 leaves it to the kernel.
+     */
+    [[nodiscard]] long getIoFsyncMs() const;
+
+    void setIoFsyncMs(const std::string &ioFsyncMs);
+
+    /**
+     * mmap=true writes the file sinks into preallocated, mapped segments (MappedLog) instead of
+     * through a LogAppender.
+     */
+    [[nodiscard]] bool isMmap() const;
+
+    void setMmap(const std::string &mmap);
+
+    /**
+     * Minimum interval between msync calls on the mapped segments, 0 leaves it to the kernel.
+     */
+    [[nodiscard]] long getMsyncMs() const;
+
+    void setMsyncMs(const std::string &msyncMs);
+
+    /**
+     * crash.handler=true installs the CrashHandler, which writes out buffered records on a fatal
+     * signal; crash.backtrace adds the stack to its final record.
+     */
+    [[nodiscard]] bool isCrashHandler() const;
+
+    void setCrashHandler(const std::string &crashHandler);
+
+    [[nodiscard]] bool isCrashBacktrace() const;
+
+    void setCrashBacktrace(const std::string &crashBacktrace);
+
+    /**
+     * Interval of the summary lines of statements suppressed by LOG_EVERY_N and the other LogLimit
+     * macros, 0 counts them without reporting.
+     */
+    [[nodiscard]] long getLimitReportMs() const;
+
+    void setLimitReportMs(const std::string &limitReportMs);
+
+    /**
+     * dedup=true puts a DedupSink in front of the console, file and json sinks, which writes runs
+     * of identical records as one line and a repeat count at most every dedup.timeout.ms.
+     */
+    [[nodiscard]] bool isDedup() const;
+
+    void setDedup(const std::string &dedup);
+
+    [[nodiscard]] long getDedupTimeoutMs() const;
+
+    void setDedupTimeoutMs(const std::string &dedupTimeoutMs);
+
+    /**
+     * File of the binary log macros, the log file name with a .bin extension unless set.
+     */
+    [[nodiscard]] std::string getBinaryFile() const;
+
+    void setBinaryFile(const std::string &binaryFile);
+
+    /**
+     * File of the json sink, the log file name with a .json extension unless set.
+     */
+    [[nodiscard]] std::string getJsonFile() const;
+
+    void setJsonFile(const std::string &jsonFile);
+
+    /**
+     * Names of the configured sinks (console, file, json, binary, null), console and file by default.
+     */
+    [[nodiscard]] const std::vector<std::string> &getSinks() const;
+
+    void setSinks(const std::string &sinks);
+
+    /**
+     * Minimum level of the named sink from sink.<name>.level, log_verbose (everything) if unset.
+     */
+    [[nodiscard]] Level getSinkLevel(const std::string &sink) const;
+
+    void setSinkLevel(const std::string &sink, const std::string &level);
+
+    /**
+     * Sinks of the named loggers from sinks.<logger> entries, inherited by the loggers below them.
+     */
+    [[nodiscard]] const std::map<std::string, std::vector<std::string>> &getLoggerSinks() const;
+
+    void setLoggerSinks(const std::string &logger, const std::string &sinks);
+
+    /**
+     * Levels of the modules and named loggers from level.<module> entries, see LogLevels.
+     */
+    [[nodiscard]] const std::map<std::string, Level> &getModuleLevels() const;
+
+    void setModuleLevel(const std::string &module, const std::string &level);
+
+    /**
+     * Directory the level.<module> entries are relative to, empty when unset, see LogLevels.
+     */
+    [[nodiscard]] const std::string &getSourceRoot() const;
+
+    void setSourceRoot(const std::string &sourceRoot);
+
+    /**
+     * File the snapshot was read from, empty when it holds the defaults.
+     */
+    [[nodiscard]] const std::string &getPropertyFile() const;
+
+    /**
+     * watch=true reloads the property file whenever it is rewritten (PropertiesWatcher).
+     */
+    [[nodiscard]] bool isWatch() const;
+
+    void setWatch(const std::string &watch);
+
+    /**
+     * Appender for path/file, looked up once per snapshot and configured with its size, rollover
+     * and flush settings.
+     */
+    [[nodiscard]] LogAppender *getLogAppender() const;
+
+    [[nodiscard]] LogAppender *getBinaryAppender() const;
+
+    [[nodiscard]] LogAppender *getJsonAppender() const;
+
+    /**
+     * Mapped log of file under the log path, configured with maxsz, roqty and compression.
+     */
+    [[nodiscard]] MappedLog *getMappedLog(const std::string &file) const;
+
+    /**
+     * Shared, immutable configuration snapshot. The first call loads LOG_PROPERTIES_FILE,
+     * every later call is a single acquire load.
+     */
+    static const LogProperties *instance();
+
+    /**
+     * Parses propertyFile into a new snapshot and swaps it in. Previous snapshots are retired
+     * instead of deleted because log statements in flight may still be reading them.
+     */
+    static const LogProperties *reload(const std::string &propertyFile = LOG_PROPERTIES_FILE);
 
-//    [[nodiscard]] LogAppender *getLogAppender() const;
+    /**
+     * Union of the level bits enabled globally or for any module (LogLevels), kept in its own
+     * atomic so the level check in the LOG_* macros is one relaxed load. Every level bit is set until
+     * the first snapshot is published, which lets early statements through to ~Log() where the
+     * configuration gets loaded.
+     */
+    static unsigned enabledLevels() {
+        return LogLevels::enabled();
+    }
 
 
 };
@@ -22,23 +22,104 @@
 //
 
 #include <util/Date.hpp>
-#include <sstream>
-#include <sys/time.h>
+#include <cstring>
 #ifdef __linux__
 #include <chrono>
 #endif
 
+std::atomic<bool> Date::_coarse_clock{false};
+
+static const char DIGITS[] =
+        "00010203040506070809"
+        "10111213141516171819"
+        "20212223242526272829"
+        "30313233343536373839"
+        "40414243444546474849"
+        "50515253545556575859"
+        "60616263646566676869"
+        "70717273747576777879"
+        "80818283848586878889"
+        "90919293949596979899";
+
+static inline char *twoDigits(char *out, int v) {
+    std::memcpy(out, DIGITS + 2 * v, 2);
+    return out + 2;
+}
+
+namespace {
+    struct SecondCache {
+        time_t second{-1};
+        char date[20]{};     ///< "YYYY-MM-DD HH:MM:SS"
+        char zone[24]{};     ///< " TZ "
+        size_t zone_length{};
+    };
+}
+
 std::string Date::nowTime() {
-    std::stringstream ss;
-    time_t t = time(0); // get time now
-    tm *now = localtime(&t);
-    struct timeval tv;
-    gettimeofday(&tv, NULL);
-    ss << (now->tm_year + 1900) << '-' << (now->tm_mon + 1) << '-' << now->tm_mday << " " << now->tm_hour
-    << ":" << now->tm_min << ":" << now->tm_sec << "." << tv.tv_usec << " " << now->tm_zone << " ";
-    return ss.str();
+    char buffer[FORMAT_SIZE];
+    return {buffer, format(now(), buffer)};
 }
 
 long Date::timestamp() {
     return (std::chrono::time_point_cast<std::chrono::microseconds>(std::chrono::system_clock::now())).time_since_epoch().count();
 }
+
+timespec Date::now() {
+    timespec ts{};
+#ifdef CLOCK_REALTIME_COARSE
+    if (_coarse_clock.load(std::memory_order_relaxed)) {
+        clock_gettime(CLOCK_REALTIME_COARSE, &ts);
+        return ts;
+    }
+#endif
+    clock_gettime(CLOCK_REALTIME, &ts);
+    return ts;
+}
+
+long Date::toMicros(const timespec &ts) {
+    return static_cast<long>(ts.tv_sec) * 1000000L + ts.tv_nsec / 1000;
+}
+
+size_t Date::format(const timespec &ts, char *out) {
+    thread_local SecondCache cache;
+    if (cache.second != ts.tv_sec) {
+        tm now{};
+        localtime_r(&ts.tv_sec, &now);
+        int year = now.tm_year + 1900;
+        char *p = cache.date;
+        p = twoDigits(p, (year / 100) % 100);
+        p = twoDigits(p, year % 100);
+        *p++ = '-';
+        p = twoDigits(p, now.tm_mon + 1);
+        *p++ = '-';
+        p = twoDigits(p, now.tm_mday);
+        *p++ = ' ';
+        p = twoDigits(p, now.tm_hour);
+        *p++ = ':';
+        p = twoDigits(p, now.tm_min);
+        *p++ = ':';
+        twoDigits(p, now.tm_sec);
+        size_t zone = strnlen(now.tm_zone, sizeof(cache.zone) - 3);
+        cache.zone[0] = ' ';
+        std::memcpy(cache.zone + 1, now.tm_zone, zone);
+        cache.zone[zone + 1] = ' ';
+        cache.zone_length = zone + 2;
+        cache.second = ts.tv_sec;
+    }
+
+    char *p = out;
+    std::memcpy(p, cache.date, 19);
+    p += 19;
+    *p++ = '.';
+    int usec = static_cast<int>(ts.tv_nsec / 1000);
+    p = twoDigits(p, usec / 10000);
+    p = twoDigits(p, (usec / 100) % 100);
+    p = twoDigits(p, usec % 100);
+    std::memcpy(p, cache.zone, cache.zone_length);
+    p += cache.zone_length;
+    return p - out;
+}
+
+void Date::useCoarseClock(bool coarse) {
+    _coarse_clock.store(coarse, std::memory_order_relaxed);
+}
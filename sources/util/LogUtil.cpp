@@ -26,6 +26,7 @@
 #include <util/Date.hpp>
 #include <iostream>     ///< cout
 #include <cstring>      ///< memset
+#include <cctype>       ///< toupper
 #include <cerrno>      ///< errno
 #include <sys/socket.h> ///< socket
 #include <netinet/in.h> ///< sockaddr_in
@@ -33,6 +34,9 @@
 #include <unistd.h>     ///< close
 #include <ifaddrs.h>    ///< ipv6
 #include <filesystem>
+#ifdef __SSE2__
+#include <emmintrin.h>  ///< _mm_movemask_epi8
+#endif
 
 std::string LogUtil::buildFileFullPath(std::string path, const std::string& filename) {
     std::string fileFullPath = path;
@@ -115,6 +119,60 @@ std::vector<std::string> LogUtil::decomposeFileGz(const std::string& filename) {
     return result;
 }
 
+static char foldCase(char c) {
+    return c >= 'A' && c <= 'Z' ? static_cast<char>(c - 'A' + 'a') : c;
+}
+
+static bool equalsLiteral(const char *text, std::string_view needle, bool ignoreCase) {
+    if (!ignoreCase)
+        return std::memcmp(text, needle.data(), needle.size()) == 0;
+    for (size_t i = 0; i < needle.size(); i++)
+        if (foldCase(text[i]) != foldCase(needle[i]))
+            return false;
+    return true;
+}
+
+size_t LogUtil::findLiteral(std::string_view text, std::string_view needle, bool ignoreCase, size_t from) {
+    if (needle.empty())
+        return from <= text.size() ? from : std::string_view::npos;
+    if (needle.size() > text.size())
+        return std::string_view::npos;
+    size_t last = text.size() - needle.size();
+    size_t i = from;
+#ifdef __SSE2__
+    // A match needs the first byte of needle at i and its last at i + size - 1, both tested for 16
+    // positions with two compares (four with ignoreCase) before any candidate is checked in full.
+    const size_t tail = needle.size() - 1;
+    const char first = foldCase(needle.front());
+    const char end = foldCase(needle.back());
+    const __m128i firstLower = _mm_set1_epi8(first);
+    const __m128i endLower = _mm_set1_epi8(end);
+    const __m128i firstUpper = _mm_set1_epi8(ignoreCase ? static_cast<char>(std::toupper(first)) : first);
+    const __m128i endUpper = _mm_set1_epi8(ignoreCase ? static_cast<char>(std::toupper(end)) : end);
+    const __m128i firstExact = _mm_set1_epi8(needle.front());
+    const __m128i endExact = _mm_set1_epi8(needle.back());
+    for (; i + 16 <= last + 1; i += 16) {
+        __m128i head = _mm_loadu_si128(reinterpret_cast<const __m128i *>(text.data() + i));
+        __m128i back = _mm_loadu_si128(reinterpret_cast<const __m128i *>(text.data() + i + tail));
+        __m128i candidates;
+        if (ignoreCase)
+            candidates = _mm_and_si128(_mm_or_si128(_mm_cmpeq_epi8(head, firstLower), _mm_cmpeq_epi8(head, firstUpper)),
+                                       _mm_or_si128(_mm_cmpeq_epi8(back, endLower), _mm_cmpeq_epi8(back, endUpper)));
+        else
+            candidates = _mm_and_si128(_mm_cmpeq_epi8(head, firstExact), _mm_cmpeq_epi8(back, endExact));
+        for (auto mask = static_cast<unsigned>(_mm_movemask_epi8(candidates)); mask != 0; mask &= mask - 1) {
+            size_t at = i + __builtin_ctz(mask);
+            if (equalsLiteral(text.data() + at, needle, ignoreCase))
+                return at;
+        }
+    }
+#endif
+    for (; i <= last; i++)
+        if (equalsLiteral(text.data() + i, needle, ignoreCase))
+            return i;
+    return std::string_view::npos;
+}
+
 std::string LogUtil::getFileParentFolder(const std::string &filename) {
     if (std::filesystem::is_regular_file(filename))
         return std::filesystem::path(filename).parent_path().string();
@@ -127,3 +185,56 @@ std::string LogUtil::getFilename(const std::string &filename) {
     size_t dir_pos = filename.find_last_of('/');
     return (dir_pos == std::string::npos)? filename : filename.substr(dir_pos+1, filename.length()-1);
 }
+
+void LogUtil::appendJsonEscaped(std::string &out, std::string_view text) {
+    static const char HEX[] = "0123456789abcdef";
+    size_t plain = 0;
+    for (size_t i = 0; i < text.size(); i++) {
+#ifdef __SSE2__
+        // 16 bytes at a time up to the next byte that needs escaping: a quote, a backslash or a
+        // control character (max_epu8(x, 0x1f) == 0x1f holds for the unsigned bytes below 0x20).
+        if (i + 16 <= text.size()) {
+            const __m128i quote = _mm_set1_epi8('"');
+            const __m128i backslash = _mm_set1_epi8('\\');
+            const __m128i control = _mm_set1_epi8(0x1f);
+            __m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i *>(text.data() + i));
+            __m128i special = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(block, quote), _mm_cmpeq_epi8(block, backslash)),
+                                           _mm_cmpeq_epi8(_mm_max_epu8(block, control), control));
+            auto mask = static_cast<unsigned>(_mm_movemask_epi8(special));
+            if (mask == 0) {
+                i += 15;
+                continue;
+            }
+            i += __builtin_ctz(mask);
+        }
+#endif
+        auto c = static_cast<unsigned char>(text[i]);
+        if (c >= 0x20 && c != '"' && c != '\\')
+            continue;
+        out.append(text.data() + plain, i - plain);
+        plain = i + 1;
+        switch (c) {
+            case '"':
+                out += "\\\"";
+                break;
+            case '\\':
+                out += "\\\\";
+                break;
+            case '\n':
+                out += "\\n";
+                break;
+            case '\r':
+                out += "\\r";
+                break;
+            case '\t':
+                out += "\\t";
+                break;
+            default:
+                out += "\\u00";
+                out += HEX[c >> 4];
+                out += HEX[c & 0xf];
+                break;
+        }
+    }
+    out.append(text.data() + plain, text.size() - plain);
+}
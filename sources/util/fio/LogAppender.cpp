@@ -22,183 +22,321 @@
 //
 
 #include "util/fio/LogAppender.hpp"
+#include <util/fio/LogArchiver.hpp>
 #include <iostream>
 #include <util/LogUtil.hpp>
 
-#include <zlib.h>
-#include <filesystem>
-#include <algorithm>
+#include <cstdio>
 #include <utility>
 #include <mutex>
+#include <sstream>
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <climits>
+#include <vector>
+#include <algorithm>
+
+std::mutex LogAppender::_registry_mutex;
+std::unordered_map<std::string, std::unique_ptr<LogAppender>> LogAppender::_registry;
 
-void LogAppender::moveLogFile()
+LogAppender::LogAppender(std::string mFilename, long mFsz, int roLimit, std::string path) : _filename(std::move(mFilename)), _fd(-1), _written(0), _file_size(mFsz), _rollover_limit(roLimit), _path(std::move(path)),
+                                                                                       _flush(flush_line), _flush_bytes(64 * KB), _flush_ms(1000), _last_flush(std::chrono::steady_clock::now()),
+                                                                                       _codec(codec_gzip), _compression_level(-1)
 {
-    compression_mutex.lock();
-    std::string ofname = LogUtil::buildRollbackFileName(_filename);
+    open();
+}
 
-    std::ifstream infile(_filename.c_str(), std::ios::binary);
-    std::ofstream outfile(ofname, std::ios::binary);
-    if (infile.is_open() && outfile.is_open())
-    {
-        std::copy(std::istreambuf_iterator<char>(infile),
-                  std::istreambuf_iterator<char>(),
-                  std::ostreambuf_iterator<char>(outfile));
-    }
+LogAppender::~LogAppender()
+{
+    flushBuffer();
+    _uring.reset();
+    if (_fd >= 0)
+        ::close(_fd);
+}
 
-    infile.close();
-    outfile.close();
-    std::ofstream logFileTotruncate(_filename, std::ios::trunc);
-    if (logFileTotruncate.is_open())
-    {
-        std::cout << _filename << " has been emptied succesfully. " << std::endl;
-    }
-    else
-    {
-        std::cerr << _filename << " has failed emptying its content. " << std::endl;
-    }
-    logFileTotruncate.close();
+LogAppender *LogAppender::instance(const std::string &filename)
+{
+    std::lock_guard<std::mutex> lock(_registry_mutex);
+    auto it = _registry.find(filename);
+    if (it == _registry.end())
+        it = _registry.emplace(filename, std::make_unique<LogAppender>(filename, 2 * MB, 20, LogUtil::recoverFilePath(filename))).first;
+    return it->second.get();
+}
 
-#ifdef __linux__
-    compressLog(ofname);
-#endif
+void LogAppender::flushAll()
+{
+    std::lock_guard<std::mutex> lock(_registry_mutex);
+    for (auto &appender : _registry)
+        appender.second->flush();
+}
 
-    compression_mutex.unlock();
+void LogAppender::configure(long mFsz, int roLimit, const std::string &path, Flush flush, long flushBytes, long flushMs,
+                            Codec codec, int compressionLevel)
+{
+    std::lock_guard<std::mutex> lock(_write_mutex);
+    _file_size = mFsz;
+    _rollover_limit = roLimit;
+    _path = path;
+    _flush = flush;
+    _flush_bytes = flushBytes;
+    _flush_ms = std::chrono::milliseconds(flushMs);
+    _codec = codec;
+    _compression_level = compressionLevel;
+    _buffer.reserve(_flush_bytes);
+}
+
+void LogAppender::configureIo(bool uring, int buffers, long bufferSize, long fsyncMs)
+{
+    std::lock_guard<std::mutex> lock(_write_mutex);
+    flushBuffer();
+    _fsync_ms = std::chrono::milliseconds(fsyncMs);
+    // Reloads reconfigure every appender; keep a ring that is already set up the same way.
+    if (uring && _uring && _uring->isConfigured(buffers, bufferSize, fsyncMs))
+        return;
+    _uring.reset();
+    if (!uring)
+        return;
+    _uring = std::make_unique<UringWriter>(buffers, bufferSize, fsyncMs);
+    if (!_uring->isReady() || !_uring->attach(_filename))
+        _uring.reset();
+}
+
+void LogAppender::open()
+{
+    _fd = ::open(_filename.c_str(), O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC, 0644);
+    if (_fd < 0)
+    {
+        std::cerr << "Error opening log file " << _filename << ": " << std::strerror(errno) << std::endl;
+        return;
+    }
+    struct stat st{};
+    _written = (::fstat(_fd, &st) == 0) ? st.st_size : 0;
 }
 
-void LogAppender::removeOldCompressions()
+void LogAppender::flushBuffer()
 {
-    compression_mutex.lock();
-    std::string path = _path;
-    std::vector<std::string> listOfGzFiles;
-    for (const auto &file : std::filesystem::directory_iterator(path))
+    _last_flush = std::chrono::steady_clock::now();
+    if (_buffer.empty())
+        return;
+    if (_uring)
     {
-        std::string filename = LogUtil::getNameOfFile(file.path().string());
-        std::string extension = LogUtil::getExtensionOfFile(file.path().string());
-        if (extension == ".gz")
-            listOfGzFiles.push_back(file.path().string());
+        _uring->write(_buffer.data(), _buffer.size());
+        _buffer.clear();
+        // A ring that failed has written out what it held, the descriptor takes over.
+        if (!_uring->isReady())
+            _uring.reset();
+        return;
     }
-    if (listOfGzFiles.size() > _rollover_limit)
+    if (_fd < 0)
+        open();
+    const char *data = _buffer.data();
+    size_t remaining = _buffer.size();
+    while (remaining > 0 && _fd >= 0)
     {
-        std::sort(listOfGzFiles.begin(), listOfGzFiles.end(), std::less<std::string>());
-        int limit = listOfGzFiles.size() - _rollover_limit;
-        for (int i = 0; i < limit; i++)
+        ssize_t n = ::write(_fd, data, remaining);
+        if (n < 0)
         {
-            std::remove(listOfGzFiles[i].c_str());
+            if (errno == EINTR)
+                continue;
+            std::cerr << "Error writing log file " << _filename << ": " << std::strerror(errno) << std::endl;
+            break;
         }
+        data += n;
+        remaining -= n;
     }
-    compression_mutex.unlock();
+    _buffer.clear();
+    syncIfDue();
 }
 
-LogAppender::LogAppender(std::string mFilename, long mFsz, int roLimit, std::string path) : _filename(std::move(mFilename)), _file_size(mFsz), _rollover_limit(roLimit), _path(std::move(path))
+void LogAppender::syncIfDue()
 {
-    _out_file_stream.open(_filename, std::ios_base::app);
+    if (_fsync_ms.count() <= 0 || _fd < 0 || std::chrono::steady_clock::now() - _last_fsync < _fsync_ms)
+        return;
+    ::fdatasync(_fd);
+    _last_fsync = std::chrono::steady_clock::now();
 }
 
-LogAppender::~LogAppender()
+void LogAppender::write(const std::string &v)
 {
-    if (_out_file_stream.is_open())
-        _out_file_stream.close();
+    write(v, log_verbose);
 }
 
-void LogAppender::write(const std::string &v)
+void LogAppender::write(std::string_view v, Level level)
 {
-    if (!_out_file_stream.is_open())
-    {
-        _out_file_stream.open(_filename, std::ios_base::app);
-    }
-    _out_file_stream << v;
+    std::lock_guard<std::mutex> lock(_write_mutex);
+    _buffer.append(v.data(), v.size());
+    _written += static_cast<long>(v.size());
 
-    if (_out_file_stream.tellp() >= _file_size)
+    bool flush;
+    switch (_flush)
     {
-        std::thread compressionThread([&]()
-                                      { moveLogFile(); });
-        std::thread removeThread([&]()
-                                 { removeOldCompressions(); });
-        compressionThread.join();
-        removeThread.join();
+    case flush_line:
+        flush = true;
+        break;
+    case flush_error:
+        flush = level == log_error;
+        break;
+    case flush_ms:
+        flush = std::chrono::steady_clock::now() - _last_flush >= _flush_ms;
+        break;
+    default:
+        flush = false;
+        break;
     }
-    _out_file_stream.close();
+    if (flush || static_cast<long>(_buffer.size()) >= _flush_bytes)
+        flushBuffer();
+
+    if (_written >= _file_size)
+        rollover();
 }
 
-#ifdef __linux__
-void LogAppender::compressLog(const std::string &inFile)
+void LogAppender::writev(const iovec *iov, int count)
 {
-    // Open the input file in binary mode
-    std::ifstream inputFile(inFile, std::ios::binary);
-    if (!inputFile.is_open())
+    std::lock_guard<std::mutex> lock(_write_mutex);
+    flushBuffer();
+    if (_uring)
+    {
+        for (int i = 0; i < count; i++)
+        {
+            _uring->write(static_cast<const char *>(iov[i].iov_base), iov[i].iov_len);
+            _written += static_cast<long>(iov[i].iov_len);
+        }
+        if (!_uring->isReady())
+            _uring.reset();
+        if (_written >= _file_size)
+            rollover();
+        return;
+    }
+    if (_fd < 0)
+        open();
+    std::vector<iovec> pending(iov, iov + count);
+    size_t first = 0;
+    while (first < pending.size() && _fd >= 0)
     {
-        std::cerr << "Error opening input file: " << inFile << std::endl;
+        int n = static_cast<int>(std::min<size_t>(pending.size() - first, IOV_MAX));
+        ssize_t written = ::writev(_fd, pending.data() + first, n);
+        if (written < 0)
+        {
+            if (errno == EINTR)
+                continue;
+            std::cerr << "Error writing log file " << _filename << ": " << std::strerror(errno) << std::endl;
+            break;
+        }
+        _written += static_cast<long>(written);
+        // Skip what went out; a short write leaves the rest of a buffer for the next call.
+        while (first < pending.size() && static_cast<size_t>(written) >= pending[first].iov_len)
+            written -= static_cast<ssize_t>(pending[first++].iov_len);
+        if (first < pending.size())
+        {
+            pending[first].iov_base = static_cast<char *>(pending[first].iov_base) + written;
+            pending[first].iov_len -= written;
+        }
     }
+    syncIfDue();
+    if (_written >= _file_size)
+        rollover();
+}
 
-    std::string compressed = inFile;
-    compressed += ".zip";
-    // Open the output file in binary mode
-    std::ofstream outputFile(compressed, std::ios::binary);
-    if (!outputFile.is_open())
+void LogAppender::rollover()
+{
+    flushBuffer();
+    // The archiver reads the rolled file right away, so its writes must have landed.
+    if (_uring)
+        _uring->sync();
+    std::string ofname = LogUtil::buildRollbackFileName(_filename);
+    if (std::rename(_filename.c_str(), ofname.c_str()) != 0)
     {
-        std::cerr << "Error opening output file: " << compressed << std::endl;
-        inputFile.close();
+        std::cerr << _filename << " could not be rolled over to " << ofname << ": " << std::strerror(errno) << std::endl;
+        _written = 0;
+        return;
     }
+    if (_fd >= 0)
+        ::close(_fd);
+    open();
+    if (_uring && !_uring->attach(_filename))
+        _uring.reset();
+    _rollovers.fetch_add(1, std::memory_order_release);
+    LogArchiver *archiver = LogArchiver::instance();
+    if (archiver != nullptr)
+        archiver->submit(ofname, _filename, _rollover_limit, _codec, _compression_level);
+}
 
-    // Prepare zlib structures
-    constexpr int BufferSize = 8192;
-    char buffer[BufferSize];
-
-    z_stream stream;
-    stream.zalloc = Z_NULL;
-    stream.zfree = Z_NULL;
-    stream.opaque = Z_NULL;
+unsigned long LogAppender::getRollovers() const
+{
+    return _rollovers.load(std::memory_order_acquire);
+}
 
-    // Initialize zlib for compression
-    if (deflateInit(&stream, Z_DEFAULT_COMPRESSION) != Z_OK)
+void LogAppender::flush()
+{
+    std::lock_guard<std::mutex> lock(_write_mutex);
+    flushBuffer();
+    if (_uring)
     {
-        std::cerr << "Error initializing zlib for compression" << std::endl;
+        _uring->sync();
+        if (!_uring->isReady())
+            _uring.reset();
     }
+}
 
-    // Compress the input file and write the compressed data to the output file
-    do
-    {
-        inputFile.read(buffer, BufferSize);
-        stream.avail_in = static_cast<uInt>(inputFile.gcount());
-        stream.next_in = reinterpret_cast<Bytef *>(buffer);
+void LogAppender::flushIfDue()
+{
+    std::lock_guard<std::mutex> lock(_write_mutex);
+    if (_flush == flush_ms && !_buffer.empty() && std::chrono::steady_clock::now() - _last_flush >= _flush_ms)
+        flushBuffer();
+}
 
-        int ret;
-        do
-        {
-            stream.avail_out = BufferSize;
-            stream.next_out = reinterpret_cast<Bytef *>(buffer);
 
-            ret = deflate(&stream, Z_FINISH);
-            if (ret == Z_STREAM_ERROR)
-            {
-                std::cerr << "Error in zlib deflate: " << stream.msg << std::endl;
-                deflateEnd(&stream);
-                inputFile.close();
-                outputFile.close();
-            }
+void LogAppender::crashFlushAll()
+{
+    // The registry only grows, and a crashing process will not see another appender created.
+    for (auto &appender : _registry)
+        appender.second->crashWrite(std::string_view());
+}
 
-            outputFile.write(buffer, BufferSize - stream.avail_out);
-        } while (stream.avail_out == 0);
-    } while (!inputFile.eof());
+void LogAppender::crashResumeAll()
+{
+    for (auto &appender : _registry)
+        appender.second->_crash_flushed = false;
+}
 
-    // Clean up zlib
-    deflateEnd(&stream);
+void LogAppender::crashWrite(std::string_view v)
+{
+    // The line buffer goes out once, ahead of the first record of the crash handler.
+    if (!_crash_flushed)
+    {
+        _crash_flushed = true;
+        crashWriteRaw(std::string_view(_buffer.data(), _buffer.size()));
+    }
+    crashWriteRaw(v);
+}
 
-    // Close the input and output files
-    inputFile.close();
-    outputFile.close();
-    std::remove(inFile.c_str());
-    std::cout << "File compressed successfully: " << inFile << " -> " << compressed << std::endl;
+void LogAppender::crashWriteRaw(std::string_view v)
+{
+    if (_uring)
+    {
+        _uring->crashWrite(v.data(), v.size());
+        return;
+    }
+    while (!v.empty() && _fd >= 0)
+    {
+        ssize_t n = ::write(_fd, v.data(), v.size());
+        if (n < 0 && errno == EINTR)
+            continue;
+        if (n <= 0)
+            return;
+        v.remove_prefix(static_cast<size_t>(n));
+    }
 }
-#endif
+
 
 template <class T>
 LogAppender &LogAppender::operator<<(const T &v)
 {
-    if (!_out_file_stream.is_open())
-    {
-        _out_file_stream.open(_filename, std::ios_base::app);
-    }
-    _out_file_stream << v;
+    std::stringstream ss;
+    ss << v;
+    write(ss.str());
     return *this;
 }
@@ -0,0 +1,399 @@
+// MIT License
+//
+// Copyright (c) 2023 Salomon Lee
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+#include <util/fio/LogArchiver.hpp>
+#include <util/logging/Log.hpp>
+#include <util/properties/LogProperties.hpp>
+#include <util/LogUtil.hpp>
+#include <iostream>
+#include <fstream>
+#include <memory>
+#include <zlib.h>
+#include <filesystem>
+#include <algorithm>
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#ifdef LOGPP_HAVE_ZSTD
+#include <zstd.h>
+#endif
+#ifdef LOGPP_HAVE_LZ4
+#include <lz4frame.h>
+#endif
+
+std::atomic<bool> LogArchiver::_stopped{false};
+
+LogArchiver::LogArchiver(int workers) : _running(true), _busy(0)
+{
+    for (int i = 0; i < std::max(workers, 1); i++)
+        _workers.emplace_back([this]()
+                              { run(); });
+}
+
+LogArchiver::~LogArchiver()
+{
+    _stopped.store(true, std::memory_order_release);
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _running = false;
+    }
+    _wake.notify_all();
+    for (auto &worker : _workers)
+        if (worker.joinable())
+            worker.join();
+}
+
+LogArchiver *LogArchiver::instance()
+{
+    if (_stopped.load(std::memory_order_acquire))
+        return nullptr;
+    static LogArchiver archiver(LogProperties::instance()->getCompressionWorkers());
+    return &archiver;
+}
+
+Codec LogArchiver::available(Codec codec)
+{
+    switch (codec)
+    {
+#ifdef LOGPP_HAVE_ZSTD
+    case codec_zstd:
+        return codec_zstd;
+#endif
+#ifdef LOGPP_HAVE_LZ4
+    case codec_lz4:
+        return codec_lz4;
+#endif
+    case codec_none:
+        return codec_none;
+    default:
+        return codec_gzip;
+    }
+}
+
+std::string LogArchiver::extensionOf(Codec codec)
+{
+    switch (available(codec))
+    {
+    case codec_zstd:
+        return ".zst";
+    case codec_lz4:
+        return ".lz4";
+    case codec_none:
+        return "";
+    default:
+        return ".gz";
+    }
+}
+
+void LogArchiver::submit(const std::string &file, const std::string &activeFile, int rolloverLimit, Codec codec, int level)
+{
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _jobs.push_back(Job{file, activeFile, rolloverLimit, codec, level});
+    }
+    _wake.notify_one();
+}
+
+void LogArchiver::wait()
+{
+    std::unique_lock<std::mutex> lock(_mutex);
+    _idle.wait(lock, [this]()
+               { return _jobs.empty() && _busy == 0; });
+}
+
+void LogArchiver::run()
+{
+    Log::setThreadName("logpp-archive");
+    // Compression is background work, on a busy machine the logging threads go first.
+    setpriority(PRIO_PROCESS, static_cast<id_t>(syscall(SYS_gettid)), 10);
+    std::unique_lock<std::mutex> lock(_mutex);
+    for (;;)
+    {
+        _wake.wait(lock, [this]()
+                   { return !_jobs.empty() || !_running; });
+        if (_jobs.empty())
+            break;
+        Job job = std::move(_jobs.front());
+        _jobs.pop_front();
+        _busy++;
+        lock.unlock();
+        std::string archived = compressLog(job.file, job.codec, job.level);
+        removeOldCompressions(job.activeFile, LogUtil::getExtensionOfFile(job.activeFile) + extensionOf(job.codec),
+                              job.rolloverLimit);
+        if (archived != job.file)
+            std::cout << "File compressed successfully: " << job.file << " -> " << archived << std::endl;
+        lock.lock();
+        _busy--;
+        if (_jobs.empty() && _busy == 0)
+            _idle.notify_all();
+    }
+}
+
+std::string LogArchiver::compressLog(const std::string &inFile, Codec codec, int level)
+{
+    codec = available(codec);
+    if (codec == codec_none)
+        return inFile;
+
+    std::string compressed = inFile + extensionOf(codec);
+    std::string partial = compressed + ".part";
+    bool done;
+    switch (codec)
+    {
+#ifdef LOGPP_HAVE_ZSTD
+    case codec_zstd:
+        done = compressZstd(inFile, partial, level);
+        break;
+#endif
+#ifdef LOGPP_HAVE_LZ4
+    case codec_lz4:
+        done = compressLz4(inFile, partial, level);
+        break;
+#endif
+    default:
+        done = compressGzip(inFile, partial, level);
+        break;
+    }
+
+    // The archive only gets its final name once complete, so retention never counts a partial one.
+    if (!done || std::rename(partial.c_str(), compressed.c_str()) != 0)
+    {
+        std::cerr << "Error compressing " << inFile << ", the segment is kept uncompressed" << std::endl;
+        std::remove(partial.c_str());
+        return inFile;
+    }
+    std::remove(inFile.c_str());
+    return compressed;
+}
+
+bool LogArchiver::compressGzip(const std::string &inFile, const std::string &outFile, int level)
+{
+    std::ifstream inputFile(inFile, std::ios::binary);
+    if (!inputFile.is_open())
+    {
+        std::cerr << "Error opening input file: " << inFile << std::endl;
+        return false;
+    }
+    std::ofstream outputFile(outFile, std::ios::binary);
+    if (!outputFile.is_open())
+    {
+        std::cerr << "Error opening output file: " << outFile << std::endl;
+        return false;
+    }
+
+    z_stream stream{};
+    stream.zalloc = Z_NULL;
+    stream.zfree = Z_NULL;
+    stream.opaque = Z_NULL;
+
+    // windowBits 15 + 16 makes deflate write a gzip header and trailer instead of a zlib one.
+    if (deflateInit2(&stream, level < 0 ? Z_DEFAULT_COMPRESSION : std::min(level, 9), Z_DEFLATED, 15 + 16, 8, Z_DEFAULT_STRATEGY) != Z_OK)
+    {
+        std::cerr << "Error initializing zlib for compression" << std::endl;
+        return false;
+    }
+
+    std::unique_ptr<char[]> in(new char[BUFFER_SIZE]);
+    std::unique_ptr<char[]> out(new char[BUFFER_SIZE]);
+    int flush;
+    do
+    {
+        inputFile.read(in.get(), BUFFER_SIZE);
+        stream.avail_in = static_cast<uInt>(inputFile.gcount());
+        stream.next_in = reinterpret_cast<Bytef *>(in.get());
+        flush = inputFile.eof() ? Z_FINISH : Z_NO_FLUSH;
+        do
+        {
+            stream.avail_out = BUFFER_SIZE;
+            stream.next_out = reinterpret_cast<Bytef *>(out.get());
+            if (deflate(&stream, flush) == Z_STREAM_ERROR)
+            {
+                std::cerr << "Error in zlib deflate: " << (stream.msg ? stream.msg : "") << std::endl;
+                deflateEnd(&stream);
+                return false;
+            }
+            outputFile.write(out.get(), BUFFER_SIZE - stream.avail_out);
+        } while (stream.avail_out == 0);
+    } while (flush != Z_FINISH);
+
+    deflateEnd(&stream);
+    outputFile.close();
+    return outputFile.good();
+}
+
+#ifdef LOGPP_HAVE_ZSTD
+bool LogArchiver::compressZstd(const std::string &inFile, const std::string &outFile, int level)
+{
+    std::ifstream inputFile(inFile, std::ios::binary);
+    std::ofstream outputFile(outFile, std::ios::binary);
+    if (!inputFile.is_open() || !outputFile.is_open())
+    {
+        std::cerr << "Error opening " << inFile << " or " << outFile << std::endl;
+        return false;
+    }
+
+    ZSTD_CCtx *context = ZSTD_createCCtx();
+    ZSTD_CCtx_setParameter(context, ZSTD_c_compressionLevel, level < 0 ? ZSTD_CLEVEL_DEFAULT : level);
+    size_t outSize = ZSTD_CStreamOutSize();
+    std::unique_ptr<char[]> in(new char[BUFFER_SIZE]);
+    std::unique_ptr<char[]> out(new char[outSize]);
+    bool last;
+    do
+    {
+        inputFile.read(in.get(), BUFFER_SIZE);
+        last = inputFile.eof();
+        ZSTD_inBuffer input = {in.get(), static_cast<size_t>(inputFile.gcount()), 0};
+        ZSTD_EndDirective mode = last ? ZSTD_e_end : ZSTD_e_continue;
+        bool finished;
+        do
+        {
+            ZSTD_outBuffer output = {out.get(), outSize, 0};
+            size_t remaining = ZSTD_compressStream2(context, &output, &input, mode);
+            if (ZSTD_isError(remaining))
+            {
+                std::cerr << "Error in zstd compression: " << ZSTD_getErrorName(remaining) << std::endl;
+                ZSTD_freeCCtx(context);
+                return false;
+            }
+            outputFile.write(out.get(), static_cast<std::streamsize>(output.pos));
+            finished = last ? (remaining == 0) : (input.pos == input.size);
+        } while (!finished);
+    } while (!last);
+
+    ZSTD_freeCCtx(context);
+    outputFile.close();
+    return outputFile.good();
+}
+#endif
+
+#ifdef LOGPP_HAVE_LZ4
+bool LogArchiver::compressLz4(const std::string &inFile, const std::string &outFile, int level)
+{
+    std::ifstream inputFile(inFile, std::ios::binary);
+    std::ofstream outputFile(outFile, std::ios::binary);
+    if (!inputFile.is_open() || !outputFile.is_open())
+    {
+        std::cerr << "Error opening " << inFile << " or " << outFile << std::endl;
+        return false;
+    }
+
+    LZ4F_cctx *context = nullptr;
+    if (LZ4F_isError(LZ4F_createCompressionContext(&context, LZ4F_VERSION)))
+        return false;
+    LZ4F_preferences_t preferences{};
+    preferences.compressionLevel = std::max(level, 0);
+    size_t outSize = LZ4F_compressBound(BUFFER_SIZE, &preferences);
+    std::unique_ptr<char[]> in(new char[BUFFER_SIZE]);
+    std::unique_ptr<char[]> out(new char[std::max<size_t>(outSize, LZ4F_HEADER_SIZE_MAX)]);
+
+    size_t n = LZ4F_compressBegin(context, out.get(), outSize, &preferences);
+    bool ok = !LZ4F_isError(n);
+    if (ok)
+        outputFile.write(out.get(), static_cast<std::streamsize>(n));
+    while (ok && inputFile)
+    {
+        inputFile.read(in.get(), BUFFER_SIZE);
+        if (inputFile.gcount() == 0)
+            break;
+        n = LZ4F_compressUpdate(context, out.get(), outSize, in.get(), static_cast<size_t>(inputFile.gcount()), nullptr);
+        ok = !LZ4F_isError(n);
+        if (ok)
+            outputFile.write(out.get(), static_cast<std::streamsize>(n));
+    }
+    if (ok)
+    {
+        n = LZ4F_compressEnd(context, out.get(), outSize, nullptr);
+        ok = !LZ4F_isError(n);
+        if (ok)
+            outputFile.write(out.get(), static_cast<std::streamsize>(n));
+    }
+    LZ4F_freeCompressionContext(context);
+    outputFile.close();
+    return ok && outputFile.good();
+}
+#endif
+
+size_t LogArchiver::timestampEnd(const std::string &filename, const std::string &prefix)
+{
+    if (filename.compare(0, prefix.size(), prefix) != 0)
+        return std::string::npos;
+    size_t digits = prefix.size();
+    while (digits < filename.size() && std::isdigit(static_cast<unsigned char>(filename[digits])))
+        digits++;
+    return digits == prefix.size() ? std::string::npos : digits;
+}
+
+std::vector<std::string> LogArchiver::segmentsOf(const std::string &activeFile)
+{
+    // <name>-<rollover timestamp><extension>[.gz|.zst|.lz4], see LogUtil::buildRollbackFileName.
+    std::string path = LogUtil::recoverFilePath(activeFile);
+    std::string prefix = LogUtil::getNameOfFile(activeFile) + "-";
+    std::string extension = LogUtil::getExtensionOfFile(activeFile);
+    std::vector<std::string> segments;
+    // A directory that vanishes or becomes unreadable while listed ends the list where it stopped.
+    std::error_code error;
+    for (std::filesystem::directory_iterator it(path, error), end; !error && it != end; it.increment(error))
+    {
+        std::string filename = LogUtil::getFilename(it->path().string());
+        size_t digits = timestampEnd(filename, prefix);
+        if (digits == std::string::npos || filename.compare(digits, extension.size(), extension) != 0)
+            continue;
+        std::string archive = filename.substr(digits + extension.size());
+        if (archive.empty() || archive == ".gz" || archive == ".zst" || archive == ".lz4")
+            segments.push_back(it->path().string());
+    }
+    // The timestamps have the same number of digits, so the names sort in rollover order.
+    std::sort(segments.begin(), segments.end());
+    return segments;
+}
+
+void LogArchiver::removeOldCompressions(const std::string &activeFile, const std::string &extension, int rolloverLimit)
+{
+    std::string path = LogUtil::recoverFilePath(activeFile);
+    std::string prefix = LogUtil::getNameOfFile(activeFile) + "-";
+    std::vector<std::string> listOfArchives;
+    // Runs on the archiver thread, where a throwing iterator would terminate the process: a
+    // directory that vanished or became unreadable only skips this round of retention.
+    std::error_code error;
+    for (std::filesystem::directory_iterator it(path, error), end; !error && it != end; it.increment(error))
+    {
+        std::string filename = LogUtil::getFilename(it->path().string());
+        size_t digits = timestampEnd(filename, prefix);
+        if (digits != std::string::npos && filename.compare(digits, std::string::npos, extension) == 0)
+            listOfArchives.push_back(it->path().string());
+    }
+    if (error)
+    {
+        std::cerr << "Error listing " << path << ": " << error.message() << ", old archives are kept" << std::endl;
+        return;
+    }
+    if (listOfArchives.size() > static_cast<size_t>(rolloverLimit))
+    {
+        std::sort(listOfArchives.begin(), listOfArchives.end(), std::less<std::string>());
+        size_t limit = listOfArchives.size() - rolloverLimit;
+        for (size_t i = 0; i < limit; i++)
+        {
+            std::remove(listOfArchives[i].c_str());
+        }
+    }
+}
@@ -0,0 +1,234 @@
+// MIT License
+//
+// Copyright (c) 2023 Salomon Lee
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+#include <util/fio/MappedLog.hpp>
+#include <util/fio/LogArchiver.hpp>
+#include <util/LogUtil.hpp>
+#include <logconfig.h>
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <thread>
+#include <utility>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+std::mutex MappedLog::_registry_mutex;
+std::unordered_map<std::string, std::unique_ptr<MappedLog>> MappedLog::_registry;
+
+MappedLog::MappedLog(std::string filename, long maxSize)
+        : _filename(std::move(filename)), _capacity(maxSize > 0 ? maxSize : 2 * MB), _rollover_limit(20),
+          _codec(codec_gzip), _compression_level(-1), _last_msync(std::chrono::steady_clock::now()) {
+    Segment *segment = map(_filename, _capacity, true);
+    if (segment != nullptr)
+        _segments.emplace_back(segment);
+    _current.store(segment, std::memory_order_release);
+    _next.reset(map(_filename + ".next", _capacity, false));
+}
+
+MappedLog::~MappedLog() {
+    Segment *segment = _current.load(std::memory_order_acquire);
+    if (segment != nullptr)
+        unmap(segment, segment->committed.load(std::memory_order_acquire));
+    if (_next != nullptr) {
+        unmap(_next.get(), 0);
+        ::unlink((_filename + ".next").c_str());
+    }
+}
+
+MappedLog *MappedLog::instance(const std::string &filename, long maxSize) {
+    std::lock_guard<std::mutex> lock(_registry_mutex);
+    auto it = _registry.find(filename);
+    if (it == _registry.end())
+        it = _registry.emplace(filename, std::make_unique<MappedLog>(filename, maxSize)).first;
+    return it->second.get();
+}
+
+MappedLog::Segment *MappedLog::map(const std::string &file, size_t capacity, bool existing) {
+    int fd = ::open(file.c_str(), O_RDWR | O_CREAT | O_CLOEXEC | (existing ? 0 : O_TRUNC), 0644);
+    if (fd < 0) {
+        std::cerr << "Error opening log file " << file << ": " << std::strerror(errno) << std::endl;
+        return nullptr;
+    }
+    struct stat st{};
+    size_t size = (::fstat(fd, &st) == 0) ? st.st_size : 0;
+    capacity = std::max(capacity, size);
+    // Filesystems without fallocate still get a file of the full size, only not reserved up front.
+    if (::fallocate(fd, 0, 0, static_cast<off_t>(capacity)) != 0 &&
+        ::ftruncate(fd, static_cast<off_t>(capacity)) != 0) {
+        std::cerr << "Error preallocating log file " << file << ": " << std::strerror(errno) << std::endl;
+        ::close(fd);
+        return nullptr;
+    }
+    void *base = ::mmap(nullptr, capacity, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (base == MAP_FAILED) {
+        std::cerr << "Error mapping log file " << file << ": " << std::strerror(errno) << std::endl;
+        ::close(fd);
+        return nullptr;
+    }
+    // A segment that was not closed cleanly still has its zero tail, continue after the last line.
+    size_t used = size;
+    while (used > 0 && static_cast<char *>(base)[used - 1] == '\0')
+        used--;
+    auto *segment = new Segment();
+    segment->fd = fd;
+    segment->base = static_cast<char *>(base);
+    segment->capacity = capacity;
+    segment->reserved.store(used, std::memory_order_relaxed);
+    segment->committed.store(used, std::memory_order_relaxed);
+    segment->synced = used;
+    return segment;
+}
+
+void MappedLog::unmap(Segment *segment, size_t used) {
+    ::munmap(segment->base, segment->capacity);
+    if (::ftruncate(segment->fd, static_cast<off_t>(used)) != 0)
+        std::cerr << "Error truncating log segment: " << std::strerror(errno) << std::endl;
+    ::close(segment->fd);
+    segment->fd = -1;
+    segment->base = nullptr;
+}
+
+void MappedLog::configure(long maxSize, int roLimit, Codec codec, int compressionLevel, long msyncMs) {
+    std::lock_guard<std::mutex> lock(_mutex);
+    if (maxSize > 0)
+        _capacity = maxSize;
+    _rollover_limit = roLimit;
+    _codec = codec;
+    _compression_level = compressionLevel;
+    _msync_ms.store(msyncMs, std::memory_order_relaxed);
+    if (_next != nullptr && _next->capacity != _capacity) {
+        unmap(_next.get(), 0);
+        _next.reset(map(_filename + ".next", _capacity, false));
+    }
+}
+
+void MappedLog::write(std::string_view v) {
+    while (!v.empty())
+        v.remove_prefix(append(v));
+}
+
+void MappedLog::crashWrite(std::string_view v) {
+    Segment *segment = _current.load(std::memory_order_acquire);
+    if (segment == nullptr || v.size() > segment->capacity)
+        return;
+    size_t offset = segment->reserved.fetch_add(v.size(), std::memory_order_relaxed);
+    if (offset + v.size() <= segment->capacity) {
+        std::memcpy(segment->base + offset, v.data(), v.size());
+        segment->committed.fetch_add(v.size(), std::memory_order_release);
+    }
+}
+
+size_t MappedLog::append(std::string_view v) {
+    Segment *segment = _current.load(std::memory_order_acquire);
+    if (segment == nullptr)
+        return v.size();
+    // Lines longer than a whole segment are split across segments.
+    size_t n = std::min(v.size(), segment->capacity);
+    size_t offset = segment->reserved.fetch_add(n, std::memory_order_relaxed);
+    if (offset + n <= segment->capacity) {
+        std::memcpy(segment->base + offset, v.data(), n);
+        segment->committed.fetch_add(n, std::memory_order_release);
+        // The msync cadence is looked at once per page, and never waits for a rollover or a flush.
+        long msyncMs = _msync_ms.load(std::memory_order_relaxed);
+        if (msyncMs > 0 && (offset >> 12) != ((offset + n) >> 12)) {
+            std::unique_lock<std::mutex> lock(_mutex, std::try_to_lock);
+            if (lock.owns_lock() && std::chrono::steady_clock::now() - _last_msync >= std::chrono::milliseconds(msyncMs))
+                sync(_current.load(std::memory_order_acquire));
+        }
+        return n;
+    }
+    // Exactly one range starts at or before the end and does not fit: its writer rolls, everyone
+    // past the end waits for the next segment.
+    if (offset <= segment->capacity)
+        rollover(segment, offset);
+    else
+        while (_current.load(std::memory_order_acquire) == segment)
+            std::this_thread::yield();
+    return 0;
+}
+
+void MappedLog::rollover(Segment *full, size_t used) {
+    std::lock_guard<std::mutex> lock(_mutex);
+    while (full->committed.load(std::memory_order_acquire) != used)
+        std::this_thread::yield();
+    unmap(full, used);
+
+    std::string ofname = LogUtil::buildRollbackFileName(_filename);
+    bool rolled = std::rename(_filename.c_str(), ofname.c_str()) == 0;
+    Segment *next;
+    if (!rolled) {
+        std::cerr << _filename << " could not be rolled over to " << ofname << ": " << std::strerror(errno) << std::endl;
+        next = map(_filename, used + _capacity, true);
+    } else if (_next != nullptr && std::rename((_filename + ".next").c_str(), _filename.c_str()) == 0) {
+        next = _next.release();
+    } else {
+        next = map(_filename, _capacity, false);
+    }
+    if (next != nullptr)
+        _segments.emplace_back(next);
+    _current.store(next, std::memory_order_release);
+    if (!rolled)
+        return;
+
+    _rollovers.fetch_add(1, std::memory_order_release);
+    LogArchiver *archiver = LogArchiver::instance();
+    if (archiver != nullptr)
+        archiver->submit(ofname, _filename, _rollover_limit, _codec, _compression_level);
+    if (_next == nullptr)
+        _next.reset(map(_filename + ".next", _capacity, false));
+}
+
+void MappedLog::sync(Segment *segment) {
+    _last_msync = std::chrono::steady_clock::now();
+    if (segment == nullptr)
+        return;
+    static const size_t page = ::sysconf(_SC_PAGESIZE);
+    size_t committed = segment->committed.load(std::memory_order_acquire);
+    size_t from = segment->synced / page * page;
+    if (committed > from && ::msync(segment->base + from, committed - from, MS_SYNC) != 0)
+        std::cerr << "msync of " << _filename << " failed: " << std::strerror(errno) << std::endl;
+    segment->synced = committed;
+}
+
+void MappedLog::flush() {
+    std::lock_guard<std::mutex> lock(_mutex);
+    sync(_current.load(std::memory_order_acquire));
+}
+
+void MappedLog::flushIfDue() {
+    long msyncMs = _msync_ms.load(std::memory_order_relaxed);
+    if (msyncMs <= 0)
+        return;
+    std::lock_guard<std::mutex> lock(_mutex);
+    if (std::chrono::steady_clock::now() - _last_msync >= std::chrono::milliseconds(msyncMs))
+        sync(_current.load(std::memory_order_acquire));
+}
+
+unsigned long MappedLog::getRollovers() const {
+    return _rollovers.load(std::memory_order_acquire);
+}
@@ -0,0 +1,133 @@
+// MIT License
+//
+// Copyright (c) 2023 Salomon Lee
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+#include <util/fio/PropertiesWatcher.hpp>
+#include <util/logging/Log.hpp>
+#include <util/properties/LogProperties.hpp>
+#include <cerrno>
+#include <cstring>
+#include <iostream>
+#include <poll.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+
+std::atomic<bool> PropertiesWatcher::_stopped{false};
+
+PropertiesWatcher *PropertiesWatcher::instance() {
+    if (_stopped.load(std::memory_order_acquire))
+        return nullptr;
+    static PropertiesWatcher watcher;
+    return &watcher;
+}
+
+PropertiesWatcher::~PropertiesWatcher() {
+    _stopped.store(true, std::memory_order_release);
+    _running.store(false, std::memory_order_release);
+    if (_thread.joinable())
+        _thread.join();
+    if (_fd >= 0)
+        ::close(_fd);
+}
+
+void PropertiesWatcher::watch(const std::string &file) {
+    std::lock_guard<std::mutex> lock(_mutex);
+    _file = file;
+    if (file.empty())
+        return;
+    if (_fd < 0) {
+        _fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+        if (_fd < 0) {
+            std::cerr << "Error watching the property file: " << std::strerror(errno) << std::endl;
+            return;
+        }
+    }
+    addWatch(file);
+    if (_running.load(std::memory_order_acquire))
+        return;
+    // A thread that stopped for an empty name has left its loop, joining it does not wait long.
+    if (_thread.joinable())
+        _thread.join();
+    _running.store(true, std::memory_order_release);
+    _thread = std::thread(&PropertiesWatcher::run, this);
+}
+
+void PropertiesWatcher::addWatch(const std::string &file) {
+    // The directory is watched, editors and deployments often replace the file by a rename.
+    size_t slash = file.rfind('/');
+    std::string dir = slash == std::string::npos ? "." : file.substr(0, slash + 1);
+    _name = slash == std::string::npos ? file : file.substr(slash + 1);
+    if (_wd >= 0 && dir == _dir)
+        return;
+    if (_wd >= 0)
+        inotify_rm_watch(_fd, _wd);
+    _dir = dir;
+    _wd = inotify_add_watch(_fd, dir.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO);
+    if (_wd < 0)
+        std::cerr << "Error watching " << file << ": " << std::strerror(errno) << std::endl;
+}
+
+std::string PropertiesWatcher::getFile() {
+    std::lock_guard<std::mutex> lock(_mutex);
+    return _file;
+}
+
+unsigned long PropertiesWatcher::getReloads() const {
+    return _reloads.load(std::memory_order_acquire);
+}
+
+void PropertiesWatcher::run() {
+    Log::setThreadName("logpp-watch");
+    alignas(inotify_event) char events[4096];
+    while (_running.load(std::memory_order_acquire)) {
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            if (_file.empty()) {
+                if (_wd >= 0)
+                    inotify_rm_watch(_fd, _wd);
+                _wd = -1;
+                _running.store(false, std::memory_order_release);
+                break;
+            }
+        }
+        pollfd ready{_fd, POLLIN, 0};
+        if (::poll(&ready, 1, 200) <= 0)
+            continue;
+        bool changed = false;
+        std::string file;
+        ssize_t n;
+        while ((n = ::read(_fd, events, sizeof(events))) > 0) {
+            std::lock_guard<std::mutex> lock(_mutex);
+            for (char *p = events; p < events + n;) {
+                auto *event = reinterpret_cast<inotify_event *>(p);
+                if (event->len > 0 && event->wd == _wd && _name == event->name)
+                    changed = true;
+                p += sizeof(inotify_event) + event->len;
+            }
+            file = _file;
+        }
+        if (changed && !file.empty()) {
+            LogProperties::reload(file);
+            _reloads.fetch_add(1, std::memory_order_release);
+        }
+    }
+}
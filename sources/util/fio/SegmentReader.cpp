@@ -0,0 +1,198 @@
+// MIT License
+//
+// Copyright (c) 2023 Salomon Lee
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+
+#include <util/fio/SegmentReader.hpp>
+#include <util/fio/LogArchiver.hpp>
+#include <algorithm>
+#include <iostream>
+#include <cerrno>
+#include <cstring>
+#ifdef LOGPP_HAVE_ZSTD
+#include <zstd.h>
+#endif
+#ifdef LOGPP_HAVE_LZ4
+#include <lz4frame.h>
+#endif
+
+SegmentReader::SegmentReader(const std::string &file) : _file(file), _codec(codecOf(file)) {
+    if (_codec == codec_none || _codec == codec_gzip) {
+        // gzread passes files without a gzip header through unchanged.
+        _gz = gzopen(file.c_str(), "rb");
+        if (_gz == nullptr)
+            std::cerr << "Unable to open " << file << ": " << std::strerror(errno) << std::endl;
+        else
+            gzbuffer(_gz, BUFFER_SIZE);
+        return;
+    }
+    if (LogArchiver::available(_codec) != _codec) {
+        std::cerr << "Unable to read " << file << ", this build has no " << LogArchiver::extensionOf(_codec)
+                  << " support" << std::endl;
+        return;
+    }
+    _in = std::fopen(file.c_str(), "rb");
+    if (_in == nullptr) {
+        std::cerr << "Unable to open " << file << ": " << std::strerror(errno) << std::endl;
+        return;
+    }
+    _input.reset(new char[BUFFER_SIZE]);
+#ifdef LOGPP_HAVE_ZSTD
+    if (_codec == codec_zstd)
+        _context = ZSTD_createDStream();
+#endif
+#ifdef LOGPP_HAVE_LZ4
+    LZ4F_dctx *context = nullptr;
+    if (_codec == codec_lz4 && !LZ4F_isError(LZ4F_createDecompressionContext(&context, LZ4F_VERSION)))
+        _context = context;
+#endif
+}
+
+SegmentReader::~SegmentReader() {
+    if (_gz != nullptr)
+        gzclose(_gz);
+    if (_in != nullptr)
+        std::fclose(_in);
+#ifdef LOGPP_HAVE_ZSTD
+    if (_codec == codec_zstd && _context != nullptr)
+        ZSTD_freeDStream(static_cast<ZSTD_DStream *>(_context));
+#endif
+#ifdef LOGPP_HAVE_LZ4
+    if (_codec == codec_lz4 && _context != nullptr)
+        LZ4F_freeDecompressionContext(static_cast<LZ4F_dctx *>(_context));
+#endif
+}
+
+Codec SegmentReader::codecOf(const std::string &file) {
+    auto endsWith = [&file](const char *extension) {
+        size_t length = std::strlen(extension);
+        return file.size() > length && file.compare(file.size() - length, length, extension) == 0;
+    };
+    if (endsWith(".gz"))
+        return codec_gzip;
+    if (endsWith(".zst"))
+        return codec_zstd;
+    if (endsWith(".lz4"))
+        return codec_lz4;
+    return codec_none;
+}
+
+bool SegmentReader::isOpen() const {
+    return _gz != nullptr || (_in != nullptr && _context != nullptr);
+}
+
+bool SegmentReader::hasError() const {
+    return _error;
+}
+
+bool SegmentReader::fill() {
+    if (_input_pos < _input_size)
+        return true;
+    if (_eof)
+        return false;
+    _input_pos = 0;
+    _input_size = std::fread(_input.get(), 1, BUFFER_SIZE, _in);
+    if (_input_size == 0) {
+        _eof = true;
+        _error = _error || std::ferror(_in) != 0;
+    }
+    return _input_size > 0;
+}
+
+size_t SegmentReader::read(char *buffer, size_t size) {
+    if (!isOpen() || _error || size == 0)
+        return 0;
+    if (_gz != nullptr) {
+        int n = gzread(_gz, buffer, static_cast<unsigned>(std::min<size_t>(size, BUFFER_SIZE)));
+        if (n < 0) {
+            int code;
+            std::cerr << _file << ": " << gzerror(_gz, &code) << std::endl;
+            _error = true;
+            return 0;
+        }
+        return static_cast<size_t>(n);
+    }
+    return _codec == codec_zstd ? readZstd(buffer, size) : readLz4(buffer, size);
+}
+
+size_t SegmentReader::readZstd(char *buffer, size_t size) {
+#ifdef LOGPP_HAVE_ZSTD
+    auto *stream = static_cast<ZSTD_DStream *>(_context);
+    ZSTD_outBuffer out{buffer, size, 0};
+    for (;;) {
+        bool more = fill();
+        ZSTD_inBuffer in{_input.get(), _input_size, _input_pos};
+        size_t hint = ZSTD_decompressStream(stream, &out, &in);
+        _input_pos = in.pos;
+        if (ZSTD_isError(hint)) {
+            std::cerr << _file << ": " << ZSTD_getErrorName(hint) << std::endl;
+            _error = true;
+            return out.pos;
+        }
+        // Output still held by the decoder comes out before the end of the input counts.
+        if (out.pos > 0)
+            return out.pos;
+        if (!more) {
+            if (hint != 0) {
+                std::cerr << _file << ": truncated zstd frame" << std::endl;
+                _error = true;
+            }
+            return 0;
+        }
+    }
+#else
+    (void) buffer;
+    (void) size;
+    return 0;
+#endif
+}
+
+size_t SegmentReader::readLz4(char *buffer, size_t size) {
+#ifdef LOGPP_HAVE_LZ4
+    auto *context = static_cast<LZ4F_dctx *>(_context);
+    for (;;) {
+        bool more = fill();
+        size_t produced = size;
+        size_t consumed = _input_size - _input_pos;
+        size_t hint = LZ4F_decompress(context, buffer, &produced, _input.get() + _input_pos, &consumed, nullptr);
+        _input_pos += consumed;
+        if (LZ4F_isError(hint)) {
+            std::cerr << _file << ": " << LZ4F_getErrorName(hint) << std::endl;
+            _error = true;
+            return 0;
+        }
+        if (produced > 0)
+            return produced;
+        if (!more) {
+            if (hint != 0) {
+                std::cerr << _file << ": truncated lz4 frame" << std::endl;
+                _error = true;
+            }
+            return 0;
+        }
+    }
+#else
+    (void) buffer;
+    (void) size;
+    return 0;
+#endif
+}
@@ -0,0 +1,393 @@
+// MIT License
+//
+// Copyright (c) 2023 Salomon Lee
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+#include <util/fio/UringWriter.hpp>
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <iostream>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+bool UringWriter::isConfigured(int buffers, long bufferSize, long fsyncMs) const {
+    return _buffer_count == static_cast<unsigned>(buffers) && _buffer_size == static_cast<size_t>(bufferSize) &&
+           _fsync_ms.count() == fsyncMs;
+}
+
+#ifdef LOGPP_HAVE_IO_URING
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <sys/uio.h>
+
+static constexpr uint64_t FSYNC_TAG = ~0ull;
+
+static void pwriteAll(int fd, const char *data, size_t size, long offset) {
+    while (size > 0) {
+        ssize_t n = ::pwrite(fd, data, size, offset);
+        if (n < 0 && errno == EINTR)
+            continue;
+        if (n <= 0)
+            return;
+        data += n;
+        size -= static_cast<size_t>(n);
+        offset += n;
+    }
+}
+
+/**
+ * Mapped submission and completion queues of one io_uring instance.
+ */
+struct UringWriter::Ring {
+    int fd{-1};
+    void *sq{MAP_FAILED};
+    size_t sq_size{0};
+    void *cq{MAP_FAILED};
+    size_t cq_size{0};
+    io_uring_sqe *sqes{static_cast<io_uring_sqe *>(MAP_FAILED)};
+    size_t sqes_size{0};
+    unsigned *sq_head{}, *sq_tail{}, *sq_mask{}, *sq_array{};
+    unsigned *cq_head{}, *cq_tail{}, *cq_mask{};
+    io_uring_cqe *cqes{};
+    unsigned to_submit{0};
+
+    explicit Ring(unsigned entries) {
+        io_uring_params params{};
+        fd = static_cast<int>(syscall(__NR_io_uring_setup, entries, &params));
+        if (fd < 0)
+            return;
+        sq_size = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+        cq_size = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+        bool single = params.features & IORING_FEAT_SINGLE_MMAP;
+        if (single)
+            sq_size = cq_size = std::max(sq_size, cq_size);
+        sq = mmap(nullptr, sq_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQ_RING);
+        cq = single ? sq : mmap(nullptr, cq_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd,
+                                IORING_OFF_CQ_RING);
+        sqes_size = params.sq_entries * sizeof(io_uring_sqe);
+        sqes = static_cast<io_uring_sqe *>(mmap(nullptr, sqes_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                                                fd, IORING_OFF_SQES));
+        if (sq == MAP_FAILED || cq == MAP_FAILED || sqes == MAP_FAILED) {
+            close();
+            return;
+        }
+        auto *s = static_cast<char *>(sq);
+        sq_head = reinterpret_cast<unsigned *>(s + params.sq_off.head);
+        sq_tail = reinterpret_cast<unsigned *>(s + params.sq_off.tail);
+        sq_mask = reinterpret_cast<unsigned *>(s + params.sq_off.ring_mask);
+        sq_array = reinterpret_cast<unsigned *>(s + params.sq_off.array);
+        auto *c = static_cast<char *>(cq);
+        cq_head = reinterpret_cast<unsigned *>(c + params.cq_off.head);
+        cq_tail = reinterpret_cast<unsigned *>(c + params.cq_off.tail);
+        cq_mask = reinterpret_cast<unsigned *>(c + params.cq_off.ring_mask);
+        cqes = reinterpret_cast<io_uring_cqe *>(c + params.cq_off.cqes);
+    }
+
+    ~Ring() {
+        close();
+    }
+
+    void close() {
+        if (sqes != MAP_FAILED)
+            munmap(sqes, sqes_size);
+        if (cq != MAP_FAILED && cq != sq)
+            munmap(cq, cq_size);
+        if (sq != MAP_FAILED)
+            munmap(sq, sq_size);
+        sq = cq = MAP_FAILED;
+        sqes = static_cast<io_uring_sqe *>(MAP_FAILED);
+        if (fd >= 0)
+            ::close(fd);
+        fd = -1;
+    }
+
+    [[nodiscard]] bool ready() const {
+        return fd >= 0;
+    }
+
+    int registerCall(unsigned opcode, const void *arg, unsigned count) const {
+        return static_cast<int>(syscall(__NR_io_uring_register, fd, opcode, arg, count));
+    }
+
+    io_uring_sqe *next() {
+        unsigned tail = *sq_tail;
+        unsigned index = tail & *sq_mask;
+        io_uring_sqe *sqe = &sqes[index];
+        std::memset(sqe, 0, sizeof(*sqe));
+        sq_array[index] = index;
+        __atomic_store_n(sq_tail, tail + 1, __ATOMIC_RELEASE);
+        to_submit++;
+        return sqe;
+    }
+
+    int enter(unsigned minComplete) {
+        unsigned flags = minComplete > 0 ? IORING_ENTER_GETEVENTS : 0;
+        int n = static_cast<int>(syscall(__NR_io_uring_enter, fd, to_submit, minComplete, flags, nullptr, 0));
+        if (n >= 0)
+            to_submit -= std::min<unsigned>(to_submit, static_cast<unsigned>(n));
+        return n;
+    }
+};
+
+UringWriter::UringWriter(unsigned buffers, size_t bufferSize, long fsyncMs)
+        : _ring(nullptr), _fd(-1), _offset(0), _buffer_size(bufferSize), _buffer_count(buffers), _in_flight(0),
+          _fsync_ms(fsyncMs), _last_fsync(std::chrono::steady_clock::now()) {
+    // One entry per buffer plus the fsync, the completion queue is twice that by default.
+    _ring = new Ring(buffers + 1);
+    if (!_ring->ready()) {
+        std::cerr << "io_uring unavailable (" << std::strerror(errno) << "), writing log files with writev" << std::endl;
+        delete _ring;
+        _ring = nullptr;
+        return;
+    }
+    std::vector<iovec> iov;
+    for (unsigned i = 0; i < buffers; i++) {
+        void *buffer = mmap(nullptr, bufferSize, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (buffer == MAP_FAILED)
+            break;
+        _buffers.push_back(static_cast<char *>(buffer));
+        iov.push_back(iovec{buffer, bufferSize});
+        _free.push_back(i);
+    }
+    _lengths.assign(_buffers.size(), 0);
+    _offsets.assign(_buffers.size(), 0);
+    if (_buffers.empty() || _ring->registerCall(IORING_REGISTER_BUFFERS, iov.data(), iov.size()) < 0) {
+        std::cerr << "io_uring buffer registration failed (" << std::strerror(errno) << "), writing log files with writev"
+                  << std::endl;
+        delete _ring;
+        _ring = nullptr;
+    }
+}
+
+UringWriter::~UringWriter() {
+    if (_ring != nullptr) {
+        sync();
+        delete _ring;
+    }
+    for (char *buffer : _buffers)
+        munmap(buffer, _buffer_size);
+    if (_fd >= 0)
+        ::close(_fd);
+}
+
+bool UringWriter::available() {
+    Ring ring(2);
+    return ring.ready();
+}
+
+bool UringWriter::isReady() const {
+    return _ring != nullptr;
+}
+
+bool UringWriter::attach(const std::string &filename) {
+    if (_ring == nullptr)
+        return false;
+    sync();
+    if (_fd >= 0) {
+        _ring->registerCall(IORING_UNREGISTER_FILES, nullptr, 0);
+        ::close(_fd);
+    }
+    _filename = filename;
+    // Its own descriptor without O_APPEND: writes carry explicit offsets, so completions may arrive
+    // in any order without reordering the file.
+    _fd = ::open(filename.c_str(), O_WRONLY | O_CREAT | O_CLOEXEC, 0644);
+    if (_fd < 0) {
+        std::cerr << "Error opening log file " << filename << ": " << std::strerror(errno) << std::endl;
+        return false;
+    }
+    struct stat st{};
+    _offset = (::fstat(_fd, &st) == 0) ? st.st_size : 0;
+    if (_ring->registerCall(IORING_REGISTER_FILES, &_fd, 1) < 0) {
+        std::cerr << "io_uring file registration failed for " << filename << ": " << std::strerror(errno) << std::endl;
+        ::close(_fd);
+        _fd = -1;
+        return false;
+    }
+    return true;
+}
+
+void UringWriter::submit(unsigned buffer) {
+    io_uring_sqe *sqe = _ring->next();
+    sqe->opcode = IORING_OP_WRITE_FIXED;
+    sqe->flags = IOSQE_FIXED_FILE;
+    sqe->fd = 0;
+    sqe->addr = reinterpret_cast<uint64_t>(_buffers[buffer]);
+    sqe->len = static_cast<uint32_t>(_lengths[buffer]);
+    sqe->off = static_cast<uint64_t>(_offsets[buffer]);
+    sqe->buf_index = static_cast<uint16_t>(buffer);
+    sqe->user_data = buffer;
+    _in_flight++;
+}
+
+void UringWriter::fsync() {
+    io_uring_sqe *sqe = _ring->next();
+    sqe->opcode = IORING_OP_FSYNC;
+    sqe->flags = IOSQE_FIXED_FILE | IOSQE_IO_DRAIN;
+    sqe->fd = 0;
+    sqe->fsync_flags = IORING_FSYNC_DATASYNC;
+    sqe->user_data = FSYNC_TAG;
+    _in_flight++;
+    _last_fsync = std::chrono::steady_clock::now();
+}
+
+void UringWriter::reap(unsigned min) {
+    while (_ring->to_submit > 0 || min > 0) {
+        int n = _ring->enter(min);
+        if (n < 0 && errno != EINTR && errno != EAGAIN && errno != EBUSY) {
+            std::cerr << "io_uring_enter failed for " << _filename << ": " << std::strerror(errno)
+                      << ", writing log files with writev" << std::endl;
+            drop();
+            return;
+        }
+        unsigned head = *_ring->cq_head;
+        unsigned tail = __atomic_load_n(_ring->cq_tail, __ATOMIC_ACQUIRE);
+        for (; head != tail; head++) {
+            const io_uring_cqe &cqe = _ring->cqes[head & *_ring->cq_mask];
+            _in_flight--;
+            min = min > 0 ? min - 1 : 0;
+            if (cqe.user_data == FSYNC_TAG) {
+                if (cqe.res < 0)
+                    std::cerr << "fdatasync of " << _filename << " failed: " << std::strerror(-cqe.res) << std::endl;
+                continue;
+            }
+            auto buffer = static_cast<unsigned>(cqe.user_data);
+            // A failed or short write is finished synchronously, the data is still in the buffer.
+            size_t done = cqe.res > 0 ? static_cast<size_t>(cqe.res) : 0;
+            while (done < _lengths[buffer]) {
+                ssize_t w = ::pwrite(_fd, _buffers[buffer] + done, _lengths[buffer] - done,
+                                     _offsets[buffer] + static_cast<long>(done));
+                if (w < 0 && errno == EINTR)
+                    continue;
+                if (w <= 0) {
+                    std::cerr << "Error writing log file " << _filename << ": " << std::strerror(w < 0 ? errno : -cqe.res)
+                              << std::endl;
+                    break;
+                }
+                done += static_cast<size_t>(w);
+            }
+            _free.push_back(buffer);
+        }
+        __atomic_store_n(_ring->cq_head, head, __ATOMIC_RELEASE);
+        if (_ring->to_submit == 0 && min == 0)
+            return;
+    }
+}
+
+void UringWriter::drop() {
+    // Rewriting a buffer whose completion was not reaped puts the same bytes at the same offset.
+    for (unsigned buffer = 0; buffer < _buffers.size(); buffer++)
+        if (std::find(_free.begin(), _free.end(), buffer) == _free.end())
+            pwriteAll(_fd, _buffers[buffer], _lengths[buffer], _offsets[buffer]);
+    delete _ring;
+    _ring = nullptr;
+    _free.clear();
+    for (unsigned buffer = 0; buffer < _buffers.size(); buffer++)
+        _free.push_back(buffer);
+    _in_flight = 0;
+}
+
+void UringWriter::write(const char *data, size_t size) {
+    if (_ring == nullptr || _fd < 0)
+        return;
+    while (size > 0) {
+        // The completion waited for may be the fsync, keep going until a buffer came back.
+        while (_ring != nullptr && _free.empty() && _in_flight > 0)
+            reap(1);
+        if (_ring == nullptr) {
+            pwriteAll(_fd, data, size, _offset);
+            _offset += static_cast<long>(size);
+            return;
+        }
+        if (_free.empty())
+            return;
+        unsigned buffer = _free.back();
+        _free.pop_back();
+        size_t n = std::min(size, _buffer_size);
+        std::memcpy(_buffers[buffer], data, n);
+        _lengths[buffer] = n;
+        _offsets[buffer] = _offset;
+        _offset += static_cast<long>(n);
+        submit(buffer);
+        data += n;
+        size -= n;
+    }
+    if (_fsync_ms.count() > 0 && std::chrono::steady_clock::now() - _last_fsync >= _fsync_ms)
+        fsync();
+    // One io_uring_enter for everything queued above, without waiting for completions.
+    reap(0);
+}
+
+void UringWriter::sync() {
+    if (_ring == nullptr)
+        return;
+    reap(_in_flight);
+}
+
+void UringWriter::crashWrite(const char *data, size_t size) {
+    if (_ring == nullptr || _fd < 0)
+        return;
+    // Rewriting a completed buffer puts the same bytes at the same offset, so every buffer not on
+    // the free list is written, whether its completion was reaped or not.
+    for (unsigned buffer = 0; buffer < _buffers.size(); buffer++)
+        if (std::find(_free.begin(), _free.end(), buffer) == _free.end())
+            pwriteAll(_fd, _buffers[buffer], _lengths[buffer], _offsets[buffer]);
+    pwriteAll(_fd, data, size, _offset);
+    _offset += static_cast<long>(size);
+}
+
+#else
+
+struct UringWriter::Ring {
+};
+
+UringWriter::UringWriter(unsigned buffers, size_t bufferSize, long fsyncMs)
+        : _ring(nullptr), _fd(-1), _offset(0), _buffer_size(bufferSize), _buffer_count(buffers), _in_flight(0),
+          _fsync_ms(fsyncMs) {
+    std::cerr << "io_uring support was not built in, writing log files with writev" << std::endl;
+}
+
+UringWriter::~UringWriter() = default;
+
+bool UringWriter::available() {
+    return false;
+}
+
+bool UringWriter::isReady() const {
+    return false;
+}
+
+bool UringWriter::attach(const std::string &) {
+    return false;
+}
+
+void UringWriter::write(const char *, size_t) {
+}
+
+void UringWriter::sync() {
+}
+
+void UringWriter::crashWrite(const char *, size_t) {
+}
+
+#endif
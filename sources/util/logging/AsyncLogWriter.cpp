@@ -0,0 +1,178 @@
+// MIT License
+//
+// Copyright (c) 2023 Salomon Lee
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+#include <util/logging/AsyncLogWriter.hpp>
+#include <util/properties/LogProperties.hpp>
+#include <util/logging/Log.hpp>
+#include <iostream>
+#include <ctime>
+#include <unistd.h>
+
+std::atomic<bool> AsyncLogWriter::_stopped{false};
+std::atomic<AsyncLogWriter *> AsyncLogWriter::_active{nullptr};
+std::atomic<bool> AsyncLogWriter::_crashing{false};
+
+AsyncLogWriter::AsyncLogWriter(size_t capacity, Overflow overflow) : _ring(capacity), _overflow(overflow) {
+    _thread = std::thread([this]() { run(); });
+    _active.store(this, std::memory_order_release);
+}
+
+AsyncLogWriter::~AsyncLogWriter() {
+    _active.store(nullptr, std::memory_order_release);
+    _stopped.store(true, std::memory_order_release);
+    _running.store(false, std::memory_order_release);
+    wake(true);
+    if (_thread.joinable())
+        _thread.join();
+}
+
+AsyncLogWriter *AsyncLogWriter::instance() {
+    if (_stopped.load(std::memory_order_acquire))
+        return nullptr;
+    const LogProperties *properties = LogProperties::instance();
+    // Sinks are set up first, so whatever they write through is destroyed after the writer drained.
+    static const bool sinks = SinkRegistry::instance()->current() != nullptr;
+    (void) sinks;
+    static AsyncLogWriter writer(properties->getAsyncCapacity(), properties->getOverflow());
+    return &writer;
+}
+
+void AsyncLogWriter::push(LogRecord &record) {
+    switch (_overflow) {
+        case overflow_drop_newest:
+            if (!_ring.tryPush(record)) {
+                _dropped.fetch_add(1, std::memory_order_relaxed);
+                return;
+            }
+            break;
+        case overflow_drop_oldest:
+            while (!_ring.tryPush(record)) {
+                LogRecord oldest;
+                if (_ring.tryPop(oldest)) {
+                    _dropped.fetch_add(1, std::memory_order_relaxed);
+                    _consumed.fetch_add(1, std::memory_order_release);
+                }
+            }
+            break;
+        default:
+            while (!_ring.tryPush(record)) {
+                wake(true);
+                std::this_thread::yield();
+            }
+            break;
+    }
+    wake(false);
+}
+
+void AsyncLogWriter::flush() {
+    size_t target = _ring.enqueued();
+    wake(true);
+    std::unique_lock<std::mutex> lock(_mutex);
+    while (_consumed.load(std::memory_order_acquire) < target && _running.load(std::memory_order_acquire))
+        _drained.wait_for(lock, std::chrono::milliseconds(10));
+}
+
+size_t AsyncLogWriter::getDropped() const {
+    return _dropped.load(std::memory_order_relaxed);
+}
+
+void AsyncLogWriter::crashDrain(void (*write)(const LogRecord &record)) {
+    AsyncLogWriter *writer = _active.load(std::memory_order_acquire);
+    if (writer == nullptr)
+        return;
+    writer->_batch.crashCommit();
+    writer->_ring.forEachPending(write);
+}
+
+void AsyncLogWriter::crashPark() {
+    _crashing.store(true);
+    AsyncLogWriter *writer = _active.load(std::memory_order_acquire);
+    if (writer == nullptr || std::this_thread::get_id() == writer->_thread.get_id())
+        return;
+    timespec pause{0, 1000000};
+    for (int i = 0; i < 100 && writer->_draining.load() > 0; i++)
+        nanosleep(&pause, nullptr);
+}
+
+void AsyncLogWriter::crashResume() {
+    _crashing.store(false);
+}
+
+void AsyncLogWriter::wake(bool force) {
+    if (force || _sleeping.load()) {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _wake.notify_one();
+    }
+}
+
+void AsyncLogWriter::run() {
+    Log::setThreadName("logpp-async");
+    for (;;) {
+        if (drain() > 0)
+            continue;
+        if (!_running.load(std::memory_order_acquire) && _ring.empty())
+            break;
+        std::unique_lock<std::mutex> lock(_mutex);
+        _sleeping.store(true);
+        if (_ring.empty() && _running.load(std::memory_order_acquire))
+            _wake.wait_for(lock, std::chrono::milliseconds(50));
+        _sleeping.store(false);
+    }
+    std::lock_guard<std::mutex> lock(_mutex);
+    _drained.notify_all();
+}
+
+size_t AsyncLogWriter::drain() {
+    _draining.fetch_add(1);
+    while (_crashing.load()) {
+        // The crash handler writes out what is left, this thread must not move records meanwhile.
+        _draining.fetch_sub(1);
+        timespec pause{0, 1000000};
+        nanosleep(&pause, nullptr);
+        _draining.fetch_add(1);
+    }
+    size_t n = drainBatch();
+    _draining.fetch_sub(1);
+    return n;
+}
+
+size_t AsyncLogWriter::drainBatch() {
+    LogRecord record;
+    size_t n = 0;
+    while (n < BATCH_SIZE && _ring.tryPop(record)) {
+        _batch.add(record);
+        n++;
+    }
+    if (n == 0) {
+        SinkRegistry::instance()->flushIfDue();
+        return 0;
+    }
+
+    _batch.commit();
+    std::cout.flush();
+
+    _consumed.fetch_add(n, std::memory_order_release);
+    std::lock_guard<std::mutex> lock(_mutex);
+    _drained.notify_all();
+    return n;
+}
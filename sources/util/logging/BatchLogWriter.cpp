@@ -0,0 +1,291 @@
+// MIT License
+//
+// Copyright (c) 2023 Salomon Lee
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+#include <util/logging/BatchLogWriter.hpp>
+#include <util/logging/Log.hpp>
+#include <algorithm>
+#include <functional>
+#include <ctime>
+#include <unistd.h>
+
+std::atomic<bool> BatchLogWriter::_stopped{false};
+std::atomic<BatchLogWriter *> BatchLogWriter::_active{nullptr};
+std::atomic<bool> BatchLogWriter::_crashing{false};
+
+BatchLogWriter::ThreadBuffers::~ThreadBuffers() {
+    BatchLogWriter *writer = BatchLogWriter::instance();
+    if (writer == nullptr)
+        return;
+    for (auto &buffer : buffers) {
+        Chunk *chunk = take(*buffer);
+        if (chunk != nullptr)
+            writer->handOff(chunk);
+    }
+    std::lock_guard<std::mutex> lock(writer->_buffers_mutex);
+    auto &all = writer->_buffers;
+    for (auto &buffer : buffers) {
+        for (auto &slot : writer->_crash_slots) {
+            ThreadBuffer *expected = buffer.get();
+            if (slot.compare_exchange_strong(expected, nullptr))
+                break;
+        }
+        all.erase(std::remove(all.begin(), all.end(), buffer), all.end());
+    }
+}
+
+BatchLogWriter::ThreadBuffer::~ThreadBuffer() {
+    delete chunk;
+    while (spare != nullptr) {
+        Chunk *next = spare->next;
+        delete spare;
+        spare = next;
+    }
+}
+
+BatchLogWriter::BatchLogWriter() {
+    _thread = std::thread([this]() { run(); });
+    _active.store(this, std::memory_order_release);
+}
+
+BatchLogWriter::~BatchLogWriter() {
+    _active.store(nullptr, std::memory_order_release);
+    _stopped.store(true, std::memory_order_release);
+    {
+        std::lock_guard<std::mutex> lock(_wake_mutex);
+        _running = false;
+    }
+    _wake.notify_all();
+    if (_thread.joinable())
+        _thread.join();
+    drain(true);
+    for (Chunk *chunk = _free.exchange(nullptr); chunk != nullptr;) {
+        Chunk *next = chunk->next;
+        delete chunk;
+        chunk = next;
+    }
+}
+
+BatchLogWriter *BatchLogWriter::instance() {
+    if (_stopped.load(std::memory_order_acquire))
+        return nullptr;
+    static BatchLogWriter writer;
+    return &writer;
+}
+
+BatchLogWriter::ThreadBuffer *BatchLogWriter::threadBuffer(LogAppender *appender) {
+    thread_local ThreadBuffers local;
+    for (auto &buffer : local.buffers)
+        if (buffer->appender == appender)
+            return buffer.get();
+    auto buffer = std::make_shared<ThreadBuffer>();
+    buffer->appender = appender;
+    local.buffers.push_back(buffer);
+    std::lock_guard<std::mutex> lock(_buffers_mutex);
+    _buffers.push_back(buffer);
+    for (auto &slot : _crash_slots) {
+        ThreadBuffer *expected = nullptr;
+        if (slot.compare_exchange_strong(expected, buffer.get()))
+            break;
+    }
+    return buffer.get();
+}
+
+BatchLogWriter::Chunk *BatchLogWriter::take(ThreadBuffer &buffer) {
+    while (buffer.lock.test_and_set(std::memory_order_acquire));
+    Chunk *chunk = buffer.chunk;
+    buffer.chunk = nullptr;
+    buffer.lock.clear(std::memory_order_release);
+    return chunk;
+}
+
+void BatchLogWriter::push(std::atomic<Chunk *> &stack, Chunk *chunk) {
+    chunk->next = stack.load(std::memory_order_relaxed);
+    while (!stack.compare_exchange_weak(chunk->next, chunk, std::memory_order_release, std::memory_order_relaxed));
+}
+
+void BatchLogWriter::handOff(Chunk *chunk) {
+    push(_full, chunk);
+}
+
+BatchLogWriter::Chunk *BatchLogWriter::newChunk(ThreadBuffer &buffer) {
+    if (buffer.spare == nullptr)
+        buffer.spare = _free.exchange(nullptr, std::memory_order_acquire);
+    Chunk *chunk = buffer.spare;
+    if (chunk != nullptr) {
+        buffer.spare = chunk->next;
+    } else {
+        chunk = new Chunk();
+        chunk->data.reserve(CHUNK_SIZE);
+    }
+    chunk->next = nullptr;
+    chunk->appender = buffer.appender;
+    // Chunks of one thread are created in order, sorting a batch by sequence keeps that order.
+    chunk->sequence = _sequence.fetch_add(1, std::memory_order_relaxed);
+    return chunk;
+}
+
+void BatchLogWriter::write(LogAppender *appender, std::string_view text, Level level) {
+    ThreadBuffer *buffer = threadBuffer(appender);
+    Chunk *full = nullptr;
+    while (buffer->lock.test_and_set(std::memory_order_acquire));
+    if (buffer->chunk == nullptr)
+        buffer->chunk = newChunk(*buffer);
+    buffer->chunk->data.append(text.data(), text.size());
+    if (level == log_error || buffer->chunk->data.size() >= CHUNK_SIZE) {
+        full = buffer->chunk;
+        buffer->chunk = nullptr;
+    }
+    buffer->lock.clear(std::memory_order_release);
+    if (full == nullptr)
+        return;
+    handOff(full);
+    if (level == log_error)
+        drain(false);
+    else
+        _wake.notify_one();
+}
+
+void BatchLogWriter::flush() {
+    drain(true);
+}
+
+void BatchLogWriter::drain(bool collect) {
+    _draining.fetch_add(1);
+    while (_crashing.load()) {
+        // The crash handler writes out what is left, this thread must not move chunks meanwhile.
+        _draining.fetch_sub(1);
+        timespec pause{0, 1000000};
+        nanosleep(&pause, nullptr);
+        _draining.fetch_add(1);
+    }
+    drainLocked(collect);
+    _draining.fetch_sub(1);
+}
+
+void BatchLogWriter::drainLocked(bool collect) {
+    std::lock_guard<std::mutex> drainLock(_drain_mutex);
+    _batch.clear();
+    // Partial chunks first: anything a thread handed off before its current chunk is then already
+    // on the stack and goes out in this batch too.
+    if (collect) {
+        std::lock_guard<std::mutex> lock(_buffers_mutex);
+        for (auto &buffer : _buffers) {
+            Chunk *chunk = take(*buffer);
+            if (chunk != nullptr)
+                _batch.push_back(chunk);
+        }
+    }
+    for (Chunk *chunk = _full.exchange(nullptr, std::memory_order_acquire); chunk != nullptr; chunk = chunk->next)
+        _batch.push_back(chunk);
+    if (_batch.empty())
+        return;
+
+    std::sort(_batch.begin(), _batch.end(), [](const Chunk *a, const Chunk *b) {
+        return a->appender != b->appender ? std::less<>()(a->appender, b->appender) : a->sequence < b->sequence;
+    });
+    for (size_t first = 0; first < _batch.size();) {
+        LogAppender *appender = _batch[first]->appender;
+        _iov.clear();
+        size_t last = first;
+        for (; last < _batch.size() && _batch[last]->appender == appender; last++)
+            _iov.push_back(iovec{_batch[last]->data.data(), _batch[last]->data.size()});
+        appender->writev(_iov.data(), static_cast<int>(_iov.size()));
+        first = last;
+    }
+    for (Chunk *chunk : _batch) {
+        // Oversized chunks, from lines longer than a chunk, are not worth keeping.
+        if (chunk->data.capacity() > 2 * CHUNK_SIZE) {
+            delete chunk;
+            continue;
+        }
+        chunk->data.clear();
+        push(_free, chunk);
+    }
+    _batch.clear();
+}
+
+void BatchLogWriter::run() {
+    Log::setThreadName("logpp-batch");
+    std::unique_lock<std::mutex> lock(_wake_mutex);
+    while (_running) {
+        bool due = _wake.wait_for(lock, FLUSH_INTERVAL) == std::cv_status::timeout;
+        lock.unlock();
+        drain(due);
+        lock.lock();
+    }
+}
+
+void BatchLogWriter::crashPark() {
+    _crashing.store(true);
+    BatchLogWriter *writer = _active.load(std::memory_order_acquire);
+    if (writer == nullptr)
+        return;
+    // A thread that crashed inside drain() counts itself, the wait is bounded for that case.
+    timespec pause{0, 1000000};
+    for (int i = 0; i < 100 && writer->_draining.load() > 0; i++)
+        nanosleep(&pause, nullptr);
+}
+
+void BatchLogWriter::crashDrain() {
+    BatchLogWriter *writer = _active.load(std::memory_order_acquire);
+    if (writer == nullptr)
+        return;
+    // Insertion sort of the list by sequence, there are only a few full chunks at any time.
+    Chunk *sorted = nullptr;
+    for (Chunk *chunk = writer->_full.exchange(nullptr, std::memory_order_acquire); chunk != nullptr;) {
+        Chunk *next = chunk->next;
+        Chunk **at = &sorted;
+        while (*at != nullptr && (*at)->sequence < chunk->sequence)
+            at = &(*at)->next;
+        chunk->next = *at;
+        *at = chunk;
+        chunk = next;
+    }
+    // Written chunks go back on the free stack emptied, in case the process survives the signal.
+    for (Chunk *chunk = sorted; chunk != nullptr;) {
+        Chunk *next = chunk->next;
+        chunk->appender->crashWrite(chunk->data);
+        chunk->data.clear();
+        push(writer->_free, chunk);
+        chunk = next;
+    }
+    for (auto &slot : writer->_crash_slots) {
+        ThreadBuffer *buffer = slot.load(std::memory_order_acquire);
+        if (buffer == nullptr)
+            continue;
+        // A thread interrupted while appending still holds the lock, its chunk is written as is.
+        bool locked = !buffer->lock.test_and_set(std::memory_order_acquire);
+        Chunk *chunk = buffer->chunk;
+        if (chunk != nullptr) {
+            buffer->appender->crashWrite(chunk->data);
+            if (locked)
+                chunk->data.clear();
+        }
+        if (locked)
+            buffer->lock.clear(std::memory_order_release);
+    }
+}
+
+void BatchLogWriter::crashResume() {
+    _crashing.store(false);
+}
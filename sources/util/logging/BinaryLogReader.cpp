@@ -0,0 +1,240 @@
+// MIT License
+//
+// Copyright (c) 2023 Salomon Lee
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+#include <util/logging/BinaryLogReader.hpp>
+#include <util/logging/Log.hpp>
+#include <cstring>
+#include <iostream>
+#include <zlib.h>
+
+BinaryLogReader::BinaryLogReader(const std::string &file) : _file(gzopen(file.c_str(), "rb")) {
+    if (_file == nullptr)
+        std::cerr << "Unable to open binary log " << file << std::endl;
+}
+
+BinaryLogReader::~BinaryLogReader() {
+    if (_file != nullptr)
+        gzclose(_file);
+}
+
+bool BinaryLogReader::isOpen() const {
+    return _file != nullptr;
+}
+
+long BinaryLogReader::getRecords() const {
+    return _records;
+}
+
+bool BinaryLogReader::isCorrupt() const {
+    return _corrupt;
+}
+
+bool BinaryLogReader::read(void *data, size_t size) {
+    if (size == 0)
+        return true;
+    int n = gzread(_file, data, static_cast<unsigned>(size));
+    if (n == static_cast<int>(size))
+        return true;
+    _corrupt = true;
+    return false;
+}
+
+bool BinaryLogReader::readText(std::string &text) {
+    uint32_t length;
+    if (!read(&length, sizeof(length)))
+        return false;
+    text.resize(length);
+    return read(text.data(), length);
+}
+
+bool BinaryLogReader::readSite() {
+    uint32_t id;
+    uint8_t level;
+    int32_t line;
+    Site site;
+    if (!read(&id, sizeof(id)) || !read(&level, sizeof(level)) || !read(&line, sizeof(line)) ||
+        !readText(site.file) || !readText(site.function) || !readText(site.format))
+        return false;
+    site.level = static_cast<Level>(level);
+    site.line = line;
+    if (id >= _sites.size())
+        _sites.resize(id + 1);
+    _sites[id] = std::move(site);
+    return true;
+}
+
+bool BinaryLogReader::readRecord(std::string &line) {
+    uint32_t id;
+    int64_t sec;
+    int32_t nsec;
+    uint8_t tid;
+    uint32_t payload;
+    if (!read(&id, sizeof(id)) || !read(&sec, sizeof(sec)) || !read(&nsec, sizeof(nsec)) || !read(&tid, sizeof(tid)))
+        return false;
+    if (tid > sizeof(_record.thread) || !read(_record.thread, tid) || !read(&payload, sizeof(payload)))
+        return false;
+    _payload.resize(payload);
+    if (!read(_payload.data(), payload))
+        return false;
+    if (id >= _sites.size() || _sites[id].format.empty()) {
+        std::cerr << "Binary log record refers to unknown site " << id << std::endl;
+        _corrupt = true;
+        return false;
+    }
+    const Site &site = _sites[id];
+    _record.level = site.level;
+    _record.time.tv_sec = static_cast<time_t>(sec);
+    _record.time.tv_nsec = nsec;
+    _record.thread_length = tid;
+    format(site);
+    line.clear();
+    Log::renderFile(_record, line);
+    _records++;
+    return true;
+}
+
+template<class T>
+static T take(const char *&p) {
+    T v;
+    std::memcpy(&v, p, sizeof(T));
+    p += sizeof(T);
+    return v;
+}
+
+/**
+ * Same rules as the compile time FormatString, but the format was already validated when the
+ * statement was compiled so anything unexpected is copied through verbatim.
+ */
+void BinaryLogReader::format(const Site &site) {
+    LogBuffer &message = _record.message;
+    message.clear();
+#ifdef LOGPP_SOURCE_LOCATION
+    // Text records written through a BinarySink carry the location in the message already.
+    if (!site.file.empty()) {
+        message.append('[');
+        message.append(site.file);
+        message.append(" - ");
+        message.append(site.function);
+        message.append("](line: ");
+        message.appendNumber(site.line);
+        message.append("): ");
+    }
+#endif
+    const std::string &fmt = site.format;
+    const char *p = _payload.data();
+    const char *end = p + _payload.size();
+    for (size_t i = 0; i < fmt.size(); i++) {
+        char c = fmt[i];
+        if ((c == '{' || c == '}') && i + 1 < fmt.size() && fmt[i + 1] == c) {
+            message.append(c);
+            i++;
+            continue;
+        }
+        size_t close = c == '{' ? fmt.find('}', i) : std::string::npos;
+        if (close == std::string::npos || p >= end) {
+            message.append(c);
+            continue;
+        }
+        char kind = close - i >= 3 ? fmt[close - 1] : 0;
+        int precision = -1;
+        if (kind == 'f' || kind == 'e')
+            precision = atoi(fmt.c_str() + i + 3);
+        i = close;
+        switch (*p++) {
+            case binary_int: {
+                auto v = take<int64_t>(p);
+                size_t start = message.size();
+                if (kind == 'x' || kind == 'X')
+                    message.appendNumber(v, 16);
+                else
+                    message.appendNumber(v);
+                if (kind == 'X')
+                    message.toUpper(start);
+                break;
+            }
+            case binary_uint: {
+                auto v = take<uint64_t>(p);
+                size_t start = message.size();
+                if (kind == 'x' || kind == 'X')
+                    message.appendNumber(v, 16);
+                else
+                    message.appendNumber(v);
+                if (kind == 'X')
+                    message.toUpper(start);
+                break;
+            }
+            case binary_double: {
+                auto v = take<double>(p);
+                if (precision >= 0)
+                    message.appendNumber(v, kind == 'f' ? std::chars_format::fixed : std::chars_format::scientific,
+                                         precision);
+                else
+                    message.appendNumber(v);
+                break;
+            }
+            case binary_bool:
+                message.append(*p++ ? '1' : '0');
+                break;
+            case binary_char:
+                message.append(*p++);
+                break;
+            case binary_string: {
+                auto length = take<uint32_t>(p);
+                message.append(p, length);
+                p += length;
+                break;
+            }
+            default:
+                p = end;
+                break;
+        }
+    }
+}
+
+bool BinaryLogReader::next(std::string &line) {
+    if (_file == nullptr)
+        return false;
+    uint8_t type;
+    while (gzread(_file, &type, 1) == 1) {
+        if (type == binary_segment) {
+            char magic[7];
+            if (!read(magic, sizeof(magic)) ||
+                std::memcmp(magic, BinaryLogWriter::segmentMagic().data() + 1, sizeof(magic)) != 0) {
+                std::cerr << "Binary log segment has an unknown header" << std::endl;
+                _corrupt = true;
+                return false;
+            }
+            _sites.clear();
+        } else if (type == binary_site) {
+            if (!readSite())
+                return false;
+        } else if (type == binary_record) {
+            return readRecord(line);
+        } else {
+            std::cerr << "Binary log has an unknown frame type " << static_cast<int>(type) << std::endl;
+            _corrupt = true;
+            return false;
+        }
+    }
+    return false;
+}
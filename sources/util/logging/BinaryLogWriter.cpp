@@ -0,0 +1,201 @@
+// MIT License
+//
+// Copyright (c) 2023 Salomon Lee
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+#include <util/logging/BinaryLogWriter.hpp>
+#include <util/logging/Log.hpp>
+#include <util/properties/LogProperties.hpp>
+#include <algorithm>
+#include <cstring>
+
+std::atomic<bool> BinaryLogWriter::_stopped{false};
+std::atomic<BinaryLogWriter *> BinaryLogWriter::_active{nullptr};
+
+BinaryLogWriter::ThreadBuffer::ThreadBuffer() : data(new char[CHUNK_SIZE]), capacity(CHUNK_SIZE) {
+    BinaryLogWriter *writer = BinaryLogWriter::instance();
+    if (writer != nullptr) {
+        std::lock_guard<std::mutex> lock(writer->_buffers_mutex);
+        writer->_buffers.push_back(this);
+    }
+}
+
+BinaryLogWriter::ThreadBuffer::~ThreadBuffer() {
+    BinaryLogWriter *writer = BinaryLogWriter::instance();
+    if (writer == nullptr)
+        return;
+    std::lock_guard<std::mutex> lock(writer->_buffers_mutex);
+    while (this->lock.test_and_set(std::memory_order_acquire));
+    writer->_orphans.append(data.get(), size);
+    size = 0;
+    this->lock.clear(std::memory_order_release);
+    auto &buffers = writer->_buffers;
+    buffers.erase(std::remove(buffers.begin(), buffers.end(), this), buffers.end());
+}
+
+BinaryLogWriter::BinaryLogWriter() {
+    _thread = std::thread([this]() { run(); });
+    _active.store(this, std::memory_order_release);
+}
+
+BinaryLogWriter::~BinaryLogWriter() {
+    _active.store(nullptr, std::memory_order_release);
+    _stopped.store(true, std::memory_order_release);
+    {
+        std::lock_guard<std::mutex> lock(_wake_mutex);
+        _running = false;
+    }
+    _wake.notify_all();
+    if (_thread.joinable())
+        _thread.join();
+    flush();
+}
+
+BinaryLogWriter *BinaryLogWriter::instance() {
+    if (_stopped.load(std::memory_order_acquire))
+        return nullptr;
+    static BinaryLogWriter writer;
+    return &writer;
+}
+
+BinaryLogWriter::ThreadBuffer *BinaryLogWriter::threadBuffer() {
+    thread_local ThreadBuffer buffer;
+    return &buffer;
+}
+
+std::string_view BinaryLogWriter::segmentMagic() {
+    return {SEGMENT_MAGIC, sizeof(SEGMENT_MAGIC)};
+}
+
+uint32_t BinaryLogWriter::registerSite(const char *file, const char *function, int line, Level level, const char *format) {
+    std::lock_guard<std::mutex> lock(_sites_mutex);
+    auto id = static_cast<uint32_t>(_sites.size());
+    _sites.push_back(BinarySite{id, level, file, function, line, format});
+    encodeSite(_sites.back(), _encoded_sites);
+    return id;
+}
+
+char *BinaryLogWriter::begin(size_t size) {
+    ThreadBuffer *buffer = threadBuffer();
+    while (buffer->lock.test_and_set(std::memory_order_acquire));
+    if (buffer->size + size > buffer->capacity) {
+        size_t capacity = std::max(buffer->capacity * 2, buffer->size + size);
+        std::unique_ptr<char[]> data(new char[capacity]);
+        std::memcpy(data.get(), buffer->data.get(), buffer->size);
+        buffer->data = std::move(data);
+        buffer->capacity = capacity;
+    }
+    return buffer->data.get() + buffer->size;
+}
+
+void BinaryLogWriter::commit(size_t size, Level level) {
+    ThreadBuffer *buffer = threadBuffer();
+    buffer->size += size;
+    size_t buffered = buffer->size;
+    buffer->lock.clear(std::memory_order_release);
+    if (level == log_error || buffered >= MAX_THREAD_BUFFER) {
+        flush();
+    } else if (buffered >= CHUNK_SIZE) {
+        _wake.notify_one();
+    }
+}
+
+void BinaryLogWriter::collect(std::string &out) {
+    std::lock_guard<std::mutex> lock(_buffers_mutex);
+    out += _orphans;
+    _orphans.clear();
+    for (ThreadBuffer *buffer : _buffers) {
+        while (buffer->lock.test_and_set(std::memory_order_acquire));
+        out.append(buffer->data.get(), buffer->size);
+        buffer->size = 0;
+        buffer->lock.clear(std::memory_order_release);
+    }
+}
+
+void BinaryLogWriter::flush() {
+    std::lock_guard<std::mutex> lock(_write_mutex);
+    std::string records;
+    collect(records);
+    if (records.empty())
+        return;
+
+    LogAppender *appender = LogProperties::instance()->getBinaryAppender();
+    _out.clear();
+    // A fresh segment, after start up or a rollover, repeats the header and every known site so it
+    // can be decoded on its own.
+    if (appender->getRollovers() != _segment) {
+        _segment = appender->getRollovers();
+        _sites_written = 0;
+        _out.append(SEGMENT_MAGIC, sizeof(SEGMENT_MAGIC));
+    }
+    {
+        std::lock_guard<std::mutex> sites(_sites_mutex);
+        _out.append(_encoded_sites, _sites_written);
+        _sites_written = _encoded_sites.size();
+    }
+    _out += records;
+    appender->write(_out, log_verbose);
+    appender->flush();
+}
+
+void BinaryLogWriter::crashDrain() {
+    BinaryLogWriter *writer = _active.load(std::memory_order_acquire);
+    // Records only make sense behind a segment header, which the first flush writes.
+    if (writer == nullptr || writer->_segment == ~0ul)
+        return;
+    LogAppender *appender = LogProperties::instance()->getBinaryAppender();
+    appender->crashWrite(std::string_view(writer->_encoded_sites).substr(writer->_sites_written));
+    appender->crashWrite(writer->_orphans);
+    for (ThreadBuffer *buffer : writer->_buffers)
+        appender->crashWrite(std::string_view(buffer->data.get(), buffer->size));
+}
+
+void BinaryLogWriter::run() {
+    Log::setThreadName("logpp-binary");
+    std::unique_lock<std::mutex> lock(_wake_mutex);
+    while (_running) {
+        _wake.wait_for(lock, FLUSH_INTERVAL);
+        lock.unlock();
+        flush();
+        lock.lock();
+    }
+}
+
+template<class T>
+static void put(std::string &out, T v) {
+    out.append(reinterpret_cast<const char *>(&v), sizeof(T));
+}
+
+static void putText(std::string &out, const char *text) {
+    auto length = static_cast<uint32_t>(std::strlen(text));
+    put(out, length);
+    out.append(text, length);
+}
+
+void BinaryLogWriter::encodeSite(const BinarySite &site, std::string &out) {
+    put<uint8_t>(out, binary_site);
+    put<uint32_t>(out, site.id);
+    put<uint8_t>(out, static_cast<uint8_t>(site.level));
+    put<int32_t>(out, site.line);
+    putText(out, site.file);
+    putText(out, site.function);
+    putText(out, site.format);
+}
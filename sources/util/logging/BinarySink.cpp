@@ -0,0 +1,87 @@
+// MIT License
+//
+// Copyright (c) 2023 Salomon Lee
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+#include <util/logging/BinarySink.hpp>
+#include <util/logging/BinaryLogWriter.hpp>
+#include <util/logging/Log.hpp>
+#include <cstring>
+
+BinarySink::BinarySink(Level minLevel) : Sink("binary", format_binary, minLevel) {
+    BinaryLogWriter::instance();
+}
+
+template<class T>
+static void put(std::string &out, T v) {
+    out.append(reinterpret_cast<const char *>(&v), sizeof(T));
+}
+
+/**
+ * Site of the text records of level. The site carries no source location, the message already
+ * starts with it.
+ */
+static uint32_t siteOf(BinaryLogWriter *writer, Level level) {
+    static std::atomic<uint32_t> sites[log_stealth + 1] = {};
+    uint32_t site = sites[level].load(std::memory_order_acquire);
+    if (site == 0) {
+        // Ids start at 0, so the table stores id + 1. A race registers a spare site, which is harmless.
+        site = writer->registerSite("", "", 0, level, "{}") + 1;
+        sites[level].store(site, std::memory_order_release);
+    }
+    return site - 1;
+}
+
+void BinarySink::render(const LogRecord &record, std::string &out) {
+    BinaryLogWriter *writer = BinaryLogWriter::instance();
+    if (writer == nullptr)
+        return;
+    put<uint8_t>(out, binary_record);
+    put<uint32_t>(out, siteOf(writer, record.level));
+    put<int64_t>(out, static_cast<int64_t>(record.time.tv_sec));
+    put<int32_t>(out, static_cast<int32_t>(record.time.tv_nsec));
+    put<uint8_t>(out, static_cast<uint8_t>(record.thread_length));
+    out.append(record.thread, record.thread_length);
+    // Location and fields travel in the text of the message, the record has a single string argument.
+    thread_local std::string text;
+    text.clear();
+    Log::appendLocation(record, text);
+    text.append(record.message.data(), record.message.size());
+    Log::appendFields(record, text);
+    put<uint32_t>(out, static_cast<uint32_t>(1 + 4 + text.size()));
+    put<uint8_t>(out, binary_string);
+    put<uint32_t>(out, static_cast<uint32_t>(text.size()));
+    out += text;
+}
+
+void BinarySink::write(std::string_view text, Level level) {
+    BinaryLogWriter *writer = BinaryLogWriter::instance();
+    if (writer == nullptr || text.empty())
+        return;
+    std::memcpy(writer->begin(text.size()), text.data(), text.size());
+    writer->commit(text.size(), level);
+}
+
+void BinarySink::flush() {
+    BinaryLogWriter *writer = BinaryLogWriter::instance();
+    if (writer != nullptr)
+        writer->flush();
+}
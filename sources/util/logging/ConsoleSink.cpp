@@ -0,0 +1,47 @@
+// MIT License
+//
+// Copyright (c) 2023 Salomon Lee
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+#include <util/logging/ConsoleSink.hpp>
+#include <iostream>
+#include <unistd.h>
+
+ConsoleSink::ConsoleSink(Level minLevel) : Sink("console", format_console, minLevel) {
+}
+
+void ConsoleSink::write(std::string_view text, Level) {
+    std::cout.write(text.data(), static_cast<std::streamsize>(text.size()));
+}
+
+void ConsoleSink::flush() {
+    std::cout.flush();
+}
+
+void ConsoleSink::crashWrite(std::string_view text) {
+    // Whatever std::cout still buffers is lost, it cannot be flushed from a signal handler.
+    while (!text.empty()) {
+        ssize_t n = ::write(STDOUT_FILENO, text.data(), text.size());
+        if (n <= 0)
+            return;
+        text.remove_prefix(static_cast<size_t>(n));
+    }
+}
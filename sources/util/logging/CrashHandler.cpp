@@ -0,0 +1,323 @@
+// MIT License
+//
+// Copyright (c) 2023 Salomon Lee
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+#include <util/logging/CrashHandler.hpp>
+#include <util/logging/AsyncLogWriter.hpp>
+#include <util/logging/BatchLogWriter.hpp>
+#include <util/logging/BinaryLogWriter.hpp>
+#include <util/logging/Log.hpp>
+#include <util/logging/SinkRegistry.hpp>
+#include <util/fio/LogAppender.hpp>
+#include <algorithm>
+#include <charconv>
+#include <cmath>
+#include <csignal>
+#include <cstring>
+#include <ctime>
+#include <dlfcn.h>
+#include <execinfo.h>
+#include <unistd.h>
+#include <sys/syscall.h>
+
+std::atomic<bool> CrashHandler::_installed{false};
+std::atomic<bool> CrashHandler::_backtrace{false};
+std::atomic<bool> CrashHandler::_handling{false};
+
+static const int SIGNALS[] = {SIGSEGV, SIGABRT, SIGBUS, SIGFPE};
+static const char *const SIGNAL_NAMES[] = {"SIGSEGV", "SIGABRT", "SIGBUS", "SIGFPE"};
+static constexpr size_t SIGNAL_COUNT = sizeof(SIGNALS) / sizeof(SIGNALS[0]);
+static struct sigaction previous[SIGNAL_COUNT];
+// Room to run the handler on after a stack overflow of the thread that installed it.
+static char alternateStack[64 * 1024];
+
+/**
+ * Fixed size text buffer, the handler cannot allocate.
+ */
+class CrashText {
+private:
+    char *_data;
+    size_t _size{0};
+    size_t _capacity;
+
+public:
+    CrashText(char *data, size_t capacity) : _data(data), _capacity(capacity) {
+    }
+
+    CrashText &operator<<(std::string_view text) {
+        size_t n = std::min(text.size(), _capacity - _size);
+        std::memcpy(_data + _size, text.data(), n);
+        _size += n;
+        return *this;
+    }
+
+    CrashText &operator<<(char c) {
+        if (_size < _capacity)
+            _data[_size++] = c;
+        return *this;
+    }
+
+    CrashText &number(unsigned long value, int base = 10) {
+        char digits[24];
+        size_t n = 0;
+        do {
+            digits[n++] = "0123456789abcdef"[value % base];
+            value /= base;
+        } while (value > 0);
+        while (n > 0)
+            *this << digits[--n];
+        return *this;
+    }
+
+    CrashText &json(std::string_view text) {
+        for (char c : text) {
+            if (c == '"' || c == '\\')
+                *this << '\\' << c;
+            else if (c == '\n')
+                *this << "\\n";
+            else if (static_cast<unsigned char>(c) < 0x20)
+                *this << "\\u00" << "0123456789abcdef"[(c >> 4) & 0xf] << "0123456789abcdef"[c & 0xf];
+            else
+                *this << c;
+        }
+        return *this;
+    }
+
+    void clear() {
+        _size = 0;
+    }
+
+    [[nodiscard]] std::string_view view() const {
+        return {_data, _size};
+    }
+};
+
+static char lineBuffer[64 * 1024];
+static char messageBuffer[16 * 1024];
+
+void CrashHandler::install(bool backtrace) {
+    _backtrace.store(backtrace, std::memory_order_relaxed);
+    if (_installed.exchange(true))
+        return;
+    if (backtrace) {
+        // The first backtrace() loads libgcc, which must not happen inside the handler.
+        void *frame;
+        ::backtrace(&frame, 1);
+    }
+    stack_t stack{};
+    if (sigaltstack(nullptr, &stack) == 0 && (stack.ss_flags & SS_DISABLE)) {
+        stack.ss_sp = alternateStack;
+        stack.ss_size = sizeof(alternateStack);
+        stack.ss_flags = 0;
+        sigaltstack(&stack, nullptr);
+    }
+    struct sigaction action{};
+    action.sa_sigaction = handle;
+    sigemptyset(&action.sa_mask);
+    action.sa_flags = SA_ONSTACK | SA_SIGINFO;
+    for (size_t i = 0; i < SIGNAL_COUNT; i++)
+        sigaction(SIGNALS[i], &action, &previous[i]);
+}
+
+void CrashHandler::uninstall() {
+    if (!_installed.exchange(false))
+        return;
+    for (size_t i = 0; i < SIGNAL_COUNT; i++)
+        sigaction(SIGNALS[i], &previous[i], nullptr);
+}
+
+bool CrashHandler::isInstalled() {
+    return _installed.load();
+}
+
+void CrashHandler::drain() {
+    // Writer threads keep running while the handler writes, stop them moving records first.
+    BatchLogWriter::crashPark();
+    AsyncLogWriter::crashPark();
+    LogAppender::crashFlushAll();
+    BatchLogWriter::crashDrain();
+    AsyncLogWriter::crashDrain(writeRecord);
+    BinaryLogWriter::crashDrain();
+}
+
+void CrashHandler::writeRecord(const LogRecord &record) {
+    writeRecord(record.level, record.time, std::string_view(record.thread, record.thread_length), record.site,
+                record.message.view(), &record.fields);
+}
+
+/**
+ * Text of a number field, std::to_chars does not allocate.
+ */
+static std::string_view numberOf(const LogField &field, char *buffer, size_t size) {
+    if (field.type == field_int)
+        return {buffer, static_cast<size_t>(std::to_chars(buffer, buffer + size, field.i).ptr - buffer)};
+    if (field.type == field_uint)
+        return {buffer, static_cast<size_t>(std::to_chars(buffer, buffer + size, field.u).ptr - buffer)};
+    return {buffer, static_cast<size_t>(std::to_chars(buffer, buffer + size, field.d).ptr - buffer)};
+}
+
+static void appendFields(CrashText &line, const LogFieldBuffer &fields, bool json) {
+    LogFields::forEach(fields, [&line, json](const LogField &field) {
+        char number[32];
+        std::string_view value = field.type == field_bool     ? (field.b ? "true" : "false")
+                                 : field.type == field_string ? field.text
+                                                              : numberOf(field, number, sizeof(number));
+        bool quoted;
+        if (json) {
+            quoted = field.type == field_string || (field.type == field_double && !std::isfinite(field.d));
+            line << ",\"";
+            line.json(field.key) << "\":";
+        } else {
+            // Same rule as Log::appendFields.
+            quoted = field.type == field_string && (value.empty() || std::any_of(value.begin(), value.end(), [](char c) {
+                return static_cast<unsigned char>(c) <= ' ' || c == '"' || c == '=' || c == '\\';
+            }));
+            line << ' ' << field.key << '=';
+        }
+        if (quoted) {
+            line << '"';
+            line.json(value) << '"';
+        } else {
+            line << value;
+        }
+    });
+}
+
+void CrashHandler::writeRecord(Level level, const timespec &time, std::string_view thread, const LogSite *site,
+                               std::string_view message, const LogFieldBuffer *fields) {
+    SinkRegistry *registry = SinkRegistry::instance();
+    const SinkRegistry::Snapshot *snapshot = registry->published();
+    if (snapshot == nullptr)
+        return;
+    // The file line without its local date, localtime_r is not async-signal-safe.
+    long micros = static_cast<long>(time.tv_sec) * 1000000L + time.tv_nsec / 1000;
+    std::string_view name = Log::nameOf(level);
+    CrashText line(lineBuffer, sizeof(lineBuffer));
+    for (const std::shared_ptr<Sink> &sink : snapshot->sinks) {
+        if (!sink->accepts(level))
+            continue;
+        line.clear();
+        switch (sink->getFormat()) {
+            case format_console:
+            case format_text:
+                line << name << std::string_view("        ", name.size() < 8 ? 8 - name.size() : 0) << "| (thx-id: "
+                     << thread << ") - (";
+                line.number(micros) << ") - ";
+#ifdef LOGPP_SOURCE_LOCATION
+                if (site != nullptr) {
+                    line << '[' << Log::fileOf(*site) << " - " << Log::functionOf(*site) << "](line: ";
+                    line.number(static_cast<unsigned long>(site->line)) << "): ";
+                }
+#endif
+                line << message;
+                if (fields != nullptr)
+                    appendFields(line, *fields, false);
+                line << '\n';
+                break;
+            case format_json:
+                line << "{\"epoch_us\":";
+                line.number(micros) << ",\"level\":\"" << name << "\",\"thread\":\"";
+                line.json(thread) << '"';
+#ifdef LOGPP_SOURCE_LOCATION
+                if (site != nullptr) {
+                    line << ",\"file\":\"";
+                    line.json(Log::fileOf(*site)) << "\",\"function\":\"";
+                    line.json(Log::functionOf(*site)) << "\",\"line\":";
+                    line.number(static_cast<unsigned long>(site->line));
+                }
+#endif
+                line << ",\"message\":\"";
+                line.json(message) << '"';
+                if (fields != nullptr)
+                    appendFields(line, *fields, true);
+                line << "}\n";
+                break;
+            default:
+                continue;
+        }
+        sink->crashWrite(line.view());
+    }
+}
+
+void CrashHandler::handle(int signal, siginfo_t *info, void *context) {
+    size_t index = 0;
+    while (index < SIGNAL_COUNT && SIGNALS[index] != signal)
+        index++;
+    // A second fault while draining goes straight to the previous handler.
+    bool handling = index < SIGNAL_COUNT && !_handling.exchange(true);
+    if (handling) {
+        drain();
+
+        CrashText message(messageBuffer, sizeof(messageBuffer));
+        message << "Fatal signal ";
+        message.number(static_cast<unsigned long>(signal)) << " (" << SIGNAL_NAMES[index] << ")";
+        if (_backtrace.load(std::memory_order_relaxed)) {
+            void *frames[64];
+            int count = ::backtrace(frames, 64);
+            for (int i = 0; i < count; i++) {
+                // dladdr is not on the async-signal-safe list, but takes no lock for a loaded object.
+                Dl_info info{};
+                auto address = reinterpret_cast<uintptr_t>(frames[i]);
+                message << "\n    #";
+                message.number(i) << ' ';
+                if (dladdr(frames[i], &info) != 0 && info.dli_fname != nullptr) {
+                    bool symbol = info.dli_sname != nullptr;
+                    message << info.dli_fname << '(' << (symbol ? info.dli_sname : "") << "+0x";
+                    message.number(address - reinterpret_cast<uintptr_t>(symbol ? info.dli_saddr : info.dli_fbase), 16)
+                            << ") ";
+                }
+                message << "[0x";
+                message.number(address, 16) << ']';
+            }
+        }
+        timespec now{};
+        clock_gettime(CLOCK_REALTIME, &now);
+        char thread[24];
+        CrashText id(thread, sizeof(thread));
+        id.number(static_cast<unsigned long>(syscall(SYS_gettid)));
+        writeRecord(log_error, now, id.view(), nullptr, message.view(), nullptr);
+    }
+    if (index < SIGNAL_COUNT) {
+        struct sigaction &before = previous[index];
+        bool chained = (before.sa_flags & SA_SIGINFO) != 0 || (before.sa_handler != SIG_DFL && before.sa_handler != SIG_IGN);
+        if (chained) {
+            if (before.sa_flags & SA_SIGINFO)
+                before.sa_sigaction(signal, info, context);
+            else
+                before.sa_handler(signal);
+            // The previous handler recovered, the process goes on logging and may crash later.
+            if (handling) {
+                LogAppender::crashResumeAll();
+                AsyncLogWriter::crashResume();
+                BatchLogWriter::crashResume();
+                _handling.store(false);
+            }
+            return;
+        }
+        struct sigaction fallback{};
+        fallback.sa_handler = SIG_DFL;
+        sigemptyset(&fallback.sa_mask);
+        sigaction(signal, &fallback, nullptr);
+    }
+    // Delivered once this handler returns, a hardware fault also repeats on its own.
+    raise(signal);
+}
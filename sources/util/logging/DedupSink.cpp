@@ -0,0 +1,146 @@
+// MIT License
+//
+// Copyright (c) 2023 Salomon Lee
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+#include <util/logging/DedupSink.hpp>
+#include <util/logging/SinkRegistry.hpp>
+#include <util/Date.hpp>
+#include <functional>
+#include <string_view>
+#include <utility>
+
+DedupSink::DedupSink(std::shared_ptr<Sink> inner, long timeoutMs) : Sink(inner->getName(), format_custom,
+                                                                         inner->getMinLevel()),
+                                                                    _inner(std::move(inner)), _timeout_ms(timeoutMs) {
+}
+
+const std::shared_ptr<Sink> &DedupSink::getInner() const {
+    return _inner;
+}
+
+size_t DedupSink::hashOf(const LogRecord &record) {
+    std::hash<std::string_view> hash;
+    size_t h = hash(std::string_view(record.message.data(), record.message.size()));
+    h ^= hash(std::string_view(record.fields.data(), record.fields.size())) + 0x9E3779B97F4A7C15ull + (h << 6) + (h >> 2);
+    // The same text from another statement is not a repeat.
+    h ^= std::hash<const LogSite *>()(record.site) + 0x9E3779B97F4A7C15ull + (h << 6) + (h >> 2);
+    return h ^ (static_cast<size_t>(record.level) << 1);
+}
+
+long DedupSink::millisBetween(const timespec &from, const timespec &to) {
+    return (to.tv_sec - from.tv_sec) * 1000 + (to.tv_nsec - from.tv_nsec) / 1000000;
+}
+
+void DedupSink::render(const LogRecord &record, std::string &out) {
+    if (_inner->getFormat() == format_custom)
+        _inner->format(record, out);
+    else
+        SinkRegistry::render(_inner->getFormat(), record, out);
+}
+
+void DedupSink::appendRepeated(Run &run, std::string &out) {
+    LogRecord record;
+    record.level = run.level;
+    record.time = run.last;
+    std::copy(run.thread, run.thread + run.thread_length, record.thread);
+    record.thread_length = run.thread_length;
+    record.message.append("last message repeated ");
+    record.message.appendNumber(run.repeats);
+    record.message.append(run.repeats == 1 ? " time" : " times");
+    render(record, out);
+    run.repeats = 0;
+}
+
+void DedupSink::sweep(const timespec &now, std::string &out) {
+    for (auto it = _runs.begin(); it != _runs.end();) {
+        Run &run = it->second;
+        if (run.repeats > 0 && millisBetween(run.first, now) >= _timeout_ms) {
+            appendRepeated(run, out);
+            run.first = now;
+        }
+        // Runs of threads that went quiet are forgotten, their next record is written again.
+        if (run.repeats == 0 && millisBetween(run.last, now) >= _timeout_ms)
+            it = _runs.erase(it);
+        else
+            ++it;
+    }
+    _last_sweep = now;
+}
+
+void DedupSink::format(const LogRecord &record, std::string &out) {
+    size_t hash = hashOf(record);
+    size_t thread = std::hash<std::string_view>()(std::string_view(record.thread, record.thread_length));
+    std::lock_guard<std::mutex> lock(_mutex);
+    Run &run = _runs[thread];
+    if (run.thread_length > 0 && run.hash == hash) {
+        run.repeats++;
+        run.last = record.time;
+        if (millisBetween(run.first, record.time) >= _timeout_ms) {
+            appendRepeated(run, out);
+            run.first = record.time;
+        }
+    } else {
+        if (run.repeats > 0)
+            appendRepeated(run, out);
+        run.hash = hash;
+        run.level = record.level;
+        run.first = record.time;
+        run.last = record.time;
+        std::copy(record.thread, record.thread + record.thread_length, run.thread);
+        run.thread_length = record.thread_length;
+        render(record, out);
+    }
+    if (millisBetween(_last_sweep, record.time) >= _timeout_ms)
+        sweep(record.time, out);
+}
+
+void DedupSink::write(std::string_view text, Level level) {
+    _inner->write(text, level);
+}
+
+void DedupSink::flush() {
+    std::string out;
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        for (auto &run : _runs)
+            if (run.second.repeats > 0)
+                appendRepeated(run.second, out);
+    }
+    if (!out.empty())
+        _inner->write(out, log_verbose);
+    _inner->flush();
+}
+
+void DedupSink::flushIfDue() {
+    std::string out;
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        sweep(Date::now(), out);
+    }
+    if (!out.empty())
+        _inner->write(out, log_verbose);
+    _inner->flushIfDue();
+}
+
+void DedupSink::crashWrite(std::string_view text) {
+    _inner->crashWrite(text);
+}
@@ -0,0 +1,49 @@
+// MIT License
+//
+// Copyright (c) 2023 Salomon Lee
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+#include <util/logging/FileSink.hpp>
+#include <utility>
+
+FileSink::FileSink(std::string name, SinkFormat format, LogAppender *appender, Level minLevel)
+        : Sink(std::move(name), format, minLevel), _appender(appender) {
+}
+
+LogAppender *FileSink::getAppender() const {
+    return _appender;
+}
+
+void FileSink::write(std::string_view text, Level level) {
+    _appender->write(text, level);
+}
+
+void FileSink::flush() {
+    _appender->flush();
+}
+
+void FileSink::flushIfDue() {
+    _appender->flushIfDue();
+}
+
+void FileSink::crashWrite(std::string_view text) {
+    _appender->crashWrite(text);
+}
@@ -0,0 +1,104 @@
+// MIT License
+//
+// Copyright (c) 2023 Salomon Lee
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+#include <util/logging/FlushTimer.hpp>
+#include <util/logging/Log.hpp>
+#include <util/logging/LogLimit.hpp>
+#include <util/logging/SinkRegistry.hpp>
+#include <util/properties/LogProperties.hpp>
+#include <algorithm>
+#include <chrono>
+
+std::atomic<bool> FlushTimer::_stopped{false};
+std::atomic<FlushTimer *> FlushTimer::_active{nullptr};
+
+FlushTimer *FlushTimer::instance() {
+    if (_stopped.load(std::memory_order_acquire))
+        return nullptr;
+    static FlushTimer timer;
+    _active.store(&timer, std::memory_order_release);
+    return &timer;
+}
+
+FlushTimer::~FlushTimer() {
+    _stopped.store(true, std::memory_order_release);
+    _active.store(nullptr, std::memory_order_release);
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _interval_ms = 0;
+    }
+    _wake.notify_all();
+    if (_thread.joinable())
+        _thread.join();
+    if (LogProperties::instance()->getLimitReportMs() > 0)
+        LogLimit::report();
+}
+
+void FlushTimer::reschedule(const LogProperties *properties) {
+    long interval = 0;
+    auto every = [&interval](long ms) { interval = interval > 0 ? std::min(interval, ms) : ms; };
+    if (!properties->isAsync() && properties->getFlush() == flush_ms)
+        every(properties->getFlushMs());
+    if (!properties->isAsync() && properties->isDedup())
+        every(properties->getDedupTimeoutMs());
+    if (properties->getLimitReportMs() > 0 && LogLimit::isReporting())
+        every(properties->getLimitReportMs());
+    // Nothing to stop when no policy has started the timer yet.
+    FlushTimer *timer = interval > 0 ? instance() : _active.load(std::memory_order_acquire);
+    if (timer != nullptr)
+        timer->schedule(interval);
+}
+
+void FlushTimer::schedule(long intervalMs) {
+    std::lock_guard<std::mutex> lock(_mutex);
+    _interval_ms = intervalMs;
+    _wake.notify_all();
+    if (intervalMs <= 0 || _running)
+        return;
+    // A thread that stopped for an interval of 0 has left its loop, joining it does not wait long.
+    if (_thread.joinable())
+        _thread.join();
+    _running = true;
+    _thread = std::thread(&FlushTimer::run, this);
+}
+
+void FlushTimer::run() {
+    Log::setThreadName("logpp-timer");
+    std::unique_lock<std::mutex> lock(_mutex);
+    while (_interval_ms > 0) {
+        // Half the interval, so whatever became due right after a tick waits less than 1.5 of it.
+        long wait = std::max(1L, _interval_ms / 2);
+        if (_wake.wait_for(lock, std::chrono::milliseconds(wait)) == std::cv_status::no_timeout)
+            continue;
+        lock.unlock();
+        tick();
+        lock.lock();
+    }
+    _running = false;
+}
+
+void FlushTimer::tick() {
+    if (!LogProperties::instance()->isAsync())
+        SinkRegistry::instance()->flushIfDue();
+    LogLimit::reportIfDue();
+}
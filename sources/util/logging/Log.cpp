@@ -22,74 +22,324 @@
 //
 
 #include <util/logging/Log.hpp>
-#include <thread>
+#include <util/logging/AsyncLogWriter.hpp>
+#include <util/logging/Logger.hpp>
+#include <util/logging/SinkRegistry.hpp>
+#include <util/LogUtil.hpp>
 #include <iostream>
+#include <cstring>
+#include <charconv>
+#include <algorithm>
+#include <cmath>
+#include <pthread.h>
+#include <unistd.h>
+#include <sys/syscall.h>
 
 
-Log::Log(const std::string &fileName, const std::string &funcName, const long& line, Level l) {
-    _log_properties = nullptr;
-    std::thread::id tid = std::this_thread::get_id();
-    std::stringstream ss_tid;
-    ss_tid << tid;
-    _log_level = l;
-    _stream << Log::toString(l, true) << " (thx-id: " << ss_tid.str() << ") - " << NOW_TS;
-#ifdef DEBUG
-    _stream << "- [" << fileName << " - " << funcName << "](line: " << line << "): ";
-#endif
-    std::stringstream ss_ts;
-    ss_ts << Date::timestamp();
-    _log_line = Log::toString(l, false) + " (thx-id: " + ss_tid.str() + ") - " + NOW_TS + "(" + ss_ts.str() + ") - ";
-#ifdef DEBUG
-    _log_line += "[" + fileName + " - " + funcName + "](line: " + std::to_string(line) +  "): ";
-#endif
+std::atomic<bool> Log::_basename{false};
+std::atomic<bool> Log::_short_function{false};
+
+Log::Log(const LogSite *site, Level l, const Logger *logger) {
+    std::string_view tid = threadId();
+    _record.level = l;
+    _record.site = site;
+    _record.logger = logger;
+    _record.time = Date::now();
+    std::memcpy(_record.thread, tid.data(), tid.size());
+    _record.thread_length = tid.size();
 }
 
 Log::~Log() {
-//    bool LOG_STEALTH = false;
-    _stream << "\n";
-    std::string line;
+    const LogProperties *properties = LogProperties::instance();
+    // Levels may have changed since the macro checked them, module and logger levels included.
+    Level l = _record.level;
+    bool enabled = _record.logger != nullptr ? _record.logger->isEnabled(l)
+                   : _record.site != nullptr ? isEnabled(l, _record.site->file) : isEnabled(l);
+    if (!enabled)
+        return;
+    if (properties->isAsync()) {
+        AsyncLogWriter *writer = AsyncLogWriter::instance();
+        if (writer != nullptr) {
+            Level level = _record.level;
+            writer->push(_record);
+            if (level == log_error)
+                writer->flush();
+            return;
+        }
+    }
+    SinkRegistry::instance()->write(_record);
+}
 
-    if (_log_properties == nullptr) {
-        _log_properties = new LogProperties("./resources/logging.properties");
-        defineLogLevels(_log_properties->getLogLevel());
+// Plain arrays need no thread_local initialization guard on the path of every statement.
+static thread_local char threadPrefix[sizeof(LogRecord::thread)];
+static thread_local size_t threadPrefixLength = 0;
+
+static void formatThreadPrefix(std::string_view name) {
+    char *end = std::to_chars(threadPrefix, threadPrefix + sizeof(threadPrefix), syscall(SYS_gettid)).ptr;
+    if (!name.empty() && end < threadPrefix + sizeof(threadPrefix) - 1) {
+        *end++ = ':';
+        size_t length = std::min(name.size(), static_cast<size_t>(threadPrefix + sizeof(threadPrefix) - end));
+        std::memcpy(end, name.data(), length);
+        // A ')' or line break would end the thx-id field early for parseHead and logpp-grep.
+        std::replace_if(end, end + length, [](char c) { return c == ')' || c == '\n' || c == '\r'; }, '_');
+        end += length;
     }
-    switch (_log_level) {
-        case log_error:
-            if (_is_level_error)
-                line = _stream.str();
+    threadPrefixLength = end - threadPrefix;
+}
+
+/**
+ * The child of a fork runs on a new kernel thread, it keeps the name but not the id.
+ */
+static void reformatThreadPrefix() {
+    if (threadPrefixLength == 0)
+        return;
+    std::string_view prefix(threadPrefix, threadPrefixLength);
+    size_t colon = prefix.find(':');
+    char name[sizeof(threadPrefix)];
+    size_t length = colon == std::string_view::npos ? 0 : prefix.copy(name, sizeof(name), colon + 1);
+    formatThreadPrefix(std::string_view(name, length));
+}
+
+static const int forkHandler = pthread_atfork(nullptr, nullptr, reformatThreadPrefix);
+
+std::ostringstream &Log::stream() {
+    thread_local std::ostringstream ss;
+    ss.str(std::string());
+    ss.clear();
+    ss.flags(std::ios_base::dec | std::ios_base::skipws);
+    ss.precision(6);
+    ss.width(0);
+    ss.fill(' ');
+    return ss;
+}
+
+std::string_view Log::threadId() {
+    if (threadPrefixLength == 0)
+        formatThreadPrefix(std::string_view());
+    return {threadPrefix, threadPrefixLength};
+}
+
+void Log::setThreadName(std::string_view name) {
+    char kernelName[16];
+    size_t length = name.copy(kernelName, sizeof(kernelName) - 1);
+    kernelName[length] = '\0';
+    pthread_setname_np(pthread_self(), kernelName);
+    formatThreadPrefix(name);
+}
+
+void Log::appendHead(const LogRecord &record, bool isStdOut, std::string &out) {
+    char when[Date::FORMAT_SIZE];
+    out += Log::toString(record.level, isStdOut);
+    out += " (thx-id: ";
+    out.append(record.thread, record.thread_length);
+    out += ") - ";
+    out.append(when, Date::format(record.time, when));
+}
+
+void Log::renderConsole(const LogRecord &record, std::string &out) {
+    appendHead(record, true, out);
+#ifdef LOGPP_SOURCE_LOCATION
+    if (record.site != nullptr)
+        out += "- ";
+#endif
+    appendLocation(record, out);
+    out.append(record.message.data(), record.message.size());
+    appendFields(record, out);
+    out += '\n';
+}
+
+void Log::renderFile(const LogRecord &record, std::string &out) {
+    appendHead(record, false, out);
+    char micros[24];
+    out += '(';
+    out.append(micros, std::to_chars(micros, micros + sizeof(micros), Date::toMicros(record.time)).ptr - micros);
+    out += ") - ";
+    appendLocation(record, out);
+    out.append(record.message.data(), record.message.size());
+    appendFields(record, out);
+    out += '\n';
+}
+
+void Log::renderJson(const LogRecord &record, std::string &out) {
+    char when[Date::FORMAT_SIZE];
+    size_t length = Date::format(record.time, when);
+    char micros[24];
+    out += "{\"time\":\"";
+    out.append(when, length > 0 && when[length - 1] == ' ' ? length - 1 : length);
+    out += "\",\"epoch_us\":";
+    out.append(micros, std::to_chars(micros, micros + sizeof(micros), Date::toMicros(record.time)).ptr - micros);
+    out += ",\"level\":\"";
+    out += nameOf(record.level);
+    out += "\",\"thread\":\"";
+    LogUtil::appendJsonEscaped(out, std::string_view(record.thread, record.thread_length));
+    if (record.logger != nullptr && !record.logger->getName().empty()) {
+        out += "\",\"logger\":\"";
+        LogUtil::appendJsonEscaped(out, record.logger->getName());
+    }
+    out += '"';
+#ifdef LOGPP_SOURCE_LOCATION
+    if (record.site != nullptr) {
+        char line[24];
+        out += ",\"file\":\"";
+        LogUtil::appendJsonEscaped(out, fileOf(*record.site));
+        out += "\",\"function\":\"";
+        LogUtil::appendJsonEscaped(out, functionOf(*record.site));
+        out += "\",\"line\":";
+        out.append(line, std::to_chars(line, line + sizeof(line), record.site->line).ptr - line);
+    }
+#endif
+    out += ",\"message\":\"";
+    LogUtil::appendJsonEscaped(out, record.message.view());
+    out += '"';
+    appendJsonFields(record, out);
+    out += "}\n";
+}
+
+void Log::appendLocation(const LogRecord &record, std::string &out) {
+#ifdef LOGPP_SOURCE_LOCATION
+    if (record.site == nullptr)
+        return;
+    char line[24];
+    out += '[';
+    out += fileOf(*record.site);
+    out += " - ";
+    out += functionOf(*record.site);
+    out += "](line: ";
+    out.append(line, std::to_chars(line, line + sizeof(line), record.site->line).ptr - line);
+    out += "): ";
+#endif
+}
+
+std::string_view Log::fileOf(const LogSite &site) {
+    return _basename.load(std::memory_order_relaxed) ? LogSite::basename(site.file) : site.file;
+}
+
+std::string_view Log::functionOf(const LogSite &site) {
+    return _short_function.load(std::memory_order_relaxed) ? LogSite::shortFunction(site.function) : site.function;
+}
+
+void Log::useLocation(bool basename, bool shortFunction) {
+    _basename.store(basename, std::memory_order_relaxed);
+    _short_function.store(shortFunction, std::memory_order_relaxed);
+}
+
+static void appendNumber(std::string &out, const LogField &field) {
+    char number[32];
+    char *end = number;
+    switch (field.type) {
+        case field_int:
+            end = std::to_chars(number, number + sizeof(number), field.i).ptr;
             break;
-        case log_debug:
-            if (_is_level_debug)
-                line = _stream.str();
+        case field_uint:
+            end = std::to_chars(number, number + sizeof(number), field.u).ptr;
             break;
-        case log_trace:
-            if (_is_level_trace)
-                line = _stream.str();
+        default:
+            end = std::to_chars(number, number + sizeof(number), field.d).ptr;
             break;
+    }
+    out.append(number, end - number);
+}
+
+void Log::appendFields(const LogRecord &record, std::string &out) {
+    LogFields::forEach(record.fields, [&out](const LogField &field) {
+        out += ' ';
+        out += field.key;
+        out += '=';
+        if (field.type == field_bool) {
+            out += field.b ? "true" : "false";
+        } else if (field.type != field_string) {
+            appendNumber(out, field);
+        } else if (!field.text.empty() && std::none_of(field.text.begin(), field.text.end(), [](char c) {
+            return static_cast<unsigned char>(c) <= ' ' || c == '"' || c == '=' || c == '\\';
+        })) {
+            out += field.text;
+        } else {
+            out += '"';
+            LogUtil::appendJsonEscaped(out, field.text);
+            out += '"';
+        }
+    });
+}
+
+void Log::appendJsonFields(const LogRecord &record, std::string &out) {
+    LogFields::forEach(record.fields, [&out](const LogField &field) {
+        out += ",\"";
+        LogUtil::appendJsonEscaped(out, field.key);
+        out += "\":";
+        if (field.type == field_bool) {
+            out += field.b ? "true" : "false";
+        } else if (field.type == field_string) {
+            out += '"';
+            LogUtil::appendJsonEscaped(out, field.text);
+            out += '"';
+        } else if (field.type == field_double && !std::isfinite(field.d)) {
+            // JSON has no infinities or NaN, they go out as the strings "inf", "-inf" and "nan".
+            out += '"';
+            appendNumber(out, field);
+            out += '"';
+        } else {
+            appendNumber(out, field);
+        }
+    });
+}
+
+std::string_view Log::nameOf(Level l) {
+    switch (l) {
         case log_info:
-            if (_is_level_info)
-                line = _stream.str();
-            break;
+            return "INFO";
+        case log_trace:
+            return "TRACE";
+        case log_error:
+            return "ERROR";
+        case log_debug:
+            return "DEBUG";
         case log_warning:
-            if (_is_level_warning)
-                line = _stream.str();
-            break;
+            return "WARNING";
         default:
-            line = _stream.str();
-            break;
+            return "LOG";
     }
+}
 
-    if (!_is_level_silent) {
-        if (!line.empty() && !_is_Level_stealth && !_is_level_silent) {
-            std::cout << line;
-            LogAppender(_log_properties->getLogFile(),_log_properties->getMaxSzBytes(), _log_properties->getRolloverLimit(), _log_properties->getLogPath())
-            .write( _log_line + "\n");
+static bool levelOf(std::string_view name, Level &level) {
+    for (Level l : {log_info, log_trace, log_error, log_debug, log_warning, log_verbose}) {
+        if (Log::nameOf(l) == name) {
+            level = l;
+            return true;
         }
     }
+    return false;
+}
+
+static bool parseMicros(std::string_view text, long &micros) {
+    auto [end, error] = std::from_chars(text.data(), text.data() + text.size(), micros);
+    return error == std::errc() && end != text.data();
+}
+
+bool Log::parseHead(std::string_view line, Level &level, long &micros) {
+    if (line.starts_with("{\"time\":\"")) {
+        size_t epoch = line.find("\"epoch_us\":");
+        size_t name = line.find(",\"level\":\"");
+        if (epoch == std::string_view::npos || name == std::string_view::npos)
+            return false;
+        name += 10;
+        size_t quote = line.find('"', name);
+        return quote != std::string_view::npos && parseMicros(line.substr(epoch + 11), micros) &&
+               levelOf(line.substr(name, quote - name), level);
+    }
+    // LEVEL   | (thx-id: <thread>) - <date> (<epoch us>) - <message>
+    size_t bar = line.find(" |");
+    if (bar == std::string_view::npos || bar > 8 || !line.substr(bar).starts_with(" | (thx-id: "))
+        return false;
+    size_t date = line.find(") - ", bar);
+    size_t open = date == std::string_view::npos ? date : line.find(" (", date);
+    if (open == std::string_view::npos)
+        return false;
+    std::string_view name = line.substr(0, bar);
+    return parseMicros(line.substr(open + 2), micros) && levelOf(name.substr(0, name.find(' ')), level);
 }
 
-std::string Log::toString(Level l, bool isStdOut) {
-    std::string level;
+std::string_view Log::toString(Level l, bool isStdOut) {
+    std::string_view level;
     switch (l) {
         case log_info:
             level = (isStdOut)?"\033[32mINFO\033[0m    |":"INFO    |";
@@ -112,91 +362,3 @@ std::string Log::toString(Level l, bool isStdOut) {
     }
     return level;
 }
-
-void Log::defineLogLevels(Level level) {
-    switch (level) {
-        case log_verbose:
-            _is_level_debug = true;
-            _is_level_error = true;
-            _is_level_info = true;
-            _is_level_trace = true;
-            _is_level_warning = true;
-            _is_Level_stealth = false;
-            _is_level_silent = false;
-            break;
-        case log_stealth:
-            _is_level_debug = false;
-            _is_level_error = false;
-            _is_level_info = false;
-            _is_level_trace = false;
-            _is_level_warning = false;
-            _is_Level_stealth = true;
-            _is_level_silent = false;
-            break;
-        case log_silent:
-            _is_level_debug = false;
-            _is_level_error = false;
-            _is_level_info = false;
-            _is_level_trace = false;
-            _is_level_warning = false;
-            _is_Level_stealth = false;
-            _is_level_silent = true;
-            break;
-        case log_info:
-            _is_level_debug = false;
-            _is_level_error = false;
-            _is_level_info = true;
-            _is_level_trace = false;
-            _is_Level_stealth = false;
-            _is_level_warning = false;
-            _is_level_silent = false;
-            break;
-        case log_debug:
-            _is_level_debug = true;
-            _is_level_error = false;
-            _is_level_info = false;
-            _is_level_trace = false;
-            _is_level_warning = false;
-            _is_Level_stealth = false;
-            _is_level_silent = false;
-            break;
-        case log_trace:
-            _is_level_debug = false;
-            _is_level_error = false;
-            _is_level_info = false;
-            _is_level_trace = true;
-            _is_level_warning = false;
-            _is_Level_stealth = false;
-            _is_level_silent = false;
-            break;
-        case log_error:
-            _is_level_debug = false;
-            _is_level_error = true;
-            _is_level_info = false;
-            _is_level_trace = false;
-            _is_level_warning = false;
-            _is_Level_stealth = false;
-            _is_level_silent = false;
-            break;
-        case log_warning:
-            _is_level_debug = false;
-            _is_level_error = false;
-            _is_level_info = false;
-            _is_level_trace = false;
-            _is_level_warning = true;
-            _is_Level_stealth = false;
-            _is_level_silent = false;
-            break;
-        default:
-            _is_level_debug = false;
-            _is_level_error = false;
-            _is_level_info = false;
-            _is_level_trace = false;
-            _is_level_warning = false;
-            _is_Level_stealth = false;
-            _is_level_silent = false;
-            break;
-    }
-}
-
-
@@ -0,0 +1,85 @@
+// MIT License
+//
+// Copyright (c) 2023 Salomon Lee
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+#include <util/logging/LogBuffer.hpp>
+#include <algorithm>
+
+template<size_t InlineSize>
+BasicLogBuffer<InlineSize>::BasicLogBuffer(const BasicLogBuffer &other) : BasicLogBuffer() {
+    append(other.data(), other.size());
+}
+
+template<size_t InlineSize>
+BasicLogBuffer<InlineSize>::BasicLogBuffer(BasicLogBuffer &&other) noexcept : BasicLogBuffer() {
+    *this = std::move(other);
+}
+
+template<size_t InlineSize>
+BasicLogBuffer<InlineSize> &BasicLogBuffer<InlineSize>::operator=(const BasicLogBuffer &other) {
+    if (this != &other) {
+        clear();
+        append(other.data(), other.size());
+    }
+    return *this;
+}
+
+template<size_t InlineSize>
+BasicLogBuffer<InlineSize> &BasicLogBuffer<InlineSize>::operator=(BasicLogBuffer &&other) noexcept {
+    if (this == &other)
+        return *this;
+    if (other._data != other._inline) {
+        if (_data != _inline)
+            delete[] _data;
+        _data = other._data;
+        _capacity = other._capacity;
+        other._data = other._inline;
+        other._capacity = INLINE_SIZE;
+    } else {
+        if (_capacity < other._size)
+            grow(other._size);
+        std::memcpy(_data, other._data, other._size);
+    }
+    _size = other._size;
+    other._size = 0;
+    return *this;
+}
+
+template<size_t InlineSize>
+BasicLogBuffer<InlineSize>::~BasicLogBuffer() {
+    if (_data != _inline)
+        delete[] _data;
+}
+
+template<size_t InlineSize>
+void BasicLogBuffer<InlineSize>::grow(size_t required) {
+    size_t capacity = std::max(required, _capacity * 2);
+    char *data = new char[capacity];
+    std::memcpy(data, _data, _size);
+    if (_data != _inline)
+        delete[] _data;
+    _data = data;
+    _capacity = capacity;
+}
+
+template class BasicLogBuffer<384>;
+template class BasicLogBuffer<128>;
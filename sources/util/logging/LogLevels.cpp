@@ -0,0 +1,184 @@
+// MIT License
+//
+// Copyright (c) 2023 Salomon Lee
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+#include <util/logging/LogLevels.hpp>
+#include <util/logging/Logger.hpp>
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <utility>
+
+std::atomic<const LogLevels::Table *> LogLevels::_table{nullptr};
+std::atomic<unsigned> LogLevels::_enabled{~LogLevels::OVERRIDDEN};
+std::mutex LogLevels::_mutex;
+std::vector<std::unique_ptr<const LogLevels::Table>> LogLevels::_retired;
+
+static std::vector<std::string> split(std::string_view text, char separator) {
+    std::vector<std::string> parts;
+    while (!text.empty()) {
+        size_t end = text.find(separator);
+        if (end != 0)
+            parts.emplace_back(text.substr(0, end));
+        text.remove_prefix(end == std::string_view::npos ? text.size() : end + 1);
+    }
+    return parts;
+}
+
+LogLevels::Table::Table(Level level, std::map<std::string, Level> modules, std::string root)
+        : level(level), modules(std::move(modules)), root(std::move(root)), mask(maskOf(level)) {
+    for (const auto &module : this->modules) {
+        paths.emplace_back(split(module.first, '.'), maskOf(module.second));
+        mask |= paths.back().second;
+    }
+    // Longest first, so resolve() can stop at the first match.
+    std::stable_sort(paths.begin(), paths.end(),
+                     [](const auto &a, const auto &b) { return a.first.size() > b.first.size(); });
+    if (!paths.empty())
+        mask |= OVERRIDDEN;
+}
+
+unsigned LogLevels::Table::resolve(const char *file) const {
+    std::vector<std::string_view> components;
+    std::string_view path(file);
+    bool relative = !root.empty() && path.size() > root.size() && path.compare(0, root.size(), root) == 0 &&
+                    path[root.size()] == '/';
+    if (relative)
+        path.remove_prefix(root.size());
+    while (!path.empty()) {
+        size_t end = path.find('/');
+        if (end != 0)
+            components.push_back(path.substr(0, end));
+        path.remove_prefix(end == std::string_view::npos ? path.size() : end + 1);
+    }
+    if (!components.empty()) {
+        std::string_view &name = components.back();
+        size_t dot = name.rfind('.');
+        if (dot != std::string_view::npos && dot > 0)
+            name = name.substr(0, dot);
+    }
+    auto same = [](std::string_view component, const std::string &part) { return component == part; };
+    for (const auto &module : paths) {
+        const auto &parts = module.first;
+        if (relative) {
+            if (std::search(components.begin(), components.end(), parts.begin(), parts.end(), same) != components.end())
+                return module.second;
+            continue;
+        }
+        // Outside the root the module has to end at the file name or at the directory holding it.
+        for (size_t skip = 0; skip < 2 && parts.size() + skip <= components.size(); skip++) {
+            auto last = components.end() - static_cast<long>(skip);
+            if (std::equal(last - static_cast<long>(parts.size()), last, parts.begin(), same))
+                return module.second;
+        }
+    }
+    return maskOf(level);
+}
+
+unsigned LogLevels::maskOf(Level level) {
+    switch (level) {
+        case log_silent:
+        case log_stealth:
+            return 0;
+        case log_verbose:
+            return (1u << log_info) | (1u << log_trace) | (1u << log_error) | (1u << log_debug) |
+                   (1u << log_warning) | (1u << log_verbose);
+        default:
+            return (1u << level) | (1u << log_verbose);
+    }
+}
+
+bool LogLevels::isEnabled(Level l, const char *file) {
+    struct Resolved {
+        const char *file;
+        const Table *table;
+        unsigned mask;
+    };
+    // Direct mapped per thread, __FILE__ of a site is the same pointer on every call.
+    thread_local Resolved cache[64]{};
+    const Table *table = _table.load(std::memory_order_acquire);
+    if (table == nullptr)
+        return true;
+    Resolved &resolved = cache[(reinterpret_cast<uintptr_t>(file) >> 4) & 63];
+    if (resolved.file != file || resolved.table != table)
+        resolved = {file, table, table->resolve(file)};
+    return resolved.mask & (1u << l);
+}
+
+void LogLevels::publish(Table *table) {
+    _retired.emplace_back(table);
+    _table.store(table, std::memory_order_release);
+    _enabled.store(table->mask, std::memory_order_relaxed);
+    Logger::refreshLevels();
+}
+
+void LogLevels::configure(Level level, const std::map<std::string, Level> &modules, const std::string &root) {
+    std::lock_guard<std::mutex> lock(_mutex);
+    publish(new Table(level, modules, root));
+}
+
+void LogLevels::setLevel(Level level) {
+    std::lock_guard<std::mutex> lock(_mutex);
+    const Table *table = _table.load(std::memory_order_acquire);
+    publish(new Table(level, table != nullptr ? table->modules : std::map<std::string, Level>(),
+                      table != nullptr ? table->root : std::string()));
+}
+
+void LogLevels::setLevel(const std::string &module, Level level) {
+    std::lock_guard<std::mutex> lock(_mutex);
+    const Table *table = _table.load(std::memory_order_acquire);
+    std::map<std::string, Level> modules = table != nullptr ? table->modules : std::map<std::string, Level>();
+    modules[module] = level;
+    publish(new Table(table != nullptr ? table->level : log_verbose, std::move(modules),
+                      table != nullptr ? table->root : std::string()));
+}
+
+void LogLevels::clearLevel(const std::string &module) {
+    std::lock_guard<std::mutex> lock(_mutex);
+    const Table *table = _table.load(std::memory_order_acquire);
+    if (table == nullptr || table->modules.count(module) == 0)
+        return;
+    std::map<std::string, Level> modules = table->modules;
+    modules.erase(module);
+    publish(new Table(table->level, std::move(modules), table->root));
+}
+
+Level LogLevels::getLevel() {
+    const Table *table = _table.load(std::memory_order_acquire);
+    return table != nullptr ? table->level : log_verbose;
+}
+
+Level LogLevels::getLevel(const std::string &module) {
+    const Table *table = _table.load(std::memory_order_acquire);
+    if (table == nullptr)
+        return log_verbose;
+    std::string name = module;
+    for (;;) {
+        auto found = table->modules.find(name);
+        if (found != table->modules.end())
+            return found->second;
+        size_t dot = name.rfind('.');
+        if (dot == std::string::npos)
+            return table->level;
+        name.resize(dot);
+    }
+}
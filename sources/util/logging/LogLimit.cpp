@@ -0,0 +1,123 @@
+// MIT License
+//
+// Copyright (c) 2023 Salomon Lee
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+#include <util/logging/LogLimit.hpp>
+#include <util/logging/FlushTimer.hpp>
+#include <util/properties/LogProperties.hpp>
+#include <algorithm>
+#include <ctime>
+
+std::atomic<LogLimit *> LogLimit::_sites{nullptr};
+std::atomic<long> LogLimit::_next_report{0};
+
+LogLimit::LogLimit(const LogSite &site, Level level) : _site(site), _level(level) {
+    // Sites are function local statics, so the list only grows and is never freed.
+    LogLimit *head = _sites.load(std::memory_order_relaxed);
+    do {
+        _next = head;
+    } while (!_sites.compare_exchange_weak(head, this, std::memory_order_release, std::memory_order_relaxed));
+}
+
+int64_t LogLimit::monotonicNs(bool coarse) {
+    timespec ts{};
+#ifdef CLOCK_MONOTONIC_COARSE
+    clock_gettime(coarse ? CLOCK_MONOTONIC_COARSE : CLOCK_MONOTONIC, &ts);
+#else
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+#endif
+    return static_cast<int64_t>(ts.tv_sec) * 1000000000 + ts.tv_nsec;
+}
+
+uint64_t LogLimit::random() {
+    // xorshift64*, seeded per thread from the address of its state.
+    thread_local uint64_t state = reinterpret_cast<uintptr_t>(&state) * 0x9E3779B97F4A7C15ull | 1;
+    state ^= state >> 12;
+    state ^= state << 25;
+    state ^= state >> 27;
+    return state * 0x2545F4914F6CDD1Dull;
+}
+
+bool LogLimit::perSecond(double perSecond) {
+    if (perSecond <= 0) {
+        suppress();
+        return false;
+    }
+    // GCRA: _tat is the time at which the bucket is full again. A statement goes out while that
+    // is less than one second ahead, and pushes it one emission interval further.
+    const auto interval = std::max<int64_t>(1, static_cast<int64_t>(1e9 / perSecond));
+    const int64_t limit = std::max<int64_t>(1000000000, interval) - interval;
+    const int64_t now = monotonicNs(false);
+    int64_t tat = _tat.load(std::memory_order_relaxed);
+    for (;;) {
+        int64_t from = std::max(tat, now);
+        if (from - now > limit) {
+            suppress();
+            return false;
+        }
+        if (_tat.compare_exchange_weak(tat, from + interval, std::memory_order_relaxed))
+            return true;
+    }
+}
+
+void LogLimit::suppress() {
+    _suppressed.fetch_add(1, std::memory_order_relaxed);
+    if (isReporting()) {
+        reportIfDue();
+        return;
+    }
+    long interval = LogProperties::instance()->getLimitReportMs();
+    if (interval <= 0)
+        return;
+    // The first suppression starts the interval and the timer that reports when statements stop.
+    long due = 0;
+    long now = static_cast<long>(monotonicNs(true) / 1000000);
+    if (_next_report.compare_exchange_strong(due, now + interval, std::memory_order_relaxed))
+        FlushTimer::reschedule(LogProperties::instance());
+}
+
+void LogLimit::reportIfDue() {
+    long interval = LogProperties::instance()->getLimitReportMs();
+    long due = _next_report.load(std::memory_order_relaxed);
+    if (interval <= 0 || due == 0)
+        return;
+    // The summaries only need the interval to a few milliseconds.
+    long now = static_cast<long>(monotonicNs(true) / 1000000);
+    // A reload shortened the interval, the summaries are due one new interval from now.
+    if (due > now + interval) {
+        _next_report.compare_exchange_strong(due, now + interval, std::memory_order_relaxed);
+        return;
+    }
+    // Whoever moves the deadline forward writes the summaries.
+    if (now < due || !_next_report.compare_exchange_strong(due, now + interval, std::memory_order_relaxed))
+        return;
+    report();
+}
+
+void LogLimit::report() {
+    for (LogLimit *site = _sites.load(std::memory_order_acquire); site != nullptr; site = site->_next) {
+        uint64_t suppressed = site->_suppressed.exchange(0, std::memory_order_relaxed);
+        if (suppressed == 0 || !Log::isEnabled(site->_level, site->_site.file))
+            continue;
+        Log(&site->_site, site->_level) << "suppressed " << suppressed << " statements of this site";
+    }
+}
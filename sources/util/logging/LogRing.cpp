@@ -0,0 +1,92 @@
+// MIT License
+//
+// Copyright (c) 2023 Salomon Lee
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+#include <util/logging/LogRing.hpp>
+#include <utility>
+
+static size_t roundUpPowerOfTwo(size_t v) {
+    size_t p = 2;
+    while (p < v)
+        p <<= 1;
+    return p;
+}
+
+LogRing::LogRing(size_t capacity) {
+    size_t size = roundUpPowerOfTwo(capacity);
+    _cells.reset(new Cell[size]);
+    _mask = size - 1;
+    for (size_t i = 0; i < size; i++)
+        _cells[i].sequence.store(i, std::memory_order_relaxed);
+}
+
+bool LogRing::tryPush(LogRecord &record) {
+    size_t pos = _enqueue_pos.load(std::memory_order_relaxed);
+    for (;;) {
+        Cell &cell = _cells[pos & _mask];
+        size_t seq = cell.sequence.load(std::memory_order_acquire);
+        auto diff = static_cast<std::ptrdiff_t>(seq) - static_cast<std::ptrdiff_t>(pos);
+        if (diff == 0) {
+            if (_enqueue_pos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                cell.record = std::move(record);
+                cell.sequence.store(pos + 1, std::memory_order_release);
+                return true;
+            }
+        } else if (diff < 0) {
+            return false;
+        } else {
+            pos = _enqueue_pos.load(std::memory_order_relaxed);
+        }
+    }
+}
+
+bool LogRing::tryPop(LogRecord &record) {
+    size_t pos = _dequeue_pos.load(std::memory_order_relaxed);
+    for (;;) {
+        Cell &cell = _cells[pos & _mask];
+        size_t seq = cell.sequence.load(std::memory_order_acquire);
+        auto diff = static_cast<std::ptrdiff_t>(seq) - static_cast<std::ptrdiff_t>(pos + 1);
+        if (diff == 0) {
+            if (_dequeue_pos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                record = std::move(cell.record);
+                cell.sequence.store(pos + _mask + 1, std::memory_order_release);
+                return true;
+            }
+        } else if (diff < 0) {
+            return false;
+        } else {
+            pos = _dequeue_pos.load(std::memory_order_relaxed);
+        }
+    }
+}
+
+size_t LogRing::capacity() const {
+    return _mask + 1;
+}
+
+size_t LogRing::enqueued() const {
+    return _enqueue_pos.load(std::memory_order_acquire);
+}
+
+bool LogRing::empty() const {
+    return _dequeue_pos.load(std::memory_order_acquire) >= _enqueue_pos.load(std::memory_order_acquire);
+}
@@ -0,0 +1,70 @@
+// MIT License
+//
+// Copyright (c) 2023 Salomon Lee
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+
+#include <util/logging/LogSite.hpp>
+
+std::string_view LogSite::basename(std::string_view file) {
+    size_t slash = file.rfind('/');
+    return slash == std::string_view::npos ? file : file.substr(slash + 1);
+}
+
+std::string_view LogSite::shortFunction(std::string_view function) {
+    std::string_view name = function.substr(0, function.find(" [with "));
+    // The parameter list is the last parenthesis, anything after it may only be cv, ref or noexcept.
+    size_t close = name.rfind(')');
+    if (close == std::string_view::npos)
+        return function;
+    for (char c : name.substr(close + 1))
+        if (c != ' ' && c != '&' && (c < 'a' || c > 'z'))
+            return function;
+    size_t open = close;
+    for (int depth = 0; open-- > 0;) {
+        if (name[open] == ')')
+            depth++;
+        else if (name[open] == '(' && depth-- == 0)
+            break;
+    }
+    if (open == std::string_view::npos)
+        return function;
+    name = name.substr(0, open);
+    // Operator names hold characters of their own, the return type ends before the keyword.
+    size_t end = name.size();
+    size_t op = name.rfind("operator");
+    if (op != std::string_view::npos && (op == 0 || name[op - 1] == ':' || name[op - 1] == ' '))
+        end = op;
+    size_t start = end;
+    for (int depth = 0; start > 0; start--) {
+        char c = name[start - 1];
+        if (c == '>' || c == ')')
+            depth++;
+        else if (c == '<' || c == '(')
+            depth--;
+        else if (c == ' ' && depth == 0)
+            break;
+    }
+    // A pointer or reference return type is written against the name.
+    while (start < end && (name[start] == '*' || name[start] == '&'))
+        start++;
+    return name.substr(start);
+}
@@ -0,0 +1,103 @@
+// MIT License
+//
+// Copyright (c) 2023 Salomon Lee
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+#include <util/logging/Logger.hpp>
+#include <util/logging/LogLevels.hpp>
+#include <util/logging/SinkRegistry.hpp>
+#include <util/properties/LogProperties.hpp>
+#include <utility>
+
+std::mutex Logger::_mutex;
+std::vector<std::unique_ptr<Logger>> Logger::_loggers;
+std::unordered_map<std::string, Logger *> Logger::_by_name;
+
+Logger::Logger(std::string name, size_t id) : _name(std::move(name)), _id(id),
+                                              _levels(LogLevels::maskOf(LogLevels::getLevel(_name))) {
+}
+
+Logger *Logger::get(const std::string &name) {
+    const LogProperties *properties = LogProperties::instance();
+    Logger *logger;
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        auto found = _by_name.find(name);
+        if (found != _by_name.end())
+            return found->second;
+        if (_loggers.empty() && !name.empty()) {
+            _loggers.emplace_back(new Logger(std::string(), 0));
+            _by_name.emplace(std::string(), _loggers.back().get());
+        }
+        _loggers.emplace_back(new Logger(name, _loggers.size()));
+        logger = _loggers.back().get();
+        _by_name.emplace(name, logger);
+    }
+    // Records of a logger the sink snapshot does not know yet go to the root sinks.
+    if (!properties->getLoggerSinks().empty())
+        SinkRegistry::instance()->reroute();
+    return logger;
+}
+
+std::vector<std::string> Logger::names() {
+    std::lock_guard<std::mutex> lock(_mutex);
+    std::vector<std::string> names;
+    for (const auto &logger : _loggers)
+        names.push_back(logger->_name);
+    return names;
+}
+
+void Logger::refreshLevels() {
+    std::lock_guard<std::mutex> lock(_mutex);
+    for (const auto &logger : _loggers)
+        logger->_levels.store(LogLevels::maskOf(LogLevels::getLevel(logger->_name)), std::memory_order_relaxed);
+}
+
+// Each call loads the configuration first, so its first publication cannot undo the change.
+
+void Logger::setLevel(Level level) {
+    LogProperties::instance();
+    LogLevels::setLevel(level);
+}
+
+void Logger::setLevel(const std::string &name, Level level) {
+    LogProperties::instance();
+    LogLevels::setLevel(name, level);
+}
+
+void Logger::clearLevel(const std::string &name) {
+    LogProperties::instance();
+    LogLevels::clearLevel(name);
+}
+
+Level Logger::getLevel() {
+    LogProperties::instance();
+    return LogLevels::getLevel();
+}
+
+Level Logger::getLevel(const std::string &name) {
+    LogProperties::instance();
+    return LogLevels::getLevel(name);
+}
+
+void Logger::setThreadName(const std::string &name) {
+    Log::setThreadName(name);
+}
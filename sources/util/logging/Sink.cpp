@@ -0,0 +1,59 @@
+// MIT License
+//
+// Copyright (c) 2023 Salomon Lee
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+#include <util/logging/Sink.hpp>
+#include <utility>
+
+Sink::Sink(std::string name, SinkFormat format, Level minLevel) : _name(std::move(name)), _format(format),
+                                                                   _min_level(minLevel) {
+}
+
+const std::string &Sink::getName() const {
+    return _name;
+}
+
+SinkFormat Sink::getFormat() const {
+    return _format;
+}
+
+Level Sink::getMinLevel() const {
+    return _min_level.load(std::memory_order_relaxed);
+}
+
+void Sink::setMinLevel(Level minLevel) {
+    _min_level.store(minLevel, std::memory_order_relaxed);
+}
+
+int Sink::severityOf(Level level) {
+    return ::severityOf(level);
+}
+
+bool Sink::accepts(Level level) const {
+    Level minLevel = getMinLevel();
+    if (minLevel == log_verbose)
+        return true;
+    return severityOf(level) >= severityOf(minLevel);
+}
+
+void Sink::format(const LogRecord &, std::string &) {
+}
@@ -0,0 +1,293 @@
+// MIT License
+//
+// Copyright (c) 2023 Salomon Lee
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+#include <util/logging/SinkRegistry.hpp>
+#include <util/logging/BinarySink.hpp>
+#include <util/logging/BufferedFileSink.hpp>
+#include <util/logging/ConsoleSink.hpp>
+#include <util/logging/CrashHandler.hpp>
+#include <util/logging/DedupSink.hpp>
+#include <util/logging/FileSink.hpp>
+#include <util/logging/Log.hpp>
+#include <util/logging/LogLimit.hpp>
+#include <util/logging/Logger.hpp>
+#include <util/logging/MappedFileSink.hpp>
+#include <util/logging/NullSink.hpp>
+#include <util/properties/LogProperties.hpp>
+#include <algorithm>
+#include <iostream>
+#include <map>
+
+SinkRegistry *SinkRegistry::instance() {
+    // Never destroyed: the async and binary writers still write through it during static destruction.
+    static auto *registry = new SinkRegistry();
+    return registry;
+}
+
+const SinkRegistry::Snapshot *SinkRegistry::current() {
+    const LogProperties *properties = LogProperties::instance();
+    const Snapshot *snapshot = _current.load(std::memory_order_acquire);
+    if (snapshot != nullptr && snapshot->properties == properties)
+        return snapshot;
+    std::lock_guard<std::mutex> lock(_mutex);
+    snapshot = _current.load(std::memory_order_acquire);
+    if (snapshot != nullptr && snapshot->properties == properties)
+        return snapshot;
+    return rebuild(properties);
+}
+
+const SinkRegistry::Snapshot *SinkRegistry::published() const {
+    return _current.load(std::memory_order_acquire);
+}
+
+const SinkRegistry::Snapshot *SinkRegistry::rebuild(const LogProperties *properties) {
+    if (properties->isCrashHandler())
+        CrashHandler::install(properties->isCrashBacktrace());
+    else
+        CrashHandler::uninstall();
+    const Snapshot *previous = _current.load(std::memory_order_acquire);
+    auto *snapshot = new Snapshot{properties, {}, {}};
+    for (const std::string &name : properties->getSinks()) {
+        std::shared_ptr<Sink> sink = configured(properties, name, previous);
+        if (sink != nullptr)
+            snapshot->sinks.push_back(std::move(sink));
+    }
+    snapshot->sinks.insert(snapshot->sinks.end(), _added.begin(), _added.end());
+    route(snapshot, previous);
+    _retired.emplace_back(snapshot);
+    _current.store(snapshot, std::memory_order_release);
+    // Repeat counts of the dedup stages left behind would be lost with them.
+    if (previous != nullptr)
+        for (const std::shared_ptr<Sink> &sink : previous->sinks)
+            if (dynamic_cast<DedupSink *>(sink.get()) != nullptr &&
+                std::find(snapshot->sinks.begin(), snapshot->sinks.end(), sink) == snapshot->sinks.end())
+                sink->flush();
+    return snapshot;
+}
+
+static std::shared_ptr<Sink> fileSink(const LogProperties *properties, const std::string &name, SinkFormat format,
+                                     Level minLevel) {
+    const std::string &file = format == format_json ? properties->getJsonFile() : properties->getLogFile();
+    if (properties->isMmap())
+        return std::make_shared<MappedFileSink>(name, format, properties->getMappedLog(file), minLevel);
+    LogAppender *appender = format == format_json ? properties->getJsonAppender() : properties->getLogAppender();
+    if (properties->isBuffered())
+        return std::make_shared<BufferedFileSink>(name, format, appender, minLevel);
+    return std::make_shared<FileSink>(name, format, appender, minLevel);
+}
+
+static std::shared_ptr<Sink> dedup(const LogProperties *properties, std::shared_ptr<Sink> sink,
+                                   const SinkRegistry::Snapshot *previous) {
+    if (!properties->isDedup())
+        return sink;
+    // The same properties make the same stage, keeping it keeps its open runs over add, remove and
+    // the rebuilds for new loggers.
+    if (previous != nullptr && previous->properties == properties)
+        for (const std::shared_ptr<Sink> &kept : previous->sinks)
+            if (dynamic_cast<DedupSink *>(kept.get()) != nullptr && kept->getName() == sink->getName())
+                return kept;
+    return std::make_shared<DedupSink>(std::move(sink), properties->getDedupTimeoutMs());
+}
+
+std::shared_ptr<Sink> SinkRegistry::configured(const LogProperties *properties, const std::string &name,
+                                               const Snapshot *previous) {
+    Level minLevel = properties->getSinkLevel(name);
+    if (name == "console")
+        return dedup(properties, std::make_shared<ConsoleSink>(minLevel), previous);
+    if (name == "file")
+        return dedup(properties, fileSink(properties, name, format_text, minLevel), previous);
+    if (name == "json")
+        return dedup(properties, fileSink(properties, name, format_json, minLevel), previous);
+    if (name == "binary")
+        return std::make_shared<BinarySink>(minLevel);
+    if (name == "null")
+        return std::make_shared<NullSink>(minLevel);
+    std::cerr << "Unknown sink '" << name << "' in sinks property, ignored" << std::endl;
+    return nullptr;
+}
+
+void SinkRegistry::route(Snapshot *snapshot, const Snapshot *previous) {
+    std::vector<size_t> root(snapshot->sinks.size());
+    for (size_t i = 0; i < root.size(); i++)
+        root[i] = i;
+    const auto &loggerSinks = snapshot->properties->getLoggerSinks();
+    // Sinks of a sinks.<logger> entry, by name among the root sinks first, created otherwise.
+    std::map<std::string, std::vector<size_t>> named;
+    for (const auto &entry : loggerSinks) {
+        std::vector<size_t> &indexes = named[entry.first];
+        for (const std::string &name : entry.second) {
+            size_t i = 0;
+            while (i < snapshot->sinks.size() && snapshot->sinks[i]->getName() != name)
+                i++;
+            if (i == snapshot->sinks.size()) {
+                std::shared_ptr<Sink> sink = configured(snapshot->properties, name, previous);
+                if (sink == nullptr)
+                    continue;
+                snapshot->sinks.push_back(std::move(sink));
+            }
+            indexes.push_back(i);
+        }
+    }
+    std::vector<std::string> loggers = Logger::names();
+    snapshot->routes.assign(std::max<size_t>(loggers.size(), 1), root);
+    for (size_t id = 0; id < loggers.size(); id++) {
+        std::string name = loggers[id];
+        for (;;) {
+            auto found = named.find(name);
+            if (found != named.end()) {
+                snapshot->routes[id] = found->second;
+                break;
+            }
+            size_t dot = name.rfind('.');
+            if (dot == std::string::npos)
+                break;
+            name.resize(dot);
+        }
+    }
+}
+
+const std::vector<size_t> &SinkRegistry::Snapshot::routeOf(const LogRecord &record) const {
+    size_t id = record.logger != nullptr ? record.logger->getId() : 0;
+    return routes[id < routes.size() ? id : 0];
+}
+
+void SinkRegistry::add(const std::shared_ptr<Sink> &sink) {
+    const LogProperties *properties = LogProperties::instance();
+    std::lock_guard<std::mutex> lock(_mutex);
+    _added.push_back(sink);
+    rebuild(properties);
+}
+
+void SinkRegistry::reroute() {
+    const LogProperties *properties = LogProperties::instance();
+    std::lock_guard<std::mutex> lock(_mutex);
+    rebuild(properties);
+}
+
+void SinkRegistry::remove(const std::string &name) {
+    const LogProperties *properties = LogProperties::instance();
+    std::lock_guard<std::mutex> lock(_mutex);
+    _added.erase(std::remove_if(_added.begin(), _added.end(),
+                                [&name](const std::shared_ptr<Sink> &sink) { return sink->getName() == name; }),
+                 _added.end());
+    rebuild(properties);
+}
+
+std::shared_ptr<Sink> SinkRegistry::find(const std::string &name) {
+    for (const std::shared_ptr<Sink> &sink : current()->sinks)
+        if (sink->getName() == name)
+            return sink;
+    return nullptr;
+}
+
+void SinkRegistry::write(const LogRecord &record) {
+    thread_local Batch batch;
+    batch.add(record);
+    batch.commit();
+}
+
+void SinkRegistry::flush() {
+    if (current()->properties->getLimitReportMs() > 0)
+        LogLimit::report();
+    for (const std::shared_ptr<Sink> &sink : current()->sinks)
+        sink->flush();
+}
+
+void SinkRegistry::flushIfDue() {
+    for (const std::shared_ptr<Sink> &sink : current()->sinks)
+        sink->flushIfDue();
+}
+
+void SinkRegistry::render(SinkFormat format, const LogRecord &record, std::string &out) {
+    switch (format) {
+        case format_console:
+            Log::renderConsole(record, out);
+            break;
+        case format_text:
+            Log::renderFile(record, out);
+            break;
+        case format_json:
+            Log::renderJson(record, out);
+            break;
+        case format_binary:
+            BinarySink::render(record, out);
+            break;
+        default:
+            break;
+    }
+}
+
+void SinkRegistry::Batch::reset(const Snapshot *snapshot) {
+    _snapshot = snapshot;
+    _pending.assign(snapshot->sinks.size(), std::string());
+    _levels.assign(snapshot->sinks.size(), log_verbose);
+}
+
+void SinkRegistry::Batch::add(const LogRecord &record) {
+    const Snapshot *snapshot = SinkRegistry::instance()->current();
+    if (snapshot != _snapshot) {
+        commit();
+        reset(snapshot);
+    }
+    for (std::string &rendered : _rendered)
+        rendered.clear();
+    const auto &sinks = snapshot->sinks;
+    for (size_t i : snapshot->routeOf(record)) {
+        Sink &sink = *sinks[i];
+        if (!sink.accepts(record.level))
+            continue;
+        SinkFormat format = sink.getFormat();
+        if (format == format_custom) {
+            sink.format(record, _pending[i]);
+        } else if (format != format_none) {
+            std::string &rendered = _rendered[format];
+            if (rendered.empty())
+                render(format, record, rendered);
+            _pending[i] += rendered;
+        }
+        if (record.level == log_error)
+            _levels[i] = log_error;
+    }
+}
+
+void SinkRegistry::Batch::commit() {
+    if (_snapshot == nullptr)
+        return;
+    const auto &sinks = _snapshot->sinks;
+    for (size_t i = 0; i < sinks.size(); i++) {
+        if (_pending[i].empty())
+            continue;
+        sinks[i]->write(_pending[i], _levels[i]);
+        _pending[i].clear();
+        _levels[i] = log_verbose;
+    }
+}
+
+void SinkRegistry::Batch::crashCommit() {
+    if (_snapshot == nullptr)
+        return;
+    const auto &sinks = _snapshot->sinks;
+    for (size_t i = 0; i < sinks.size(); i++)
+        if (!_pending[i].empty())
+            sinks[i]->crashWrite(_pending[i]);
+}
@@ -22,19 +22,31 @@
 //
 
 #include <util/properties/LogProperties.hpp>
+#include <util/fio/PropertiesWatcher.hpp>
+#include <util/logging/FlushTimer.hpp>
 #include <util/LogUtil.hpp>
+#include <util/Date.hpp>
+#include <util/logging/Log.hpp>
+#include <algorithm>
+#include <sstream>
 #include <utility>
 
+std::atomic<const LogProperties *> LogProperties::_instance{nullptr};
+std::mutex LogProperties::_reload_mutex;
+std::vector<std::unique_ptr<const LogProperties>> LogProperties::_retired;
+
 LogProperties::LogProperties() {
     setProperties();
 }
 
 LogProperties::LogProperties(const std::string& propertyFile) {
     PropertiesReader config = PropertiesReader::instance(propertyFile);
-    if (config.getProperties().empty())
+    if (config.getProperties().empty()) {
         setProperties();
-    else
+    } else {
         setProperties(config);
+        _property_file = propertyFile;
+    }
 //    initLogAppender();
 }
 
@@ -61,6 +73,71 @@ void LogProperties::setProperties(const PropertiesReader& config) {
             setMaxSz(p.second);
         else if (p.first == "roqty")
             setRolloverLimit(p.second);
+        else if (p.first == "async")
+            setAsync(p.second);
+        else if (p.first == "buffered")
+            setBuffered(p.second);
+        else if (p.first == "async.capacity")
+            setAsyncCapacity(p.second);
+        else if (p.first == "async.overflow")
+            setOverflow(p.second);
+        else if (p.first == "flush")
+            setFlush(p.second);
+        else if (p.first == "flush.bytes")
+            setFlushBytes(p.second);
+        else if (p.first == "flush.ms")
+            setFlushMs(p.second);
+        else if (p.first == "compression")
+            setCompression(p.second);
+        else if (p.first == "compression.level")
+            setCompressionLevel(p.second);
+        else if (p.first == "compression.workers")
+            setCompressionWorkers(p.second);
+        else if (p.first == "clock")
+            setClock(p.second);
+        else if (p.first == "location.file")
+            setLocationFile(p.second);
+        else if (p.first == "location.function")
+            setLocationFunction(p.second);
+        else if (p.first == "io")
+            setIo(p.second);
+        else if (p.first == "io.buffers")
+            setIoBuffers(p.second);
+        else if (p.first == "io.buffer.size")
+            setIoBufferSize(p.second);
+        else if (p.first == "io.fsync.ms")
+            setIoFsyncMs(p.second);
+        else if (p.first == "mmap")
+            setMmap(p.second);
+        else if (p.first == "mmap.msync.ms")
+            setMsyncMs(p.second);
+        else if (p.first == "crash.handler")
+            setCrashHandler(p.second);
+        else if (p.first == "crash.backtrace")
+            setCrashBacktrace(p.second);
+        else if (p.first == "limit.report.ms")
+            setLimitReportMs(p.second);
+        else if (p.first == "dedup")
+            setDedup(p.second);
+        else if (p.first == "dedup.timeout.ms")
+            setDedupTimeoutMs(p.second);
+        else if (p.first == "watch")
+            setWatch(p.second);
+        else if (p.first == "source.root")
+            setSourceRoot(p.second);
+        else if (p.first == "binary.file")
+            setBinaryFile(p.second);
+        else if (p.first == "json.file")
+            setJsonFile(p.second);
+        else if (p.first == "sinks")
+            setSinks(p.second);
+        else if (p.first.rfind("sinks.", 0) == 0 && p.first.size() > 6)
+            setLoggerSinks(p.first.substr(6), p.second);
+        else if (p.first.rfind("sink.", 0) == 0 && p.first.size() > 11 &&
+                 p.first.compare(p.first.size() - 6, 6, ".level") == 0)
+            setSinkLevel(p.first.substr(5, p.first.size() - 11), p.second);
+        else if (p.first.rfind("level.", 0) == 0 && p.first.size() > 6)
+            setModuleLevel(p.first.substr(6), p.second);
     }
 }
 
@@ -70,13 +147,21 @@ void LogProperties::setProperties() {
     setLogFile("logpp-no-version.log");
     setMaxSz("2MB");
     setRolloverLimit("20");
+    setAsync("false");
+    setBuffered("false");
+    setAsyncCapacity("8192");
+    setOverflow("block");
+    setFlush("line");
+    setFlushBytes("64KB");
+    setFlushMs("1000");
+    setCompression("gzip");
+    setCompressionLevel("default");
+    setCompressionWorkers("2");
+    setClock("realtime");
+    setLocationFile("full");
+    setLocationFunction("full");
 }
 
-//void LogProperties::initLogAppender() {
-//    _log_appender = new LogAppender(Util:: buildFileFullPath(this->getLogPath(), this->getLogFile()),
-//                                    this->getMaxSzBytes(), this->getRolloverLimit());
-//}
-
 Level LogProperties::toLogLevel(std::string level) {
     if (level.compare("INFO") == 0 || level.compare("info") == 0)
         return log_info;
@@ -100,6 +185,10 @@ Level LogProperties::getLogLevel() const {
     return _log_level;
 }
 
+unsigned LogProperties::getEnabledLevels() const {
+    return LogLevels::maskOf(_log_level);
+}
+
 void LogProperties::setLogLevel(const std::string &logLevel) {
     this->_log_level = toLogLevel(logLevel);
 }
@@ -136,18 +225,368 @@ void LogProperties::setRolloverLimit(const std::string &mRolloverFileQty) {
     _rollover_limit = atoi(mRolloverFileQty.c_str());
 }
 
-//LogAppender *LogProperties::getLogAppender() const {
-//    return _log_appender;
-//}
+bool LogProperties::isAsync() const {
+    return _async;
+}
+
+void LogProperties::setAsync(const std::string &async) {
+    std::string value = LogUtil::trim(async);
+    _async = value == "true" || value == "TRUE" || value == "on" || value == "1";
+}
+
+bool LogProperties::isBuffered() const {
+    return _buffered;
+}
+
+void LogProperties::setBuffered(const std::string &buffered) {
+    std::string value = LogUtil::trim(buffered);
+    _buffered = value == "true" || value == "TRUE" || value == "on" || value == "1";
+}
+
+long LogProperties::getAsyncCapacity() const {
+    return _async_capacity;
+}
+
+void LogProperties::setAsyncCapacity(const std::string &asyncCapacity) {
+    long capacity = atol(asyncCapacity.c_str());
+    _async_capacity = capacity > 0 ? capacity : 8192;
+}
+
+Overflow LogProperties::getOverflow() const {
+    return _overflow;
+}
+
+void LogProperties::setOverflow(const std::string &overflow) {
+    std::string value = LogUtil::trim(overflow);
+    if (value == "drop-newest")
+        _overflow = overflow_drop_newest;
+    else if (value == "drop-oldest")
+        _overflow = overflow_drop_oldest;
+    else
+        _overflow = overflow_block;
+}
+
+Flush LogProperties::getFlush() const {
+    return _flush;
+}
+
+void LogProperties::setFlush(const std::string &flush) {
+    std::string value = LogUtil::trim(flush);
+    if (value == "bytes")
+        _flush = flush_bytes;
+    else if (value == "ms")
+        _flush = flush_ms;
+    else if (value == "error")
+        _flush = flush_error;
+    else
+        _flush = flush_line;
+}
+
+long LogProperties::getFlushBytes() const {
+    return _flush_bytes;
+}
+
+void LogProperties::setFlushBytes(const std::string &flushBytes) {
+    _flush_bytes = toBytes(LogUtil::trim(flushBytes), 64 * KB);
+}
+
+long LogProperties::getFlushMs() const {
+    return _flush_ms;
+}
+
+void LogProperties::setFlushMs(const std::string &flushMs) {
+    long ms = atol(flushMs.c_str());
+    _flush_ms = ms > 0 ? ms : 1000;
+}
+
+Codec LogProperties::getCompression() const {
+    return _compression;
+}
+
+void LogProperties::setCompression(const std::string &compression) {
+    std::string value = LogUtil::trim(compression);
+    if (value == "none")
+        _compression = codec_none;
+    else if (value == "zstd")
+        _compression = codec_zstd;
+    else if (value == "lz4")
+        _compression = codec_lz4;
+    else
+        _compression = codec_gzip;
+}
+
+int LogProperties::getCompressionLevel() const {
+    return _compression_level;
+}
+
+void LogProperties::setCompressionLevel(const std::string &compressionLevel) {
+    std::string value = LogUtil::trim(compressionLevel);
+    _compression_level = (value.empty() || value == "default") ? -1 : atoi(value.c_str());
+}
+
+int LogProperties::getCompressionWorkers() const {
+    return _compression_workers;
+}
+
+void LogProperties::setCompressionWorkers(const std::string &compressionWorkers) {
+    int workers = atoi(compressionWorkers.c_str());
+    _compression_workers = workers > 0 ? workers : 2;
+}
+
+bool LogProperties::isCoarseClock() const {
+    return _coarse_clock;
+}
+
+void LogProperties::setClock(const std::string &clock) {
+    _coarse_clock = LogUtil::trim(clock) == "coarse";
+}
+
+bool LogProperties::isLocationBasename() const {
+    return _location_basename;
+}
+
+void LogProperties::setLocationFile(const std::string &locationFile) {
+    _location_basename = LogUtil::trim(locationFile) == "basename";
+}
+
+bool LogProperties::isLocationShortFunction() const {
+    return _location_short_function;
+}
+
+void LogProperties::setLocationFunction(const std::string &locationFunction) {
+    _location_short_function = LogUtil::trim(locationFunction) == "short";
+}
+
+bool LogProperties::isIoUring() const {
+    return _io_uring;
+}
+
+void LogProperties::setIo(const std::string &io) {
+    _io_uring = LogUtil::trim(io) == "uring";
+}
+
+int LogProperties::getIoBuffers() const {
+    return _io_buffers;
+}
+
+void LogProperties::setIoBuffers(const std::string &ioBuffers) {
+    int buffers = atoi(ioBuffers.c_str());
+    _io_buffers = buffers > 0 ? std::min(buffers, 1024) : 8;
+}
+
+long LogProperties::getIoBufferSize() const {
+    return _io_buffer_size;
+}
+
+void LogProperties::setIoBufferSize(const std::string &ioBufferSize) {
+    long size = toBytes(LogUtil::trim(ioBufferSize), 256 * KB);
+    _io_buffer_size = size > 0 ? size : 256 * KB;
+}
+
+long LogProperties::getIoFsyncMs() const {
+    return _io_fsync_ms;
+}
+
+void LogProperties::setIoFsyncMs(const std::string &ioFsyncMs) {
+    long ms = atol(ioFsyncMs.c_str());
+    _io_fsync_ms = ms > 0 ? ms : 0;
+}
+
+bool LogProperties::isMmap() const {
+    return _mmap;
+}
+
+void LogProperties::setMmap(const std::string &mmap) {
+    std::string value = LogUtil::trim(mmap);
+    _mmap = value == "true" || value == "TRUE" || value == "on" || value == "1";
+}
+
+long LogProperties::getMsyncMs() const {
+    return _msync_ms;
+}
+
+void LogProperties::setMsyncMs(const std::string &msyncMs) {
+    long ms = atol(msyncMs.c_str());
+    _msync_ms = ms > 0 ? ms : 0;
+}
+
+bool LogProperties::isCrashHandler() const {
+    return _crash_handler;
+}
+
+void LogProperties::setCrashHandler(const std::string &crashHandler) {
+    std::string value = LogUtil::trim(crashHandler);
+    _crash_handler = value == "true" || value == "TRUE" || value == "on" || value == "1";
+}
+
+bool LogProperties::isCrashBacktrace() const {
+    return _crash_backtrace;
+}
+
+void LogProperties::setCrashBacktrace(const std::string &crashBacktrace) {
+    std::string value = LogUtil::trim(crashBacktrace);
+    _crash_backtrace = value == "true" || value == "TRUE" || value == "on" || value == "1";
+}
+
+long LogProperties::getLimitReportMs() const {
+    return _limit_report_ms;
+}
+
+void LogProperties::setLimitReportMs(const std::string &limitReportMs) {
+    long ms = atol(limitReportMs.c_str());
+    _limit_report_ms = ms > 0 ? ms : 0;
+}
+
+bool LogProperties::isDedup() const {
+    return _dedup;
+}
+
+void LogProperties::setDedup(const std::string &dedup) {
+    std::string value = LogUtil::trim(dedup);
+    _dedup = value == "true" || value == "TRUE" || value == "on" || value == "1";
+}
+
+long LogProperties::getDedupTimeoutMs() const {
+    return _dedup_timeout_ms;
+}
+
+void LogProperties::setDedupTimeoutMs(const std::string &dedupTimeoutMs) {
+    long ms = atol(dedupTimeoutMs.c_str());
+    _dedup_timeout_ms = ms > 0 ? ms : 5000;
+}
+
+std::string LogProperties::getBinaryFile() const {
+    if (!_binary_file.empty())
+        return _binary_file;
+    return LogUtil::getNameOfFile(_log_file) + ".bin";
+}
+
+void LogProperties::setBinaryFile(const std::string &binaryFile) {
+    _binary_file = LogUtil::trim(binaryFile);
+}
+
+std::string LogProperties::getJsonFile() const {
+    if (!_json_file.empty())
+        return _json_file;
+    return LogUtil::getNameOfFile(_log_file) + ".json";
+}
+
+void LogProperties::setJsonFile(const std::string &jsonFile) {
+    _json_file = LogUtil::trim(jsonFile);
+}
+
+const std::vector<std::string> &LogProperties::getSinks() const {
+    return _sinks;
+}
+
+static std::vector<std::string> sinkNames(const std::string &sinks) {
+    std::vector<std::string> result;
+    std::stringstream names(sinks);
+    std::string name;
+    while (std::getline(names, name, ',')) {
+        name = LogUtil::trim(name);
+        if (!name.empty())
+            result.push_back(name);
+    }
+    return result;
+}
+
+void LogProperties::setSinks(const std::string &sinks) {
+    _sinks = sinkNames(sinks);
+}
+
+const std::map<std::string, std::vector<std::string>> &LogProperties::getLoggerSinks() const {
+    return _logger_sinks;
+}
+
+void LogProperties::setLoggerSinks(const std::string &logger, const std::string &sinks) {
+    _logger_sinks[LogUtil::trim(logger)] = sinkNames(sinks);
+}
+
+Level LogProperties::getSinkLevel(const std::string &sink) const {
+    auto level = _sink_levels.find(sink);
+    return level != _sink_levels.end() ? level->second : log_verbose;
+}
+
+void LogProperties::setSinkLevel(const std::string &sink, const std::string &level) {
+    _sink_levels[sink] = toLogLevel(LogUtil::trim(level));
+}
+
+const std::map<std::string, Level> &LogProperties::getModuleLevels() const {
+    return _module_levels;
+}
+
+void LogProperties::setModuleLevel(const std::string &module, const std::string &level) {
+    _module_levels[LogUtil::trim(module)] = toLogLevel(LogUtil::trim(level));
+}
+
+const std::string &LogProperties::getSourceRoot() const {
+    return _source_root;
+}
+
+void LogProperties::setSourceRoot(const std::string &sourceRoot) {
+    _source_root = LogUtil::trim(sourceRoot);
+    while (_source_root.size() > 1 && _source_root.back() == '/')
+        _source_root.pop_back();
+}
+
+const std::string &LogProperties::getPropertyFile() const {
+    return _property_file;
+}
+
+bool LogProperties::isWatch() const {
+    return _watch;
+}
+
+void LogProperties::setWatch(const std::string &watch) {
+    std::string value = LogUtil::trim(watch);
+    _watch = value == "true" || value == "TRUE" || value == "on" || value == "1";
+}
+
+LogAppender *LogProperties::appenderFor(const std::string &file, Flush flush, std::atomic<LogAppender *> &cache) const {
+    LogAppender *appender = cache.load(std::memory_order_acquire);
+    if (appender == nullptr) {
+        appender = LogAppender::instance(LogUtil::buildFileFullPath(_log_path, file));
+        appender->configure(getMaxSzBytes(), _rollover_limit, _log_path, flush, _flush_bytes, _flush_ms, _compression,
+                            _compression_level);
+        appender->configureIo(_io_uring, _io_buffers, _io_buffer_size, _io_fsync_ms);
+        cache.store(appender, std::memory_order_release);
+    }
+    return appender;
+}
+
+LogAppender *LogProperties::getLogAppender() const {
+    return appenderFor(_log_file, _flush, _log_appender);
+}
+
+LogAppender *LogProperties::getBinaryAppender() const {
+    return appenderFor(getBinaryFile(), flush_bytes, _binary_appender);
+}
+
+LogAppender *LogProperties::getJsonAppender() const {
+    return appenderFor(getJsonFile(), _flush, _json_appender);
+}
+
+MappedLog *LogProperties::getMappedLog(const std::string &file) const {
+    MappedLog *log = MappedLog::instance(LogUtil::buildFileFullPath(_log_path, file), getMaxSzBytes());
+    log->configure(getMaxSzBytes(), _rollover_limit, _compression, _compression_level, _msync_ms);
+    return log;
+}
 
 LogProperties::~LogProperties() {
 //    delete _log_appender;
 }
 
-long LogProperties::getMaxSzBytes() {
-    if (_max_sz.length() < 2) return 2 * MB;
-    char prefix = _max_sz.c_str()[_max_sz.length() - 2];
-    std::string str_sz = _max_sz.substr(0, _max_sz.length() - 2);
+long LogProperties::getMaxSzBytes() const {
+    return toBytes(_max_sz, 2 * MB);
+}
+
+long LogProperties::toBytes(const std::string &size, long fallback) {
+    if (size.empty()) return fallback;
+    if (isdigit(static_cast<unsigned char>(size.back()))) return atol(size.c_str());
+    if (size.length() < 2) return fallback;
+    char prefix = size.c_str()[size.length() - 2];
+    std::string str_sz = size.substr(0, size.length() - 2);
     long sz = atol(str_sz.c_str());
     switch (prefix) {
         case 'K':
@@ -161,3 +600,33 @@ long LogProperties::getMaxSzBytes() {
     }
 }
 
+
+const LogProperties *LogProperties::instance() {
+    const LogProperties *properties = _instance.load(std::memory_order_acquire);
+    if (properties != nullptr)
+        return properties;
+    std::lock_guard<std::mutex> lock(_reload_mutex);
+    properties = _instance.load(std::memory_order_acquire);
+    if (properties == nullptr)
+        properties = publish(new LogProperties(LOG_PROPERTIES_FILE));
+    return properties;
+}
+
+const LogProperties *LogProperties::reload(const std::string &propertyFile) {
+    auto *properties = new LogProperties(propertyFile);
+    std::lock_guard<std::mutex> lock(_reload_mutex);
+    return publish(properties);
+}
+
+const LogProperties *LogProperties::publish(const LogProperties *properties) {
+    _retired.emplace_back(properties);
+    _instance.store(properties, std::memory_order_release);
+    LogLevels::configure(properties->getLogLevel(), properties->getModuleLevels(), properties->getSourceRoot());
+    Date::useCoarseClock(properties->isCoarseClock());
+    Log::useLocation(properties->isLocationBasename(), properties->isLocationShortFunction());
+    FlushTimer::reschedule(properties);
+    PropertiesWatcher *watcher = PropertiesWatcher::instance();
+    if (watcher != nullptr)
+        watcher->watch(properties->isWatch() ? properties->getPropertyFile() : std::string());
+    return properties;
+}
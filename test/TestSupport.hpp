@@ -0,0 +1,114 @@
+// MIT License
+//
+// Copyright (c) 2023 Salomon Lee
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+#ifndef LOGPP_TEST_SUPPORT_HPP
+#define LOGPP_TEST_SUPPORT_HPP
+
+#include <util/logging/Sink.hpp>
+#include <atomic>
+#include <iostream>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <vector>
+
+/**
+ * Checks failed so far, printed and turned into the exit code at the end of each test.
+ */
+inline int failures = 0;
+
+inline void expect(bool condition, const std::string &what) {
+    if (!condition) {
+        std::cerr << "FAILED: " << what << std::endl;
+        failures++;
+    }
+}
+
+/**
+ * Keeps every rendering it is handed, whole and split into lines.
+ */
+class CaptureSink : public Sink {
+private:
+    std::mutex _mutex;
+
+public:
+    std::vector<std::string> writes;
+    std::vector<std::string> lines;
+
+    explicit CaptureSink(std::string name, SinkFormat format = format_text, Level minLevel = log_verbose)
+            : Sink(std::move(name), format, minLevel) {
+    }
+
+    void write(std::string_view text, Level) override {
+        std::lock_guard<std::mutex> lock(_mutex);
+        writes.emplace_back(text);
+        while (!text.empty()) {
+            size_t end = text.find('\n');
+            lines.emplace_back(text.substr(0, end));
+            text.remove_prefix(end == std::string_view::npos ? text.size() : end + 1);
+        }
+    }
+
+    /**
+     * Last rendering, empty before the first.
+     */
+    std::string last() {
+        std::lock_guard<std::mutex> lock(_mutex);
+        return writes.empty() ? std::string() : writes.back();
+    }
+
+    /**
+     * Lines containing part.
+     */
+    long count(std::string_view part) {
+        std::lock_guard<std::mutex> lock(_mutex);
+        long n = 0;
+        for (const auto &line : lines)
+            if (line.find(part) != std::string::npos)
+                n++;
+        return n;
+    }
+
+    void clear() {
+        std::lock_guard<std::mutex> lock(_mutex);
+        writes.clear();
+        lines.clear();
+    }
+};
+
+/**
+ * Only counts the renderings it is handed, for statements issued by the million.
+ */
+class CountSink : public Sink {
+public:
+    std::atomic<long> lines{0};
+
+    explicit CountSink(std::string name) : Sink(std::move(name), format_text) {
+    }
+
+    void write(std::string_view, Level) override {
+        lines++;
+    }
+};
+
+#endif //LOGPP_TEST_SUPPORT_HPP
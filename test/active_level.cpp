@@ -0,0 +1,82 @@
+// MIT License
+//
+// Copyright (c) 2023 Salomon Lee
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+#include "TestSupport.hpp"
+#include <util/logging/BinaryLog.hpp>
+#include <util/logging/Log.hpp>
+#include <util/logging/LogFormat.hpp>
+#include <util/logging/LogLimit.hpp>
+#include <util/logging/Logger.hpp>
+#include <util/logging/SinkRegistry.hpp>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <string>
+
+// Built with LOGPP_ACTIVE_LEVEL=2, see test/CMakeLists.txt.
+static_assert(!Log::isActive(log_trace) && !Log::isActive(log_debug), "trace and debug are compiled out");
+static_assert(Log::isActive(log_info) && Log::isActive(log_verbose) && Log::isActive(log_error), "info and up stay");
+
+static int evaluated = 0;
+
+static int evaluate() {
+    return ++evaluated;
+}
+
+/**
+ * Statements below LOGPP_ACTIVE_LEVEL write nothing and evaluate nothing even with every level
+ * enabled at runtime, and their literals do not make it into the executable.
+ */
+int main(int, char **argv) {
+    const std::string file = "./resources/test-active-level.properties";
+    std::ofstream(file) << "level=verbose\nsinks=null\n";
+    LogProperties::reload(file);
+    auto sink = std::make_shared<CountSink>("capture-active");
+    SinkRegistry::instance()->add(sink);
+    Logger *pool = Logger::get("db.pool");
+
+    LOG_TRACE << "compiled-out-" << "trace " << evaluate();
+    LOG_DEBUG << "compiled-out-debug-statement " << evaluate();
+    LOG_DEBUGF("compiled-out-{} {}", "format", evaluate());
+    LOG_DEBUGB("compiled-out-binary {}", evaluate());
+    LOG_EVERY_N(log_debug, 1) << "compiled-out-limited " << evaluate();
+    LOGGER_DEBUG(pool) << "compiled-out-logger " << evaluate();
+    expect(evaluated == 0, "operands of compiled out statements evaluated " + std::to_string(evaluated) + " times");
+    expect(sink->lines == 0, "compiled out statements wrote " + std::to_string(sink->lines) + " lines");
+
+    LOG_INFO << "info " << evaluate();
+    LOG << "verbose " << evaluate();
+    LOGGER_WARN(pool) << "warning " << evaluate();
+    expect(evaluated == 3, "active statements evaluated their operands");
+    expect(sink->lines == 3, "active statements wrote " + std::to_string(sink->lines) + " lines");
+
+    std::ifstream self(argv[0], std::ios::binary);
+    std::string image((std::istreambuf_iterator<char>(self)), std::istreambuf_iterator<char>());
+    expect(!image.empty(), "read the executable");
+    expect(image.find(std::string("compiled-out-") + "debug-statement") == std::string::npos,
+           "literal of a compiled out statement is in the executable");
+
+    SinkRegistry::instance()->remove("capture-active");
+    std::cout << "active level failures: " << failures << std::endl;
+    return failures == 0 ? 0 : 1;
+}
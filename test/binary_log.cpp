@@ -0,0 +1,62 @@
+// MIT License
+//
+// Copyright (c) 2023 Salomon Lee
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+#include <util/logging/BinaryLog.hpp>
+#include <util/logging/BinaryLogReader.hpp>
+#include <util/properties/LogProperties.hpp>
+#include <util/LogUtil.hpp>
+#include <unistd.h>
+#include <iostream>
+#include <string>
+
+int main() {
+    const long count = 1000;
+    const std::string token = "run-" + std::to_string(getpid());
+    for (long i = 0; i < count; i++)
+        LOG_INFOB("{} i={} x={:X} f={:.2f} ok={}", token, i, 0xbeefu, 1.005 * static_cast<double>(i), i % 2 == 0);
+    BinaryLogWriter::instance()->flush();
+
+    const LogProperties *properties = LogProperties::instance();
+    BinaryLogReader reader(LogUtil::buildFileFullPath(properties->getLogPath(), properties->getBinaryFile()));
+    std::string line;
+    long found = 0;
+    while (reader.next(line)) {
+        size_t at = line.find(token + " ");
+        if (at == std::string::npos)
+            continue;
+        LogBuffer expected;
+        double f = 1.005 * static_cast<double>(found);
+        expected.append(token + " i=");
+        expected.appendNumber(found);
+        expected.append(" x=BEEF f=");
+        expected.appendNumber(f, std::chars_format::fixed, 2);
+        expected.append(found % 2 == 0 ? " ok=1\n" : " ok=0\n");
+        if (line.compare(at, std::string::npos, expected.view()) != 0 || line.rfind("INFO    |", 0) != 0) {
+            std::cerr << "unexpected line: " << line;
+            return 1;
+        }
+        found++;
+    }
+    std::cout << "decoded " << found << " of " << count << " binary records" << std::endl;
+    return found == count && !reader.isCorrupt() ? 0 : 1;
+}
@@ -0,0 +1,99 @@
+// MIT License
+//
+// Copyright (c) 2023 Salomon Lee
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+#include <util/logging/LogFormat.hpp>
+#include <util/logging/SinkRegistry.hpp>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+/**
+ * Many threads through buffered=true: every line must arrive whole, exactly once and in the order
+ * its thread wrote it, and an error line must be on disk when LOG_ERROR returns.
+ */
+static const int THREADS = 32;
+static const int LINES = 5000;
+
+static long countLines(const std::string &file, const std::string &needle) {
+    std::ifstream in(file);
+    std::string line;
+    long n = 0;
+    while (std::getline(in, line))
+        if (line.find(needle) != std::string::npos)
+            n++;
+    return n;
+}
+
+int main() {
+    const std::string file = "./test-buffered.log";
+    std::remove(file.c_str());
+    std::ofstream properties("./resources/test-buffered.properties");
+    properties << "level=verbose\npath=./\nfile=test-buffered.log\nmaxsz=1GB\nsinks=file\nbuffered=true\n";
+    properties.close();
+    LogProperties::reload("./resources/test-buffered.properties");
+
+    std::vector<std::thread> threads;
+    for (int t = 0; t < THREADS; t++)
+        threads.emplace_back([t]() {
+            for (int i = 0; i < LINES; i++)
+                LOG_INFOF("writer={} seq={} padding=................................................", t, i);
+        });
+    for (auto &thread : threads)
+        thread.join();
+
+    LOG_ERRORF("error-{}", 42);
+    int failures = 0;
+    if (countLines(file, "error-42") != 1) {
+        std::cerr << "error line was not written through" << std::endl;
+        failures++;
+    }
+
+    SinkRegistry::instance()->flush();
+    std::vector<int> next(THREADS, 0);
+    std::ifstream in(file);
+    std::string line;
+    long total = 0;
+    while (std::getline(in, line)) {
+        size_t at = line.find("writer=");
+        if (at == std::string::npos)
+            continue;
+        int writer = -1, seq = -1;
+        if (std::sscanf(line.c_str() + at, "writer=%d seq=%d", &writer, &seq) != 2 || writer < 0 || writer >= THREADS ||
+            line.size() < 48 || line.compare(line.size() - 48, 48, std::string(48, '.')) != 0) {
+            std::cerr << "torn line: " << line << std::endl;
+            failures++;
+            continue;
+        }
+        if (seq != next[writer]) {
+            std::cerr << "writer " << writer << " expected seq " << next[writer] << " got " << seq << std::endl;
+            failures++;
+        }
+        next[writer] = seq + 1;
+        total++;
+    }
+    std::cout << "buffered lines: " << total << " of " << THREADS * LINES << ", failures: " << failures << std::endl;
+    return failures == 0 && total == THREADS * LINES ? 0 : 1;
+}
@@ -0,0 +1,151 @@
+// MIT License
+//
+// Copyright (c) 2023 Salomon Lee
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+#include <util/logging/LogFormat.hpp>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <csignal>
+#include <sys/wait.h>
+#include <unistd.h>
+
+/**
+ * A child process configures one of the buffering modes, logs and dies of a fatal signal. Every
+ * line must be in the file afterwards, followed by the handler's record, and the child must still
+ * have been killed by that signal.
+ */
+static const int LINES = 200;
+
+static void crash(int signal) {
+    if (signal == SIGSEGV)
+        *static_cast<volatile int *>(nullptr) = 1;
+    std::abort();
+}
+
+static int run(const std::string &name, const std::string &settings, int signal) {
+    const std::string file = "./test-crash-" + name + ".log";
+    std::remove(file.c_str());
+    pid_t child = fork();
+    if (child == 0) {
+        std::ofstream properties("./resources/test-crash.properties");
+        properties << "level=verbose\npath=./\nfile=test-crash-" << name << ".log\nmaxsz=1GB\nsinks=file\n"
+                   << "crash.handler=true\ncrash.backtrace=true\n" << settings;
+        properties.close();
+        LogProperties::reload("./resources/test-crash.properties");
+        for (int i = 0; i < LINES; i++)
+            LOG_INFOF("line={} before the crash", i);
+        crash(signal);
+    }
+    int status = 0;
+    waitpid(child, &status, 0);
+
+    int failures = 0;
+    if (!WIFSIGNALED(status) || WTERMSIG(status) != signal) {
+        std::cerr << name << ": child was not killed by signal " << signal << std::endl;
+        failures++;
+    }
+    std::ifstream in(file);
+    std::string line;
+    int next = 0;
+    bool marker = false;
+    bool frames = false;
+    while (std::getline(in, line)) {
+        if (line.find("line=" + std::to_string(next) + " ") != std::string::npos)
+            next++;
+        else if (line.find("Fatal signal " + std::to_string(signal)) != std::string::npos)
+            marker = next == LINES;
+        else if (marker && line.find("    #") == 0)
+            frames = true;
+    }
+    if (next != LINES) {
+        std::cerr << name << ": " << next << " of " << LINES << " lines written before the crash" << std::endl;
+        failures++;
+    }
+    if (!marker || !frames) {
+        std::cerr << name << ": no crash record with a backtrace after the last line" << std::endl;
+        failures++;
+    }
+    return failures;
+}
+
+static void recovered(int) {
+}
+
+/**
+ * With a handler of its own installed before, that returns, the child goes on logging and a second
+ * signal is handled again.
+ */
+static int runRecovering() {
+    const std::string file = "./test-crash-recover.log";
+    std::remove(file.c_str());
+    pid_t child = fork();
+    if (child == 0) {
+        // A handler that hangs gets the child killed instead.
+        alarm(10);
+        signal(SIGFPE, recovered);
+        std::ofstream properties("./resources/test-crash.properties");
+        properties << "level=verbose\npath=./\nfile=test-crash-recover.log\nsinks=file\nbuffered=true\n"
+                   << "crash.handler=true\ncrash.backtrace=false\n";
+        properties.close();
+        LogProperties::reload("./resources/test-crash.properties");
+        LOG_INFO << "before the signal";
+        raise(SIGFPE);
+        LOG_ERROR << "after the signal";
+        raise(SIGFPE);
+        std::exit(0);
+    }
+    int status = 0;
+    waitpid(child, &status, 0);
+    int failures = 0;
+    if (!WIFEXITED(status) || WEXITSTATUS(status) != 0) {
+        std::cerr << "recover: child did not go on after its handler returned" << std::endl;
+        failures++;
+    }
+    std::ifstream in(file);
+    std::string line;
+    int signals = 0;
+    bool after = false;
+    while (std::getline(in, line)) {
+        if (line.find("Fatal signal " + std::to_string(SIGFPE)) != std::string::npos)
+            signals++;
+        else if (line.find("after the signal") != std::string::npos)
+            after = signals == 1;
+    }
+    if (signals != 2 || !after) {
+        std::cerr << "recover: " << signals << " crash records, line after the first: " << after << std::endl;
+        failures++;
+    }
+    return failures;
+}
+
+int main() {
+    int failures = 0;
+    failures += run("bytes", "flush=bytes\nflush.bytes=1MB\n", SIGABRT);
+    failures += run("buffered", "flush=bytes\nflush.bytes=1MB\nbuffered=true\n", SIGSEGV);
+    failures += run("async", "flush=bytes\nflush.bytes=1MB\nasync=true\n", SIGABRT);
+    failures += run("mmap", "mmap=true\n", SIGSEGV);
+    failures += runRecovering();
+    std::cout << "crash handler failures: " << failures << std::endl;
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,125 @@
+// MIT License
+//
+// Copyright (c) 2023 Salomon Lee
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+#include "TestSupport.hpp"
+#include <util/logging/DedupSink.hpp>
+#include <util/logging/Log.hpp>
+#include <util/logging/SinkRegistry.hpp>
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+static size_t countInFile(const std::string &file, const std::string &part) {
+    std::ifstream in(file);
+    size_t n = 0;
+    for (std::string line; std::getline(in, line);)
+        if (line.find(part) != std::string::npos)
+            n++;
+    return n;
+}
+
+static void storm(int n, const char *text) {
+    for (int i = 0; i < n; i++)
+        LOG_ERROR << text;
+}
+
+/**
+ * A run of identical records becomes the first one and a repeat count, per thread, and the
+ * timeout, flush() and a sinks rebuild write the count of a run that has not ended.
+ */
+int main() {
+    auto capture = std::make_shared<CaptureSink>("capture-dedup");
+    auto dedup = std::make_shared<DedupSink>(capture, 60000);
+    SinkRegistry::instance()->add(dedup);
+
+    storm(1000, "disk full");
+    LOG_INFO << "disk ok";
+    expect(capture->lines.size() == 3, "first, repeat count and next, got " + std::to_string(capture->lines.size()));
+    expect(capture->count("disk full") == 1, "one disk full line");
+    expect(capture->count("last message repeated 999 times") == 1, "repeat count");
+    expect(capture->lines.size() == 3 && capture->lines[2].find("disk ok") != std::string::npos, "order");
+
+    capture->clear();
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 4; t++)
+        threads.emplace_back([] {
+            storm(500, "link down");
+            LOG_INFO << "link up";
+        });
+    for (auto &thread : threads)
+        thread.join();
+    expect(capture->count("link down") == 4, "one line per thread, got " + std::to_string(capture->count("link down")));
+    expect(capture->count("last message repeated 499 times") == 4, "repeat count per thread");
+
+    capture->clear();
+    storm(10, "flapping");
+    dedup->flush();
+    expect(capture->count("last message repeated 9 times") == 1, "flush writes the open run");
+    storm(5, "flapping");
+    dedup->flush();
+    expect(capture->count("last message repeated 5 times") == 1, "run goes on after flush");
+    SinkRegistry::instance()->remove("capture-dedup");
+
+    auto timed = std::make_shared<CaptureSink>("capture-timeout");
+    auto timeout = std::make_shared<DedupSink>(timed, 50);
+    SinkRegistry::instance()->add(timeout);
+    storm(3, "timeout");
+    std::this_thread::sleep_for(std::chrono::milliseconds(80));
+    timeout->flushIfDue();
+    expect(timed->count("last message repeated 2 times") == 1, "timeout writes the repeat count");
+    std::this_thread::sleep_for(std::chrono::milliseconds(80));
+    timeout->flushIfDue();
+    storm(1, "timeout");
+    expect(timed->count("timeout") == 2, "a quiet run is forgotten, got " + std::to_string(timed->count("timeout")));
+    SinkRegistry::instance()->remove("capture-timeout");
+
+    // Configured stages keep their runs over rebuilds, and async=false still counts a quiet run.
+    std::remove("./test-dedup.log");
+    std::ofstream("./resources/test-dedup.properties")
+            << "level=verbose\npath=./\nfile=test-dedup.log\nsinks=file\ndedup=true\ndedup.timeout.ms=100\n";
+    LogProperties::reload("./resources/test-dedup.properties");
+    storm(10, "rebuilt");
+    SinkRegistry::instance()->add(std::make_shared<CaptureSink>("capture-rebuild"));
+    storm(5, "rebuilt");
+    SinkRegistry::instance()->remove("capture-rebuild");
+    storm(1, "reloaded");
+    expect(countInFile("./test-dedup.log", "last message repeated 14 times") == 1, "run kept over add and remove");
+    storm(10, "reloaded");
+    LogProperties::reload("./resources/test-dedup.properties");
+    LOG_INFO << "after reload";
+    expect(countInFile("./test-dedup.log", "last message repeated 10 times") == 1, "reload writes the open run");
+    storm(3, "quiet");
+    bool counted = false;
+    for (int i = 0; i < 100 && !counted; i++) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        counted = countInFile("./test-dedup.log", "last message repeated 2 times") == 1;
+    }
+    expect(counted, "timer writes the count of a quiet run");
+
+    std::cout << "dedup sink failures: " << failures << std::endl;
+    return failures == 0 ? 0 : 1;
+}
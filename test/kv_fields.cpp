@@ -0,0 +1,132 @@
+// MIT License
+//
+// Copyright (c) 2023 Salomon Lee
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+#include "TestSupport.hpp"
+#include <util/logging/Log.hpp>
+#include <util/logging/SinkRegistry.hpp>
+#include <util/LogUtil.hpp>
+#include <cmath>
+#include <cstdint>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <string>
+
+/**
+ * Streams with manipulators that stick to the stream it is handed.
+ */
+struct Hex {
+    int value;
+};
+
+static std::ostream &operator<<(std::ostream &out, const Hex &h) {
+    return out << std::hex << std::setfill('0') << std::setw(4) << h.value;
+}
+
+struct Plain {
+    int value;
+};
+
+static std::ostream &operator<<(std::ostream &out, const Plain &p) {
+    return out << p.value;
+}
+
+static bool endsWith(const std::string &text, const std::string &end) {
+    return text.size() >= end.size() && text.compare(text.size() - end.size(), end.size(), end) == 0;
+}
+
+static std::string escapeSlowly(std::string_view text) {
+    static const char HEX[] = "0123456789abcdef";
+    std::string out;
+    for (char ch : text) {
+        auto c = static_cast<unsigned char>(ch);
+        if (c == '"' || c == '\\')
+            out += std::string("\\") + ch;
+        else if (c == '\n')
+            out += "\\n";
+        else if (c == '\r')
+            out += "\\r";
+        else if (c == '\t')
+            out += "\\t";
+        else if (c < 0x20)
+            out += std::string("\\u00") + HEX[c >> 4] + HEX[c & 0xf];
+        else
+            out += ch;
+    }
+    return out;
+}
+
+/**
+ * Fields given with kv() come after the message as key=value in text and as JSON members, and
+ * the vectorized escaper matches a byte at a time one on every kind of input.
+ */
+int main() {
+    std::mt19937 random(17);
+    const char special[] = {'"', '\\', '\n', '\t', '\x01', '\x1f', ' ', 'a', '\x7f', '\x80', '\xff', '\xc3'};
+    for (int round = 0; round < 20000; round++) {
+        std::string text(random() % 70, 'x');
+        for (char &c : text)
+            if (random() % 8 == 0)
+                c = special[random() % sizeof(special)];
+        std::string fast;
+        LogUtil::appendJsonEscaped(fast, text);
+        if (fast != escapeSlowly(text)) {
+            expect(false, "escaping of '" + text + "'");
+            break;
+        }
+    }
+
+    auto text = std::make_shared<CaptureSink>("capture-text", format_text);
+    auto json = std::make_shared<CaptureSink>("capture-json", format_json);
+    SinkRegistry::instance()->add(text);
+    SinkRegistry::instance()->add(json);
+
+    LOG_INFO.kv("user_id", 42).kv("latency_us", 12.5).kv("name", "a \"b\"").kv("ok", true).kv("bytes", 7u)
+            .kv("empty", "") << "served";
+    expect(endsWith(text->last(),
+                    ": served user_id=42 latency_us=12.5 name=\"a \\\"b\\\"\" ok=true bytes=7 empty=\"\"\n"),
+           "text fields, got " + text->last());
+    expect(endsWith(json->last(), "served\",\"user_id\":42,\"latency_us\":12.5,\"name\":\"a \\\"b\\\"\","
+                                "\"ok\":true,\"bytes\":7,\"empty\":\"\"}\n"),
+           "json fields, got " + json->last());
+
+    std::string path = "/var/log/app";
+    LOG_WARN.kv("path", path).kv("ratio", INFINITY).kv("delta", -3) << "plain";
+    expect(endsWith(text->last(), ": plain path=/var/log/app ratio=inf delta=-3\n"),
+           "unquoted text, got " + text->last());
+    expect(endsWith(json->last(), ",\"path\":\"/var/log/app\",\"ratio\":\"inf\",\"delta\":-3}\n"),
+           "non-finite json, got " + json->last());
+
+    LOG_INFO << int8_t('a') << uint8_t('b') << ' ' << Hex{255} << ' ' << Plain{255};
+    expect(endsWith(text->last(), ": ab 00ff 255\n"), "chars and stream state, got " + text->last());
+    LOG_INFO.kv("id", Hex{26}).kv("n", Plain{26}) << "kv";
+    expect(endsWith(text->last(), ": kv id=001a n=26\n"), "kv stream state, got " + text->last());
+
+    LOG_INFO << "no fields";
+    expect(endsWith(json->last(), "no fields\"}\n"), "no fields, got " + json->last());
+
+    SinkRegistry::instance()->remove("capture-text");
+    SinkRegistry::instance()->remove("capture-json");
+    std::cout << "kv fields failures: " << failures << std::endl;
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,107 @@
+// MIT License
+//
+// Copyright (c) 2023 Salomon Lee
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+#include "TestSupport.hpp"
+#include <util/LogUtil.hpp>
+#include <util/fio/LogArchiver.hpp>
+#include <util/fio/SegmentReader.hpp>
+#include <util/logging/Log.hpp>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <random>
+#include <string>
+#include <zlib.h>
+
+static std::string lower(std::string text) {
+    for (char &c : text)
+        c = static_cast<char>(std::tolower(static_cast<unsigned char>(c)));
+    return text;
+}
+
+static std::string readAll(const std::string &file) {
+    SegmentReader reader(file);
+    std::string text;
+    char buffer[4096];
+    for (size_t n; (n = reader.read(buffer, sizeof(buffer))) > 0;)
+        text.append(buffer, n);
+    expect(reader.isOpen() && !reader.hasError(), "read " + file);
+    return text;
+}
+
+/**
+ * The pieces of logpp-grep: literal search against std::string_view::find, heads read back from
+ * rendered lines, and the rolled segments of a log found and read whether compressed or not.
+ */
+int main() {
+    std::mt19937 random(7);
+    std::string text(5000, ' ');
+    for (char &c : text)
+        c = "abcAB\n"[random() % 6];
+    for (int i = 0; i < 2000; i++) {
+        std::string needle = text.substr(random() % 4990, 1 + random() % 8);
+        size_t from = random() % 100;
+        expect(LogUtil::findLiteral(text, needle, false, from) == text.find(needle, from), "find " + needle);
+        expect(LogUtil::findLiteral(text, needle, true, from) == lower(text).find(lower(needle), from), "find -i " + needle);
+    }
+    expect(LogUtil::findLiteral(text, "abcabcabcabcabcabcabc", false) == std::string::npos, "no match");
+    expect(LogUtil::findLiteral("short", "longer than text", false) == std::string::npos, "needle beyond text");
+
+    LogRecord record;
+    record.level = log_warning;
+    record.time = timespec{1792281415, 337699000};
+    record.message.append("disk ) - almost (full)");
+    std::string line;
+    Log::renderFile(record, line);
+    Level level = log_info;
+    long micros = 0;
+    expect(Log::parseHead(line, level, micros) && level == log_warning && micros == 1792281415337699L, "file head: " + line);
+    line.clear();
+    record.level = log_verbose;
+    Log::renderJson(record, line);
+    expect(Log::parseHead(line, level, micros) && level == log_verbose && micros == 1792281415337699L, "json head: " + line);
+    expect(!Log::parseHead("    at frame 3 (main.cpp)", level, micros), "continuation line");
+
+    const std::string directory = "./resources/segments";
+    std::filesystem::remove_all(directory);
+    std::filesystem::create_directories(directory);
+    std::ofstream(directory + "/app.log") << "active\n";
+    std::ofstream(directory + "/app-1792281415000000.log") << "rolled, waiting for compression\n";
+    std::ofstream(directory + "/app-1792281400000000.log.gz.part") << "partial archive\n";
+    std::ofstream(directory + "/app-old.log") << "not a segment\n";
+    gzFile gz = gzopen((directory + "/app-1792281400000000.log.gz").c_str(), "wb");
+    gzputs(gz, "oldest\nsegment\n");
+    gzclose(gz);
+    std::vector<std::string> segments = LogArchiver::segmentsOf(directory + "/app.log");
+    expect(segments.size() == 2 && segments[0].ends_with("app-1792281400000000.log.gz") &&
+           segments[1].ends_with("app-1792281415000000.log"), "rolled segments, oldest first");
+    if (segments.size() == 2) {
+        expect(readAll(segments[0]) == "oldest\nsegment\n", "gzip segment decompressed");
+        expect(readAll(segments[1]) == "rolled, waiting for compression\n", "plain segment");
+    }
+    expect(SegmentReader::codecOf("app-1.log.zst") == codec_zstd && SegmentReader::codecOf("app.log") == codec_none,
+           "codec by extension");
+
+    std::cout << "log grep failures: " << failures << std::endl;
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,108 @@
+// MIT License
+//
+// Copyright (c) 2023 Salomon Lee
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+#include "TestSupport.hpp"
+#include <util/fio/PropertiesWatcher.hpp>
+#include <util/logging/Log.hpp>
+#include <util/logging/Logger.hpp>
+#include <util/logging/SinkRegistry.hpp>
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <string>
+#include <thread>
+
+static void writeProperties(const std::string &file, const std::string &lines) {
+    std::ofstream properties(file);
+    properties << lines;
+}
+
+static bool waitFor(const std::function<bool()> &condition) {
+    for (int i = 0; i < 300 && !condition(); i++)
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    return condition();
+}
+
+/**
+ * level.<module> entries and Logger::setLevel give parts of the tree their own level, the longest
+ * module wins, modules only match below source.root or at the end of a path, and watch=true reloads
+ * the file when it is rewritten or replaced.
+ */
+int main() {
+    const std::string file = "./resources/test-levels.properties";
+    writeProperties(file, "level=error\nsinks=null\nlevel.test=debug\nwatch=true\n");
+    LogProperties::reload(file);
+    auto sink = std::make_shared<CountSink>("capture-levels");
+    SinkRegistry::instance()->add(sink);
+
+    expect(Log::isEnabled(log_debug, __FILE__), "debug in the test module");
+    expect(!Log::isEnabled(log_info, __FILE__), "info is not debug");
+    expect(!Log::isEnabled(log_debug, "/src/db/pool.cpp"), "debug elsewhere");
+    expect(Log::isEnabled(log_error, "/src/db/pool.cpp"), "error elsewhere");
+    expect(!Log::isEnabled(log_debug, "/home/test/checkout/src/db/pool.cpp"), "checkout directories are not modules");
+    LOG_DEBUG << "module debug";
+    LOG_INFO << "module info";
+    expect(sink->lines == 1, "one line through the module level, got " + std::to_string(sink->lines));
+    {
+        static constexpr LogSite site{__FILE__, __func__, __LINE__};
+        Log pending(&site, log_debug);
+        pending << "started before the override";
+        Logger::setLevel("log_levels", log_error);
+    }
+    expect(sink->lines == 1, "module level published during a statement");
+    Logger::clearLevel("log_levels");
+
+    Logger::setLevel("db", log_info);
+    Logger::setLevel("db.pool", log_trace);
+    expect(Log::isEnabled(log_trace, "/src/db/pool.cpp"), "longest module");
+    expect(!Log::isEnabled(log_info, "/src/db/pool.cpp"), "longest module only");
+    expect(Log::isEnabled(log_info, "/src/db/conn.cpp"), "module directory");
+    expect(Logger::getLevel("db.pool.idle") == log_trace, "level of the module above");
+    Logger::clearLevel("db.pool");
+    expect(Log::isEnabled(log_info, "/src/db/pool.cpp"), "cleared module");
+    Logger::setLevel(log_warning);
+    expect(Log::isEnabled(log_warning, "/src/other.cpp"), "global level");
+    expect(!Log::isEnabled(log_error, "/src/other.cpp"), "global level replaced");
+    expect(Logger::getLevel("db") == log_info, "module kept");
+
+    writeProperties(file, "level=error\nsinks=null\nwatch=true\n");
+    expect(waitFor([] { return !Log::isEnabled(log_debug, __FILE__); }), "rewritten file reloaded");
+    expect(Logger::getLevel("db") == log_error, "reload replaces runtime levels");
+
+    writeProperties(file + ".new", "level=error\nsinks=null\nlevel.test=trace\nwatch=true\n");
+    std::rename((file + ".new").c_str(), file.c_str());
+    expect(waitFor([] { return Log::isEnabled(log_trace, __FILE__); }), "replaced file reloaded");
+    expect(PropertiesWatcher::instance()->getReloads() >= 2, "watcher counted its reloads");
+
+    writeProperties(file, "level=error\nsinks=null\nsource.root=/work/app/\nlevel.net=debug\n");
+    expect(waitFor([] { return PropertiesWatcher::instance()->getFile().empty(); }), "watch=false stops watching");
+    expect(Log::isEnabled(log_debug, "/work/app/net/http/client.cpp"), "module below the source root");
+    expect(!Log::isEnabled(log_debug, "/work/net/app/http/client.cpp"), "outside the source root");
+    expect(!Log::isEnabled(log_debug, "/work/application/net/http/client.cpp"), "root is a whole directory");
+
+    SinkRegistry::instance()->remove("capture-levels");
+    std::cout << "log levels failures: " << failures << std::endl;
+    return failures == 0 ? 0 : 1;
+}
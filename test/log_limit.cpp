@@ -0,0 +1,107 @@
+// MIT License
+//
+// Copyright (c) 2023 Salomon Lee
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+#include "TestSupport.hpp"
+#include <util/logging/LogLimit.hpp>
+#include <util/logging/SinkRegistry.hpp>
+#include <chrono>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+static void every(int i) {
+    LOG_EVERY_N(log_info, 100) << "limited every " << i;
+}
+
+static void rate(int i) {
+    LOG_RATE(log_info, 50) << "limited rate " << i;
+}
+
+/**
+ * Each macro lets the expected share of its statements through, the every-n count holds across
+ * threads, and report() writes one summary per site with what was suppressed, as do a flush and
+ * the timer once the statements have stopped.
+ */
+int main() {
+    auto sink = std::make_shared<CaptureSink>("capture-limit");
+    SinkRegistry::instance()->add(sink);
+
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 4; t++)
+        threads.emplace_back([] {
+            for (int i = 0; i < 5000; i++)
+                every(i);
+        });
+    for (auto &thread : threads)
+        thread.join();
+    expect(sink->count("limited every") == 200,
+           "every 100th of 20000, got " + std::to_string(sink->count("limited every")));
+
+    for (int i = 0; i < 1000; i++)
+        LOG_FIRST_N(log_info, 5) << "limited first " << i;
+    expect(sink->count("limited first") == 5, "first 5, got " + std::to_string(sink->count("limited first")));
+
+    for (int i = 0; i < 10000; i++)
+        rate(i);
+    long burst = sink->count("limited rate");
+    expect(burst >= 50 && burst <= 55, "burst of 50, got " + std::to_string(burst));
+    std::this_thread::sleep_for(std::chrono::milliseconds(200));
+    for (int i = 0; i < 10000; i++)
+        rate(i);
+    long refill = sink->count("limited rate") - burst;
+    expect(refill >= 8 && refill <= 14, "refill of 10 in 200ms, got " + std::to_string(refill));
+
+    for (int i = 0; i < 20000; i++)
+        LOG_SAMPLED(log_info, 0.1) << "limited sample " << i;
+    expect(sink->count("limited sample") >= 1700 && sink->count("limited sample") <= 2300,
+           "sample of 10%, got " + std::to_string(sink->count("limited sample")));
+
+    LogLimit::report();
+    expect(sink->count("suppressed 19800 statements") == 1, "every-n summary");
+    expect(sink->count("suppressed 995 statements") == 1, "first-n summary");
+    expect(sink->count("suppressed ") == 4, "one summary per site, got " + std::to_string(sink->count("suppressed ")));
+    sink->clear();
+    LogLimit::report();
+    expect(sink->count("suppressed ") == 0, "summaries are reset");
+
+    for (int i = 0; i < 1000; i++)
+        every(i);
+    SinkRegistry::instance()->flush();
+    expect(sink->count("suppressed 990 statements") == 1, "flush writes the summaries");
+
+    // Summaries of a storm that has stopped still go out once the interval is over.
+    std::ofstream("./resources/test-limit.properties") << "level=verbose\nsinks=null\nlimit.report.ms=100\n";
+    LogProperties::reload("./resources/test-limit.properties");
+    sink->clear();
+    for (int i = 0; i < 1000; i++)
+        every(i);
+    for (int i = 0; i < 200 && sink->count("suppressed ") == 0; i++)
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    expect(sink->count("suppressed 990 statements") == 1, "summary after the storm");
+
+    SinkRegistry::instance()->remove("capture-limit");
+    std::cout << "log limit failures: " << failures << std::endl;
+    return failures == 0 ? 0 : 1;
+}
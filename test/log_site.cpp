@@ -0,0 +1,117 @@
+// MIT License
+//
+// Copyright (c) 2023 Salomon Lee
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+#include "TestSupport.hpp"
+#include <util/logging/Log.hpp>
+#include <util/logging/LogSite.hpp>
+#include <util/logging/SinkRegistry.hpp>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+/**
+ * Keeps the site of every record.
+ */
+class SiteSink : public Sink {
+public:
+    std::vector<const LogSite *> sites;
+
+    explicit SiteSink(std::string name) : Sink(std::move(name), format_custom) {
+    }
+
+    void format(const LogRecord &record, std::string &out) override {
+        sites.push_back(record.site);
+        out.append(record.message.data(), record.message.size());
+    }
+
+    void write(std::string_view, Level) override {
+    }
+};
+
+static void expectShort(const std::string &function, const std::string &expected) {
+    std::string_view actual = LogSite::shortFunction(function);
+    expect(actual == expected, "short name of " + function + " is " + std::string(actual));
+}
+
+/**
+ * Records point at one static site per statement, and the sinks render the location from it in
+ * full or trimmed with location.file=basename and location.function=short.
+ */
+int main() {
+    expect(LogSite::basename("/src/util/logging/Log.cpp") == "Log.cpp", "basename of a path");
+    expect(LogSite::basename("Log.cpp") == "Log.cpp", "basename of a file name");
+    expectShort("virtual Connection* Pool::get(int) const", "Pool::get");
+    expectShort("int g(T) [with T = int]", "g");
+    expectShort("void ns::Table<int, long int>::put(const K&, V&&) &&", "ns::Table<int, long int>::put");
+    expectShort("std::map<int, int> index() noexcept", "index");
+    expectShort("Pool::Pool(int)", "Pool::Pool");
+    expectShort("bool Key::operator<(const Key&) const", "Key::operator<");
+    expectShort("void Visitor::operator()(int)", "Visitor::operator()");
+    expectShort("Key::operator bool() const", "Key::operator bool");
+    expectShort("main", "main");
+    expectShort("main()::<lambda()>", "main()::<lambda()>");
+
+    std::ofstream("./resources/test-site.properties") << "level=verbose\nsinks=null\n";
+    LogProperties::reload("./resources/test-site.properties");
+    auto text = std::make_shared<CaptureSink>("capture-text", format_text);
+    auto json = std::make_shared<CaptureSink>("capture-json", format_json);
+    auto sites = std::make_shared<SiteSink>("capture-sites");
+    SinkRegistry::instance()->add(text);
+    SinkRegistry::instance()->add(json);
+    SinkRegistry::instance()->add(sites);
+
+    long line = 0;
+    for (int i = 0; i < 2; i++) {
+        line = __LINE__ + 1;
+        LOG_INFO << "site " << i;
+    }
+    expect(sites->sites.size() == 2 && sites->sites[0] != nullptr && sites->sites[0] == sites->sites[1],
+           "one site for both records of the statement");
+    expect(sites->sites[0]->line == line && std::string(sites->sites[0]->file) == __FILE__, "site of the statement");
+
+#ifdef LOGPP_SOURCE_LOCATION
+    std::string full = std::string("[") + __FILE__ + " - int main()](line: " + std::to_string(line) + "): site 0";
+    expect(text->writes.size() == 2 && text->writes[0].find(full) != std::string::npos, "full location: " + text->writes[0]);
+    expect(json->writes.size() == 2 && json->writes[0].find(std::string("\"file\":\"") + __FILE__ +
+                                                             "\",\"function\":\"int main()\",\"line\":" +
+                                                             std::to_string(line) + ",\"message\":\"site 0\"") !=
+                                       std::string::npos, "json location: " + json->writes[0]);
+
+    std::ofstream("./resources/test-site.properties")
+            << "level=verbose\nsinks=null\nlocation.file=basename\nlocation.function=short\n";
+    LogProperties::reload("./resources/test-site.properties");
+    line = __LINE__ + 1;
+    LOG_WARN << "trimmed";
+    std::string trimmed = "[log_site.cpp - main](line: " + std::to_string(line) + "): trimmed";
+    expect(text->writes.size() == 3 && text->writes[2].find(trimmed) != std::string::npos, "trimmed location: " + text->writes[2]);
+    expect(json->writes.size() == 3 && json->writes[2].find("\"file\":\"log_site.cpp\",\"function\":\"main\"") != std::string::npos,
+           "json trimmed location: " + json->writes[2]);
+#endif
+
+    SinkRegistry::instance()->remove("capture-text");
+    SinkRegistry::instance()->remove("capture-json");
+    SinkRegistry::instance()->remove("capture-sites");
+    std::cout << "log site failures: " << failures << std::endl;
+    return failures == 0 ? 0 : 1;
+}
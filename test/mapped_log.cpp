@@ -0,0 +1,137 @@
+// MIT License
+//
+// Copyright (c) 2023 Salomon Lee
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+#include <util/fio/MappedLog.hpp>
+#include <util/fio/LogArchiver.hpp>
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+static int failures = 0;
+
+static void check(bool ok, const std::string &what) {
+    if (!ok) {
+        std::cerr << "FAILED: " << what << std::endl;
+        failures++;
+    }
+}
+
+static std::string readAll(const std::string &file) {
+    std::ifstream in(file, std::ios::binary);
+    return {std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>()};
+}
+
+/**
+ * Threads appending through mmap=true across many rollovers: every line must come back whole, in
+ * order per thread, with no zero fill left in the segments. Closing truncates to the used length,
+ * and a file left with its preallocated tail is continued after its last line.
+ */
+int main() {
+    const std::string dir = "./test-mapped";
+    std::filesystem::remove_all(dir);
+    std::filesystem::create_directories(dir);
+
+    MappedLog *log = MappedLog::instance(dir + "/mapped.log", 128 * 1024);
+    log->configure(128 * 1024, 1000, codec_none, -1, 5);
+    const int threads = 8;
+    const long lines = 20000;
+    std::vector<std::thread> writers;
+    for (int t = 0; t < threads; t++) {
+        writers.emplace_back([log, t]() {
+            std::string line;
+            for (long i = 0; i < lines; i++) {
+                line = "t" + std::to_string(t) + " " + std::to_string(i) + " ........................................\n";
+                log->write(line);
+            }
+        });
+    }
+    for (std::thread &writer : writers)
+        writer.join();
+    log->flush();
+    LogArchiver::instance()->wait();
+    check(log->getRollovers() > 10, "rolled over " + std::to_string(log->getRollovers()) + " times");
+    check(std::filesystem::exists(dir + "/mapped.log.next"), "next segment prepared");
+
+    std::vector<std::string> files;
+    for (auto &entry : std::filesystem::directory_iterator(dir)) {
+        std::string name = entry.path().filename().string();
+        if (name != "mapped.log" && name != "mapped.log.next")
+            files.push_back(entry.path().string());
+    }
+    std::sort(files.begin(), files.end());
+    files.push_back(dir + "/mapped.log");
+
+    std::vector<long> next(threads, 0);
+    long total = 0;
+    for (size_t f = 0; f < files.size(); f++) {
+        std::string content = readAll(files[f]);
+        if (f + 1 < files.size())
+            check(content.size() <= 128 * 1024, files[f] + " within maxsz");
+        else
+            content.erase(content.find_last_not_of('\0') + 1);  // still open, with its zero tail
+        check(content.find('\0') == std::string::npos, files[f] + " has no zero fill");
+        size_t start = 0;
+        for (size_t end; (end = content.find('\n', start)) != std::string::npos; start = end + 1) {
+            std::string line = content.substr(start, end - start);
+            int t = -1;
+            long i = -1;
+            if (std::sscanf(line.c_str(), "t%d %ld ", &t, &i) != 2 || t < 0 || t >= threads) {
+                check(false, "malformed line '" + line + "' in " + files[f]);
+                continue;
+            }
+            check(i == next[t], "thread " + std::to_string(t) + " line " + std::to_string(i) + " in order");
+            next[t] = i + 1;
+            total++;
+        }
+        check(start == content.size(), files[f] + " ends with a whole line");
+        if (failures > 5)
+            break;
+    }
+    check(total == threads * lines, "read back " + std::to_string(total) + " of " + std::to_string(threads * lines));
+
+    // A clean close truncates to what was written.
+    {
+        MappedLog closed(dir + "/closed.log", 64 * 1024);
+        closed.write("first\n");
+    }
+    check(readAll(dir + "/closed.log") == "first\n", "truncated on close");
+    check(!std::filesystem::exists(dir + "/closed.log.next"), "next segment removed on close");
+
+    // A segment left with its zero tail, as after a crash, is continued after the last line.
+    {
+        std::ofstream crashed(dir + "/crashed.log", std::ios::binary);
+        crashed << "before\n" << std::string(4096, '\0');
+    }
+    {
+        MappedLog reopened(dir + "/crashed.log", 64 * 1024);
+        reopened.write("after\n");
+    }
+    check(readAll(dir + "/crashed.log") == "before\nafter\n", "continued after a crash");
+
+    std::cout << "mapped lines read back: " << total << " from " << files.size() << " files" << std::endl;
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,78 @@
+// MIT License
+//
+// Copyright (c) 2023 Salomon Lee
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+#include "TestSupport.hpp"
+#include <util/logging/Logger.hpp>
+#include <util/logging/SinkRegistry.hpp>
+#include <fstream>
+#include <iostream>
+#include <string>
+
+/**
+ * Named loggers take level and sinks from the nearest entry up their dotted name, and keep them
+ * in step with runtime level changes and loggers created later.
+ */
+int main() {
+    std::ofstream properties("./resources/test-loggers.properties");
+    properties << "level=error\nsinks=null\nlevel.db=debug\nlevel.db.cache=silent\nsinks.db=capture-db\n";
+    properties.close();
+    LogProperties::reload("./resources/test-loggers.properties");
+    auto all = std::make_shared<CaptureSink>("capture-all", format_text);
+    auto db = std::make_shared<CaptureSink>("capture-db", format_json);
+    SinkRegistry::instance()->add(all);
+    SinkRegistry::instance()->add(db);
+
+    Logger *pool = Logger::get("db.pool");
+    Logger *cache = Logger::get("db.cache");
+    Logger *net = Logger::get("net");
+    expect(Logger::get("db.pool") == pool, "one logger per name");
+    expect(pool->isEnabled(log_debug) && !pool->isEnabled(log_error), "level of db");
+    expect(!cache->isEnabled(log_debug) && !cache->isEnabled(log_error), "level of db.cache");
+    expect(net->isEnabled(log_error) && !net->isEnabled(log_debug), "global level");
+
+    LOGGER_DEBUG(pool) << "pool debug";
+    LOGGER_ERROR(net) << "net error";
+    LOGGER_DEBUG(cache) << "cache debug";
+    expect(all->writes.size() == 1 && all->writes[0].find("net error") != std::string::npos,
+           "root sinks get the net logger only");
+    expect(db->writes.size() == 2, "db sink gets the root and the db records, got " + std::to_string(db->writes.size()));
+    expect(!db->writes.empty() && db->writes[0].find("\"logger\":\"db.pool\"") != std::string::npos,
+           "json names the logger");
+
+    Logger::setLevel("db.pool", log_info);
+    expect(pool->isEnabled(log_info) && !pool->isEnabled(log_debug), "runtime level of db.pool");
+    Logger *idle = Logger::get("db.pool.idle");
+    expect(idle->isEnabled(log_info), "new logger inherits the runtime level");
+    all->writes.clear();
+    db->writes.clear();
+    LOGGER_INFO(idle) << "idle info";
+    expect(all->writes.empty() && db->writes.size() == 1, "new logger inherits the sinks of db");
+
+    LogProperties::reload("./resources/test-loggers.properties");
+    expect(pool->isEnabled(log_debug) && !pool->isEnabled(log_info), "reload restores the file levels");
+
+    SinkRegistry::instance()->remove("capture-all");
+    SinkRegistry::instance()->remove("capture-db");
+    std::cout << "named loggers failures: " << failures << std::endl;
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,80 @@
+// MIT License
+//
+// Copyright (c) 2023 Salomon Lee
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+#include <util/logging/Log.hpp>
+#include <util/fio/LogArchiver.hpp>
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <string>
+
+/**
+ * Slowest LOG_INFO of 100000 into file, rolled over at maxsz.
+ */
+static long slowestUs(const std::string &file, const std::string &maxsz) {
+    std::ofstream properties("./resources/rollover-latency.properties");
+    properties << "level=verbose\n" << "path=./\n" << "file=" << file << "\n" << "maxsz=" << maxsz << "\n"
+               << "roqty=2\n" << "sinks=file\n" << "flush=bytes\n" << "flush.bytes=64KB\n";
+    properties.close();
+    LogProperties::reload("./resources/rollover-latency.properties");
+
+    std::string payload(200, 'x');
+    std::chrono::nanoseconds slowest{0};
+    for (int i = 0; i < 100000; i++) {
+        auto start = std::chrono::steady_clock::now();
+        LOG_INFO << payload;
+        auto elapsed = std::chrono::steady_clock::now() - start;
+        if (elapsed > slowest)
+            slowest = elapsed;
+    }
+    LogArchiver::instance()->wait();
+    return std::chrono::duration_cast<std::chrono::microseconds>(slowest).count();
+}
+
+/**
+ * Logs through several 4MB rollovers and reports the slowest call next to the slowest of the same
+ * load without rollovers. The rolled segment is renamed and compressed in the background, so no
+ * single call should stall for a copy of the active file. Wall-clock times depend on the machine
+ * and its load, so they are only reported; the test fails when retention did not keep roqty=2
+ * segments of its own, or touched the archive of another logger.
+ */
+int main() {
+    // Archive of another logger in the same directory, which retention of rollover-latency.log
+    // neither counts nor removes.
+    std::string foreign = "./rollover-latency-server-1000000000000000.log.gz";
+    std::ofstream(foreign) << "not ours\n";
+
+    long baseline = slowestUs("rollover-baseline.log", "1GB");
+    long rolling = slowestUs("rollover-latency.log", "4MB");
+    std::remove("./rollover-baseline.log");
+
+    size_t rolled = LogArchiver::segmentsOf("./rollover-latency.log").size();
+    std::cout << "slowest log call: " << baseline << "us without rollover, " << rolling << "us across rollovers ("
+              << rolled << " segments kept)" << std::endl;
+    bool kept = std::ifstream(foreign).good();
+    if (!kept)
+        std::cerr << "FAILED: retention removed " << foreign << std::endl;
+    std::remove(foreign.c_str());
+    return rolled == 2 && kept ? 0 : 1;
+}
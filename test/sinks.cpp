@@ -0,0 +1,94 @@
+// MIT License
+//
+// Copyright (c) 2023 Salomon Lee
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+#include "TestSupport.hpp"
+#include <util/logging/Log.hpp>
+#include <util/logging/SinkRegistry.hpp>
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <thread>
+
+static void useProperties(const std::string &lines) {
+    std::ofstream properties("./resources/test-sinks.properties");
+    properties << lines;
+    properties.close();
+    LogProperties::reload("./resources/test-sinks.properties");
+}
+
+int main() {
+    std::ostringstream console;
+    std::streambuf *stdout = std::cout.rdbuf(console.rdbuf());
+
+    // Console limited to warnings, every level still reaches the file.
+    useProperties("level=verbose\npath=./\nfile=test-sinks.log\nsinks=console, file, json\n"
+                  "sink.console.level=warning\nsink.json.level=error\n");
+    auto capture = std::make_shared<CaptureSink>("capture", format_text, log_info);
+    SinkRegistry::instance()->add(capture);
+    LOG_TRACE << "trace for the file";
+    LOG_INFO << "info for file and capture";
+    LOG_WARN << "warning for everyone";
+    LOG_ERROR << "error \"quoted\"";
+    SinkRegistry::instance()->flush();
+
+    std::string out = console.str();
+    expect(out.find("trace for the file") == std::string::npos, "console skips trace");
+    expect(out.find("info for file") == std::string::npos, "console skips info");
+    expect(out.find("warning for everyone") != std::string::npos, "console shows warning");
+    expect(out.find("\033[41mERROR") != std::string::npos, "console is colored");
+
+    expect(capture->writes.size() == 3, "capture sink takes info and above");
+    expect(!capture->writes.empty() && capture->writes[0].rfind("INFO    |", 0) == 0, "capture gets plain text");
+
+    std::ifstream json("./test-sinks.json");
+    std::string line, last;
+    while (std::getline(json, line))
+        last = line;
+    expect(last.find("\"level\":\"ERROR\"") != std::string::npos, "json line has its level");
+    expect(last.find("error \\\"quoted\\\"\"}") != std::string::npos, "json message is escaped");
+
+    // Removing the sink takes effect for the next statement.
+    SinkRegistry::instance()->remove("capture");
+    LOG_ERROR << "not captured";
+    expect(capture->writes.size() == 3, "removed sink gets nothing");
+
+    // flush=ms writes an idle buffer out without waiting for the next line.
+    std::remove("./test-sinks-ms.log");
+    useProperties("level=verbose\npath=./\nfile=test-sinks-ms.log\nsinks=file\nflush=ms\nflush.ms=50\n");
+    LOG_INFO << "idle line";
+    bool written = false;
+    for (int i = 0; i < 100 && !written; i++) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        std::ifstream ms("./test-sinks-ms.log");
+        written = std::getline(ms, line) && line.find("idle line") != std::string::npos;
+    }
+    expect(written, "flush=ms writes an idle buffer");
+
+    std::cout.rdbuf(stdout);
+    std::cout << "sink checks failed: " << failures << std::endl;
+    return failures == 0 ? 0 : 1;
+}
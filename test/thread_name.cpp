@@ -0,0 +1,93 @@
+// MIT License
+//
+// Copyright (c) 2023 Salomon Lee
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+#include "TestSupport.hpp"
+#include <util/logging/Log.hpp>
+#include <util/logging/Logger.hpp>
+#include <util/logging/SinkRegistry.hpp>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <pthread.h>
+#include <unistd.h>
+#include <sys/syscall.h>
+#include <sys/wait.h>
+
+static std::string kernelId() {
+    return std::to_string(syscall(SYS_gettid));
+}
+
+/**
+ * The thx-id of a line is the kernel id of its thread, followed by the name given with
+ * Logger::setThreadName, which the kernel sees too; a forked child reports its own id. Names that
+ * would break the head of the line are made safe.
+ */
+int main() {
+    std::ofstream("./resources/test-thread.properties") << "level=verbose\nsinks=null\n";
+    LogProperties::reload("./resources/test-thread.properties");
+    auto text = std::make_shared<CaptureSink>("capture-thread", format_text);
+    SinkRegistry::instance()->add(text);
+
+    expect(Log::threadId() == kernelId(), "kernel id of the main thread, got " + std::string(Log::threadId()));
+
+    std::string worker;
+    std::thread([&worker] {
+        worker = kernelId();
+        Logger::setThreadName("worker-7");
+        LOG_INFO << "named";
+        char name[16]{};
+        pthread_getname_np(pthread_self(), name, sizeof(name));
+        expect(std::string(name) == "worker-7", "kernel name of the thread, got " + std::string(name));
+        Logger::setThreadName("a-thread-name-well-beyond-the-record");
+        expect(Log::threadId().size() == sizeof(LogRecord::thread), "prefix cut to the record");
+        pthread_getname_np(pthread_self(), name, sizeof(name));
+        expect(std::string(name) == "a-thread-name-w", "kernel name cut to 15, got " + std::string(name));
+    }).join();
+    expect(text->writes.size() == 1 && text->writes[0].find("(thx-id: " + worker + ":worker-7)") != std::string::npos,
+           "named thread in the line: " + (text->writes.empty() ? std::string() : text->writes[0]));
+
+    // A name that reads like the end of the thx-id field must not cut the head short.
+    std::thread([] {
+        Logger::setThreadName("db) - 1 (2)\npool");
+        LOG_WARN << "odd name";
+    }).join();
+    Level level = log_info;
+    long micros = 0;
+    expect(text->writes.size() == 2 && text->writes[1].find(":db_ - 1 (2__pool)") != std::string::npos &&
+           Log::parseHead(text->writes[1], level, micros) && level == log_warning && micros > 1000000000000000L,
+           "head of a line with an odd thread name: " + text->last());
+
+    Logger::setThreadName("main");
+    pid_t child = fork();
+    if (child == 0)
+        _exit(Log::threadId() == kernelId() + ":main" ? 0 : 1);
+    int status = 0;
+    waitpid(child, &status, 0);
+    expect(WIFEXITED(status) && WEXITSTATUS(status) == 0, "forked child reports its own id");
+    expect(Log::threadId() == kernelId() + ":main", "parent keeps its prefix");
+
+    SinkRegistry::instance()->remove("capture-thread");
+    std::cout << "thread name failures: " << failures << std::endl;
+    return failures == 0 ? 0 : 1;
+}
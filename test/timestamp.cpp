@@ -0,0 +1,72 @@
+// MIT License
+//
+// Copyright (c) 2023 Salomon Lee
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+#include <util/Date.hpp>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <iostream>
+
+static std::string reference(const timespec &ts) {
+    tm now{};
+    localtime_r(&ts.tv_sec, &now);
+    char date[64];
+    strftime(date, sizeof(date), "%Y-%m-%d %H:%M:%S", &now);
+    char usec[24];
+    snprintf(usec, sizeof(usec), ".%06ld", ts.tv_nsec / 1000);
+    char zone[32];
+    strftime(zone, sizeof(zone), " %Z ", &now);
+    return std::string(date) + usec + zone;
+}
+
+static int check(const timespec &ts) {
+    char buffer[Date::FORMAT_SIZE];
+    std::string formatted(buffer, Date::format(ts, buffer));
+    std::string expected = reference(ts);
+    if (formatted == expected)
+        return 0;
+    std::cerr << "mismatch for " << ts.tv_sec << "." << ts.tv_nsec << ": '" << formatted << "' != '" << expected << "'" << std::endl;
+    return 1;
+}
+
+int main() {
+    int failures = 0;
+    const char *zones[] = {"UTC0", "America/New_York", "Asia/Kolkata", "Australia/Lord_Howe"};
+    for (const char *zone : zones) {
+        setenv("TZ", zone, 1);
+        tzset();
+        // Walk across second, minute, day and DST boundaries, hitting and missing the per second cache.
+        timespec ts{1710050000, 0};
+        for (int i = 0; i < 200000; i++) {
+            ts.tv_nsec = (i * 7919L * 1000L + 999L) % 1000000000L;
+            if (i % 3 == 0)
+                ts.tv_sec += 1 + (i % 4099);
+            failures += check(ts);
+        }
+        failures += check(timespec{0, 0});
+        failures += check(timespec{4102444799, 999999999});
+        failures += check(Date::now());
+    }
+    std::cout << "timestamp mismatches against strftime: " << failures << std::endl;
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,80 @@
+// MIT License
+//
+// Copyright (c) 2023 Salomon Lee
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+#include <util/fio/LogAppender.hpp>
+#include <util/fio/LogArchiver.hpp>
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+/**
+ * Lines written through io=uring across several rollovers must come back complete and in order
+ * from the rolled segments followed by the active file.
+ */
+int main() {
+    if (!UringWriter::available()) {
+        std::cout << "io_uring not available here, skipped" << std::endl;
+        return 0;
+    }
+    const std::string dir = "./test-uring";
+    std::filesystem::remove_all(dir);
+    std::filesystem::create_directories(dir);
+    LogAppender *appender = LogAppender::instance(dir + "/uring.log");
+    appender->configure(256 * 1024, 1000, dir, flush_bytes, 16 * 1024, 1000, codec_none, -1);
+    appender->configureIo(true, 4, 64 * 1024, 5);
+
+    const long lines = 50000;
+    std::string line;
+    for (long i = 0; i < lines; i++) {
+        line = "line " + std::to_string(i) + " ................................................\n";
+        appender->write(line, i % 10000 == 0 ? log_error : log_info);
+    }
+    appender->flush();
+    LogArchiver::instance()->wait();
+
+    std::vector<std::string> files;
+    for (auto &entry : std::filesystem::directory_iterator(dir))
+        if (entry.path().filename() != "uring.log")
+            files.push_back(entry.path().string());
+    std::sort(files.begin(), files.end());
+    files.push_back(dir + "/uring.log");
+
+    long expected = 0;
+    int failures = 0;
+    for (const std::string &file : files) {
+        std::ifstream in(file);
+        while (std::getline(in, line)) {
+            if (line != "line " + std::to_string(expected) + " ................................................") {
+                if (failures++ < 5)
+                    std::cerr << file << ": expected line " << expected << ", got '" << line << "'" << std::endl;
+            }
+            expected++;
+        }
+    }
+    std::cout << "uring lines read back: " << expected << " of " << lines << " from " << files.size() << " files"
+              << std::endl;
+    return failures == 0 && expected == lines && files.size() > 1 ? 0 : 1;
+}
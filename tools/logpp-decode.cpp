@@ -0,0 +1,52 @@
+// MIT License
+//
+// Copyright (c) 2023 Salomon Lee
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+#include <util/logging/BinaryLogReader.hpp>
+#include <iostream>
+
+/**
+ * logpp-decode <binary log>... renders binary log files (the active .bin file or a rolled .bin.gz
+ * archive) as text on standard output.
+ */
+int main(int argc, char **argv) {
+    if (argc < 2) {
+        std::cerr << "usage: " << argv[0] << " <file.bin[.gz]>..." << std::endl;
+        return 2;
+    }
+    int status = 0;
+    std::string line;
+    for (int i = 1; i < argc; i++) {
+        BinaryLogReader reader(argv[i]);
+        if (!reader.isOpen()) {
+            status = 1;
+            continue;
+        }
+        while (reader.next(line))
+            std::cout.write(line.data(), static_cast<std::streamsize>(line.size()));
+        if (reader.isCorrupt()) {
+            std::cerr << argv[i] << ": stopped after " << reader.getRecords() << " records, damaged frame" << std::endl;
+            status = 1;
+        }
+    }
+    return status;
+}
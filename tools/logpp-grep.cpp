@@ -0,0 +1,434 @@
+// MIT License
+//
+// Copyright (c) 2023 Salomon Lee
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+
+#include <util/LogUtil.hpp>
+#include <util/fio/LogArchiver.hpp>
+#include <util/fio/SegmentReader.hpp>
+#include <util/logging/Log.hpp>
+#include <algorithm>
+#include <cctype>
+#include <charconv>
+#include <climits>
+#include <condition_variable>
+#include <cstring>
+#include <ctime>
+#include <deque>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <queue>
+#include <string>
+#include <thread>
+#include <vector>
+
+/**
+ * logpp-grep [options] <pattern> <log file>... searches log files together with their rolled
+ * segments, compressed or not, and prints the matching lines merged in timestamp order.
+ *
+ *   -i             ignore ASCII case
+ *   -l <levels>    only these levels, e.g. -l error,warning
+ *   -s <time>      only lines at or after time: epoch seconds or microseconds, or local
+ *                  "YYYY-MM-DD[ HH:MM[:SS[.ffffff]]]"
+ *   -u <time>      only lines before time
+ *   -j <threads>   segments searched at once, the number of cores by default
+ *   -H             prefix every line with the segment it came from
+ *   -n             search the named files only, not their rolled segments
+ *
+ * Lines without a record head, the continuations of a multi-line message, go with the record
+ * they belong to. An empty pattern matches every line. Matches are printed while the search runs,
+ * merged from a bounded queue per segment. Lines of one segment are put in time order a chunk of
+ * it at a time, so lines written more than a chunk out of order keep the order they were written.
+ */
+struct Options {
+    std::string pattern;
+    bool ignoreCase{false};
+    unsigned levels{~0u};
+    long since{LONG_MIN};
+    long until{LONG_MAX};
+    unsigned threads{0};
+    bool fileNames{false};
+    bool rolled{true};
+    std::vector<std::string> files;
+};
+
+struct Match {
+    long micros;
+    std::string line;
+};
+
+/**
+ * Level and time of the record a line belongs to, carried across lines and chunks.
+ */
+struct Head {
+    Level level{log_verbose};
+    long micros{LONG_MIN};
+};
+
+/**
+ * A segment searched a chunk at a time, so that a worker can leave it once its queue is full: the
+ * merge needs the next match of every segment before it prints anything, and a worker blocked on a
+ * full queue could otherwise hold up the one segment the merge waits for.
+ */
+struct Search {
+    std::string file;
+    std::unique_ptr<SegmentReader> reader;
+    std::string buffer;
+    size_t kept{0};
+    Head carried;
+    // Guarded by the mutex of the merge.
+    std::deque<Match> queue;
+    size_t queued{0};
+    bool busy{false};
+    bool done{false};
+};
+
+static constexpr size_t CHUNK_SIZE = 1024 * 1024;
+
+/**
+ * Bytes of matched lines a segment may have waiting for the merge before its search pauses.
+ */
+static constexpr size_t QUEUE_SIZE = 4 * CHUNK_SIZE;
+
+static bool parseLevels(std::string_view list, unsigned &levels) {
+    levels = 0;
+    while (!list.empty()) {
+        size_t comma = list.find(',');
+        std::string name(list.substr(0, comma));
+        std::transform(name.begin(), name.end(), name.begin(), [](unsigned char c) { return std::toupper(c); });
+        bool known = false;
+        for (Level l : {log_info, log_trace, log_error, log_debug, log_warning, log_verbose}) {
+            if (Log::nameOf(l) == name || (l == log_verbose && name == "VERBOSE") || (l == log_warning && name == "WARN")) {
+                levels |= 1u << l;
+                known = true;
+            }
+        }
+        if (!known)
+            return false;
+        list = comma == std::string_view::npos ? std::string_view() : list.substr(comma + 1);
+    }
+    return levels != 0;
+}
+
+/**
+ * Epoch seconds or microseconds, or a local date and time as the log lines print it.
+ */
+static bool parseTime(const std::string &text, long &micros) {
+    long number = 0;
+    auto [end, error] = std::from_chars(text.data(), text.data() + text.size(), number);
+    if (error == std::errc() && end == text.data() + text.size()) {
+        micros = text.size() <= 10 ? number * 1000000L : number;
+        return true;
+    }
+    std::tm tm{};
+    const char *rest = nullptr;
+    for (const char *format : {"%Y-%m-%d %H:%M:%S", "%Y-%m-%dT%H:%M:%S", "%Y-%m-%d %H:%M", "%Y-%m-%dT%H:%M", "%Y-%m-%d"}) {
+        tm = std::tm{};
+        rest = strptime(text.c_str(), format, &tm);
+        if (rest != nullptr)
+            break;
+    }
+    if (rest == nullptr)
+        return false;
+    long fraction = 0;
+    if (*rest == '.') {
+        long scale = 100000;
+        for (rest++; *rest >= '0' && *rest <= '9'; rest++, scale /= 10)
+            fraction += (*rest - '0') * scale;
+    }
+    if (*rest != '\0')
+        return false;
+    tm.tm_isdst = -1;
+    time_t seconds = std::mktime(&tm);
+    micros = static_cast<long>(seconds) * 1000000L + fraction;
+    return seconds != -1;
+}
+
+static bool parseArguments(int argc, char **argv, Options &options) {
+    int i = 1;
+    for (; i < argc && argv[i][0] == '-' && argv[i][1] != '\0'; i++) {
+        std::string_view flag = argv[i];
+        if (flag == "--") {
+            i++;
+            break;
+        }
+        if (flag == "-i") {
+            options.ignoreCase = true;
+        } else if (flag == "-H") {
+            options.fileNames = true;
+        } else if (flag == "-n") {
+            options.rolled = false;
+        } else if (i + 1 < argc && flag == "-l") {
+            if (!parseLevels(argv[++i], options.levels)) {
+                std::cerr << "unknown level in " << argv[i] << std::endl;
+                return false;
+            }
+        } else if (i + 1 < argc && (flag == "-s" || flag == "-u")) {
+            if (!parseTime(argv[++i], flag == "-s" ? options.since : options.until)) {
+                std::cerr << "unknown time " << argv[i] << std::endl;
+                return false;
+            }
+        } else if (i + 1 < argc && flag == "-j") {
+            options.threads = static_cast<unsigned>(std::max(1, std::atoi(argv[++i])));
+        } else {
+            std::cerr << "unknown option " << flag << std::endl;
+            return false;
+        }
+    }
+    if (i + 1 >= argc)
+        return false;
+    options.pattern = argv[i++];
+    for (; i < argc; i++)
+        options.files.emplace_back(argv[i]);
+    return true;
+}
+
+/**
+ * The named files with the rolled segments of each in front of it, oldest first, so that lines
+ * with the same timestamp keep the order they were written in.
+ */
+static std::vector<std::string> segmentsOf(const Options &options) {
+    std::vector<std::string> segments;
+    for (const std::string &file : options.files) {
+        if (options.rolled)
+            for (std::string &segment : LogArchiver::segmentsOf(file))
+                if (std::find(segments.begin(), segments.end(), segment) == segments.end())
+                    segments.push_back(std::move(segment));
+        if (std::find(segments.begin(), segments.end(), file) == segments.end())
+            segments.push_back(file);
+    }
+    return segments;
+}
+
+/**
+ * Rollover time in the name of a rolled segment, no line in it is newer. LONG_MAX for anything
+ * else.
+ */
+static long rolledAt(const std::string &segment) {
+    std::string name = LogUtil::getFilename(segment);
+    size_t dash = name.rfind('-');
+    long micros = 0;
+    if (dash == std::string::npos)
+        return LONG_MAX;
+    auto [end, error] = std::from_chars(name.data() + dash + 1, name.data() + name.size(), micros);
+    return error == std::errc() && end != name.data() + dash + 1 && *end == '.' ? micros : LONG_MAX;
+}
+
+/**
+ * Head of the record line belongs to: its own, or the one of the nearest record line above it in
+ * text, or carried over from the previous chunk.
+ */
+static Head headOf(std::string_view text, size_t line, const Head &carried) {
+    Head head;
+    for (;;) {
+        size_t end = text.find('\n', line);
+        if (Log::parseHead(text.substr(line, end == std::string_view::npos ? end : end - line), head.level, head.micros))
+            return head;
+        if (line == 0)
+            return carried;
+        size_t previous = line >= 2 ? text.rfind('\n', line - 2) : std::string_view::npos;
+        line = previous == std::string_view::npos ? 0 : previous + 1;
+    }
+}
+
+static bool accepts(const Options &options, const Head &head) {
+    if (head.micros == LONG_MIN)
+        return options.levels == ~0u && options.since == LONG_MIN && options.until == LONG_MAX;
+    return (options.levels & (1u << head.level)) && head.micros >= options.since && head.micros < options.until;
+}
+
+/**
+ * Matches of the whole lines in text. The pattern is searched over the chunk rather than line by
+ * line, so only lines with a hit are ever looked at.
+ */
+static void searchChunk(const Options &options, std::string_view text, Head &carried, std::vector<Match> &matches) {
+    size_t from = 0;
+    while (from < text.size()) {
+        size_t hit = LogUtil::findLiteral(text, options.pattern, options.ignoreCase, from);
+        if (hit == std::string_view::npos)
+            break;
+        size_t start = hit == 0 ? std::string_view::npos : text.rfind('\n', hit - 1);
+        start = start == std::string_view::npos ? 0 : start + 1;
+        size_t end = text.find('\n', hit);
+        end = end == std::string_view::npos ? text.size() : end;
+        Head head = headOf(text, start, carried);
+        if (accepts(options, head))
+            matches.push_back(Match{head.micros, std::string(text.substr(start, end - start))});
+        from = end + 1;
+    }
+    if (!text.empty())
+        carried = headOf(text, text.find_last_of('\n', text.size() - 2) + 1, carried);
+}
+
+/**
+ * Searches the next chunk of search into matches. False once the segment is exhausted, with error
+ * set when it could not be opened or stopped at a damaged frame.
+ */
+static bool searchStep(const Options &options, Search &search, std::vector<Match> &matches, bool &error) {
+    if (search.reader == nullptr) {
+        search.reader = std::make_unique<SegmentReader>(search.file);
+        if (!search.reader->isOpen()) {
+            error = true;
+            return false;
+        }
+        search.buffer.assign(CHUNK_SIZE, '\0');
+    }
+    std::string &buffer = search.buffer;
+    if (search.kept == buffer.size())
+        buffer.resize(buffer.size() * 2);
+    size_t n = search.reader->read(buffer.data() + search.kept, buffer.size() - search.kept);
+    size_t filled = search.kept + n;
+    // Whole lines only; the partial last line waits for the next read, unless the segment ended.
+    size_t cut = filled;
+    if (n > 0) {
+        cut = std::string_view(buffer.data(), filled).rfind('\n');
+        cut = cut == std::string_view::npos ? 0 : cut + 1;
+    }
+    size_t first = matches.size();
+    searchChunk(options, std::string_view(buffer.data(), cut), search.carried, matches);
+    // Threads stamp their records before they queue them, so a segment is only nearly in time order.
+    std::stable_sort(matches.begin() + static_cast<long>(first), matches.end(),
+                     [](const Match &a, const Match &b) { return a.micros < b.micros; });
+    search.kept = filled - cut;
+    std::memmove(buffer.data(), buffer.data() + cut, search.kept);
+    if (n > 0)
+        return true;
+    if (search.reader->hasError()) {
+        std::cerr << search.file << ": stopped at a damaged frame" << std::endl;
+        error = true;
+    }
+    return false;
+}
+
+int main(int argc, char **argv) {
+    Options options;
+    if (!parseArguments(argc, argv, options)) {
+        std::cerr << "usage: " << argv[0]
+                  << " [-i] [-H] [-n] [-l levels] [-s time] [-u time] [-j threads] <pattern> <log file>..." << std::endl;
+        return 2;
+    }
+    std::vector<std::string> segments = segmentsOf(options);
+    std::vector<Search> searches(segments.size());
+    std::mutex mutex;
+    std::condition_variable ready;
+    std::condition_variable space;
+    size_t open = 0;
+    bool failed = false;
+    for (size_t i = 0; i < segments.size(); i++) {
+        searches[i].file = segments[i];
+        // A rolled segment holds nothing newer than its rollover.
+        searches[i].done = rolledAt(segments[i]) < options.since;
+        open += searches[i].done ? 0 : 1;
+    }
+
+    // Segments the merge is waiting for, with an empty queue, go first.
+    auto pick = [&]() -> Search * {
+        Search *best = nullptr;
+        for (Search &search : searches)
+            if (!search.done && !search.busy && search.queued < QUEUE_SIZE &&
+                (best == nullptr || (search.queue.empty() && !best->queue.empty())))
+                best = &search;
+        return best;
+    };
+    auto work = [&]() {
+        std::vector<Match> matches;
+        std::unique_lock<std::mutex> lock(mutex);
+        for (;;) {
+            Search *search = nullptr;
+            space.wait(lock, [&]() { return open == 0 || (search = pick()) != nullptr; });
+            if (search == nullptr)
+                return;
+            search->busy = true;
+            lock.unlock();
+            bool error = false;
+            bool more = searchStep(options, *search, matches, error);
+            if (!more) {
+                search->reader.reset();
+                search->buffer = std::string();
+            }
+            lock.lock();
+            for (Match &match : matches) {
+                search->queued += match.line.size();
+                search->queue.push_back(std::move(match));
+            }
+            matches.clear();
+            search->busy = false;
+            failed = failed || error;
+            if (!more) {
+                search->done = true;
+                open--;
+                space.notify_all();
+            } else {
+                space.notify_one();
+            }
+            ready.notify_one();
+        }
+    };
+    unsigned threads = options.threads > 0 ? options.threads : std::max(1u, std::thread::hardware_concurrency());
+    std::vector<std::thread> workers;
+    for (unsigned t = 0; t < std::max<size_t>(1, std::min<size_t>(threads, open)); t++)
+        workers.emplace_back(work);
+
+    // Takes over the queue of segment i once the merge used up what it took before, false when the
+    // segment has no matches left.
+    std::vector<std::deque<Match>> taken(searches.size());
+    auto refill = [&](size_t i) {
+        std::unique_lock<std::mutex> lock(mutex);
+        ready.wait(lock, [&]() { return !searches[i].queue.empty() || searches[i].done; });
+        if (searches[i].queue.empty())
+            return false;
+        taken[i].swap(searches[i].queue);
+        searches[i].queued = 0;
+        space.notify_all();
+        return true;
+    };
+    // Next match of every segment by time, the older segment first for the same time.
+    using Next = std::pair<long, size_t>;
+    std::priority_queue<Next, std::vector<Next>, std::greater<Next>> next;
+    for (size_t i = 0; i < searches.size(); i++)
+        if (refill(i))
+            next.emplace(taken[i].front().micros, i);
+    bool matched = false;
+    std::string out;
+    while (!next.empty()) {
+        size_t i = next.top().second;
+        next.pop();
+        if (options.fileNames)
+            out.append(segments[i]).append(":");
+        out.append(taken[i].front().line).append("\n");
+        taken[i].pop_front();
+        matched = true;
+        if (out.size() >= CHUNK_SIZE) {
+            std::cout.write(out.data(), static_cast<std::streamsize>(out.size()));
+            out.clear();
+        }
+        if (!taken[i].empty() || refill(i))
+            next.emplace(taken[i].front().micros, i);
+    }
+    std::cout.write(out.data(), static_cast<std::streamsize>(out.size()));
+    std::cout.flush();
+    for (std::thread &worker : workers)
+        worker.join();
+    return failed ? 2 : matched ? 0 : 1;
+}